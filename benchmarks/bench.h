@@ -0,0 +1,54 @@
+/* Helpers shared by the benchmarks of the changes to the open62541
+ * amalgamation.
+ *
+ * Every benchmark includes open62541.c itself instead of linking it. So it can
+ * use the internal functions (timer, nodestore, codecs) and is compiled with
+ * the feature options of its own target. */
+
+#ifndef AQW_BENCH_H_
+#define AQW_BENCH_H_
+
+#include "open62541.c"
+
+#include <stdio.h>
+
+/* Number of runs of a measurement, the best one is reported */
+#define BENCH_RUNS 5
+
+typedef void (*BenchFunction)(void *context);
+
+/* Seconds of monotonic time */
+static UA_INLINE double
+Bench_now(void) {
+    return (double)UA_DateTime_nowMonotonic() / UA_DATETIME_SEC;
+}
+
+/* Best time of BENCH_RUNS runs of the function in seconds */
+static UA_INLINE double
+Bench_best(BenchFunction function, void *context) {
+    double best = 0.0;
+    for(size_t i = 0; i < BENCH_RUNS; ++i) {
+        double start = Bench_now();
+        function(context);
+        double elapsed = Bench_now() - start;
+        if(i == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+/* Print one result line: total time and time per operation */
+static UA_INLINE void
+Bench_report(const char *name, double seconds, size_t operations) {
+    printf("%-44s %10.3f ms %10.1f ns/op\n", name, seconds * 1e3,
+           operations > 0 ? seconds * 1e9 / (double)operations : 0.0);
+}
+
+/* The benchmarks would otherwise measure the console */
+static UA_INLINE void
+Bench_quietLogger(UA_LogLevel level, UA_LogCategory category,
+                  const char *msg, va_list args) {
+    (void)level; (void)category; (void)msg; (void)args;
+}
+
+#endif /* AQW_BENCH_H_ */
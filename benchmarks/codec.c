@@ -0,0 +1,208 @@
+/* Binary codec: encoding of the responses and decoding of the requests of the
+ * hot services. Built as bench-codec (specialised codecs) and
+ * bench-codec-generic (UA_ENABLE_SPECIALISED_CODECS undefined), so both run
+ * on the same messages. */
+
+#include "bench.h"
+
+#define ITEMS 5000
+
+typedef struct {
+    const void *message;
+    const UA_DataType *type;
+    UA_ByteString encoded;
+} CodecBench;
+
+static void
+encodeMessage(void *context) {
+    CodecBench *b = (CodecBench*)context;
+    UA_Byte *pos = b->encoded.data;
+    const UA_Byte *end = &b->encoded.data[b->encoded.length];
+    UA_StatusCode retval = UA_encodeBinary(b->message, b->type, &pos, &end, NULL, NULL);
+    if(retval != UA_STATUSCODE_GOOD)
+        printf("Encoding failed: %s\n", UA_StatusCode_name(retval));
+}
+
+static void
+decodeMessage(void *context) {
+    CodecBench *b = (CodecBench*)context;
+    void *dst = UA_new(b->type);
+    size_t offset = 0;
+    UA_StatusCode retval = UA_decodeBinary(&b->encoded, &offset, dst, b->type, 0, NULL);
+    if(retval != UA_STATUSCODE_GOOD)
+        printf("Decoding failed: %s\n", UA_StatusCode_name(retval));
+    UA_delete(dst, b->type);
+}
+
+/* Encode the message once into a buffer of the exact size */
+static void
+prepare(CodecBench *b, const void *message, const UA_DataType *type) {
+    b->message = message;
+    b->type = type;
+    UA_ByteString_allocBuffer(&b->encoded, UA_calcSizeBinary((void*)(uintptr_t)message, type));
+    encodeMessage(b);
+}
+
+static void
+benchEncode(const char *name, const void *message, const UA_DataType *type) {
+    CodecBench b;
+    prepare(&b, message, type);
+    Bench_report(name, Bench_best(encodeMessage, &b), ITEMS);
+    UA_ByteString_deleteMembers(&b.encoded);
+}
+
+static void
+benchDecode(const char *name, const void *message, const UA_DataType *type) {
+    CodecBench b;
+    prepare(&b, message, type);
+    Bench_report(name, Bench_best(decodeMessage, &b), ITEMS);
+    UA_ByteString_deleteMembers(&b.encoded);
+}
+
+static UA_NodeId
+variableId(size_t i, UA_Boolean numeric) {
+    if(numeric)
+        return UA_NODEID_NUMERIC(1, (UA_UInt32)(100000 + i));
+    char name[64];
+    snprintf(name, sizeof(name), "Countries.US.Location %u.Temperature", (unsigned)i);
+    return UA_NODEID_STRING_ALLOC(1, name);
+}
+
+static void
+setValue(UA_DataValue *dv, size_t i, UA_Boolean string) {
+    if(string) {
+        UA_String summary = UA_STRING("Partly cloudy");
+        UA_Variant_setScalarCopy(&dv->value, &summary, &UA_TYPES[UA_TYPES_STRING]);
+    } else {
+        UA_Double temperature = 20.0 + (UA_Double)(i % 100) / 10.0;
+        UA_Variant_setScalarCopy(&dv->value, &temperature, &UA_TYPES[UA_TYPES_DOUBLE]);
+    }
+    dv->hasValue = true;
+    dv->sourceTimestamp = UA_DateTime_now();
+    dv->hasSourceTimestamp = true;
+    dv->serverTimestamp = dv->sourceTimestamp;
+    dv->hasServerTimestamp = true;
+}
+
+static void
+readResponse(UA_ReadResponse *response, UA_Boolean string) {
+    UA_ReadResponse_init(response);
+    response->results = (UA_DataValue*)UA_Array_new(ITEMS, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    response->resultsSize = ITEMS;
+    for(size_t i = 0; i < ITEMS; ++i)
+        setValue(&response->results[i], i, string);
+}
+
+static void
+publishResponse(UA_PublishResponse *response) {
+    UA_PublishResponse_init(response);
+    UA_DataChangeNotification *dcn = UA_DataChangeNotification_new();
+    dcn->monitoredItems = (UA_MonitoredItemNotification*)
+        UA_Array_new(ITEMS, &UA_TYPES[UA_TYPES_MONITOREDITEMNOTIFICATION]);
+    dcn->monitoredItemsSize = ITEMS;
+    for(size_t i = 0; i < ITEMS; ++i) {
+        dcn->monitoredItems[i].clientHandle = (UA_UInt32)i;
+        setValue(&dcn->monitoredItems[i].value, i, false);
+    }
+    response->subscriptionId = 1;
+    response->notificationMessage.sequenceNumber = 1;
+    response->notificationMessage.publishTime = UA_DateTime_now();
+    response->notificationMessage.notificationData = UA_ExtensionObject_new();
+    response->notificationMessage.notificationDataSize = 1;
+    response->notificationMessage.notificationData->encoding = UA_EXTENSIONOBJECT_DECODED;
+    response->notificationMessage.notificationData->content.decoded.type =
+        &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION];
+    response->notificationMessage.notificationData->content.decoded.data = dcn;
+}
+
+static void
+browseResponse(UA_BrowseResponse *response) {
+    UA_BrowseResponse_init(response);
+    UA_BrowseResult *result = UA_BrowseResult_new();
+    response->results = result;
+    response->resultsSize = 1;
+    result->references = (UA_ReferenceDescription*)
+        UA_Array_new(ITEMS, &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+    result->referencesSize = ITEMS;
+    for(size_t i = 0; i < ITEMS; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "Location %u", (unsigned)i);
+        UA_ReferenceDescription *rd = &result->references[i];
+        rd->referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+        rd->isForward = true;
+        rd->nodeId.nodeId = variableId(i, false);
+        rd->browseName = UA_QUALIFIEDNAME_ALLOC(1, name);
+        rd->displayName = UA_LOCALIZEDTEXT_ALLOC("en-US", name);
+        rd->nodeClass = UA_NODECLASS_OBJECT;
+        rd->typeDefinition.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE);
+    }
+}
+
+static void
+readRequest(UA_ReadRequest *request, UA_Boolean numeric) {
+    UA_ReadRequest_init(request);
+    request->timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    request->nodesToRead = (UA_ReadValueId*)UA_Array_new(ITEMS, &UA_TYPES[UA_TYPES_READVALUEID]);
+    request->nodesToReadSize = ITEMS;
+    for(size_t i = 0; i < ITEMS; ++i) {
+        request->nodesToRead[i].nodeId = variableId(i, numeric);
+        request->nodesToRead[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+}
+
+static void
+browseRequest(UA_BrowseRequest *request) {
+    UA_BrowseRequest_init(request);
+    request->requestedMaxReferencesPerNode = 1000;
+    request->nodesToBrowse = (UA_BrowseDescription*)
+        UA_Array_new(ITEMS, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+    request->nodesToBrowseSize = ITEMS;
+    for(size_t i = 0; i < ITEMS; ++i) {
+        UA_BrowseDescription *bd = &request->nodesToBrowse[i];
+        bd->nodeId = variableId(i, false);
+        bd->browseDirection = UA_BROWSEDIRECTION_FORWARD;
+        bd->referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+        bd->includeSubtypes = true;
+        bd->resultMask = UA_BROWSERESULTMASK_ALL;
+    }
+}
+
+int main(void) {
+#ifdef UA_ENABLE_SPECIALISED_CODECS
+    printf("Binary codec: specialised, %u items per message\n", ITEMS);
+#else
+    printf("Binary codec: generic, %u items per message\n", ITEMS);
+#endif
+
+    UA_ReadResponse readDouble, readString;
+    readResponse(&readDouble, false);
+    readResponse(&readString, true);
+    benchEncode("encode ReadResponse, Double", &readDouble, &UA_TYPES[UA_TYPES_READRESPONSE]);
+    benchEncode("encode ReadResponse, String", &readString, &UA_TYPES[UA_TYPES_READRESPONSE]);
+    UA_ReadResponse_deleteMembers(&readDouble);
+    UA_ReadResponse_deleteMembers(&readString);
+
+    UA_PublishResponse publish;
+    publishResponse(&publish);
+    benchEncode("encode PublishResponse", &publish, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
+    UA_PublishResponse_deleteMembers(&publish);
+
+    UA_BrowseResponse browse;
+    browseResponse(&browse);
+    benchEncode("encode BrowseResponse", &browse, &UA_TYPES[UA_TYPES_BROWSERESPONSE]);
+    UA_BrowseResponse_deleteMembers(&browse);
+
+    UA_ReadRequest readStringIds, readNumericIds;
+    readRequest(&readStringIds, false);
+    readRequest(&readNumericIds, true);
+    benchDecode("decode ReadRequest, string NodeIds", &readStringIds, &UA_TYPES[UA_TYPES_READREQUEST]);
+    benchDecode("decode ReadRequest, numeric NodeIds", &readNumericIds, &UA_TYPES[UA_TYPES_READREQUEST]);
+    UA_ReadRequest_deleteMembers(&readStringIds);
+    UA_ReadRequest_deleteMembers(&readNumericIds);
+
+    UA_BrowseRequest browseReq;
+    browseRequest(&browseReq);
+    benchDecode("decode BrowseRequest", &browseReq, &UA_TYPES[UA_TYPES_BROWSEREQUEST]);
+    UA_BrowseRequest_deleteMembers(&browseReq);
+    return 0;
+}
@@ -0,0 +1,72 @@
+/* NodeId hash: reads of variables with string NodeIds through the server.
+ * Built as bench-nodeid-hash (word-at-a-time hash) and bench-nodeid-hash-fnv
+ * (byte-at-a-time FNV-1a, UA_ENABLE_FAST_NODEID_HASH undefined). */
+
+#include "bench.h"
+
+#define VARIABLES 10000
+
+typedef struct {
+    UA_Server *server;
+    UA_NodeId *ids;
+} HashBench;
+
+static void
+hashIds(void *context) {
+    HashBench *b = (HashBench*)context;
+    volatile u32 sum = 0;
+    for(size_t i = 0; i < VARIABLES; ++i)
+        sum += UA_NodeId_hash(&b->ids[i]);
+}
+
+static void
+readVariables(void *context) {
+    HashBench *b = (HashBench*)context;
+    for(size_t i = 0; i < VARIABLES; ++i) {
+        UA_Variant value;
+        UA_Server_readValue(b->server, b->ids[i], &value);
+        UA_Variant_deleteMembers(&value);
+    }
+}
+
+int main(void) {
+    UA_ServerConfig *config = UA_ServerConfig_new_default();
+    config->logger = Bench_quietLogger;
+    HashBench b;
+    b.server = UA_Server_new(config);
+    b.ids = (UA_NodeId*)UA_Array_new(VARIABLES, &UA_TYPES[UA_TYPES_NODEID]);
+
+    for(size_t i = 0; i < VARIABLES; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "Countries.US.Location %u.Temperature", (unsigned)i);
+        b.ids[i] = UA_NODEID_STRING_ALLOC(1, name);
+
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UA_Double temperature = 20.0;
+        UA_Variant_setScalar(&attr.value, &temperature, &UA_TYPES[UA_TYPES_DOUBLE]);
+        UA_StatusCode retval =
+            UA_Server_addVariableNode(b.server, b.ids[i],
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                      UA_QUALIFIEDNAME(1, name),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                      attr, NULL, NULL);
+        if(retval != UA_STATUSCODE_GOOD) {
+            printf("Adding variable %u failed: %s\n", (unsigned)i, UA_StatusCode_name(retval));
+            return 1;
+        }
+    }
+
+#ifdef UA_ENABLE_FAST_NODEID_HASH
+    printf("NodeId hash: word-at-a-time, %u variables\n", VARIABLES);
+#else
+    printf("NodeId hash: FNV-1a, %u variables\n", VARIABLES);
+#endif
+    Bench_report("hash string NodeIds", Bench_best(hashIds, &b), VARIABLES);
+    Bench_report("UA_Server_readValue", Bench_best(readVariables, &b), VARIABLES);
+
+    UA_Array_delete(b.ids, VARIABLES, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_Server_delete(b.server);
+    UA_ServerConfig_delete(config);
+    return 0;
+}
@@ -0,0 +1,95 @@
+/* Default nodestore (UA_NodeMap): insertion, lookup hits and misses and
+ * removal of string NodeIds like the ones of the weather model. */
+
+#include "bench.h"
+
+#define NODES 1000000
+
+typedef struct {
+    UA_Nodestore ns;
+    UA_NodeId *ids;     /* Inserted into the nodestore */
+    UA_NodeId *missing; /* Never inserted */
+    size_t *order;      /* Random order of the lookups */
+} NodeMapBench;
+
+static UA_NodeId *
+makeIds(const char *country) {
+    UA_NodeId *ids = (UA_NodeId*)UA_Array_new(NODES, &UA_TYPES[UA_TYPES_NODEID]);
+    for(size_t i = 0; i < NODES; ++i) {
+        char name[96];
+        snprintf(name, sizeof(name), "Countries.%s.Some Location Name %u.Temperature",
+                 country, (unsigned)i);
+        ids[i] = UA_NODEID_STRING_ALLOC(1, name);
+    }
+    return ids;
+}
+
+static void
+insertNodes(NodeMapBench *b) {
+    for(size_t i = 0; i < NODES; ++i) {
+        UA_Node *node = b->ns.newNode(b->ns.context, UA_NODECLASS_VARIABLE);
+        UA_NodeId_copy(&b->ids[i], &node->nodeId);
+        b->ns.insertNode(b->ns.context, node, NULL);
+    }
+}
+
+static void
+lookupHits(void *context) {
+    NodeMapBench *b = (NodeMapBench*)context;
+    for(size_t i = 0; i < NODES; ++i) {
+        const UA_Node *node = b->ns.getNode(b->ns.context, &b->ids[b->order[i]]);
+        b->ns.releaseNode(b->ns.context, node);
+    }
+}
+
+static void
+lookupMisses(void *context) {
+    NodeMapBench *b = (NodeMapBench*)context;
+    for(size_t i = 0; i < NODES; ++i)
+        b->ns.getNode(b->ns.context, &b->missing[b->order[i]]);
+}
+
+static void
+removeNodes(NodeMapBench *b) {
+    for(size_t i = 0; i < NODES; ++i)
+        b->ns.removeNode(b->ns.context, &b->ids[b->order[i]]);
+}
+
+int main(void) {
+    NodeMapBench b;
+    UA_Nodestore_default_new(&b.ns);
+    b.ids = makeIds("XX");
+    b.missing = makeIds("YY");
+
+    /* Fisher-Yates shuffle with a fixed seed, so every run looks up the same
+     * sequence */
+    b.order = (size_t*)UA_malloc(NODES * sizeof(size_t));
+    for(size_t i = 0; i < NODES; ++i)
+        b.order[i] = i;
+    u32 state = 2463534242u;
+    for(size_t i = NODES - 1; i > 0; --i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        size_t j = state % (i + 1);
+        size_t tmp = b.order[i];
+        b.order[i] = b.order[j];
+        b.order[j] = tmp;
+    }
+
+    printf("UA_NodeMap, %u string NodeIds\n", NODES);
+    double start = Bench_now();
+    insertNodes(&b);
+    Bench_report("insert", Bench_now() - start, NODES);
+    Bench_report("random hits", Bench_best(lookupHits, &b), NODES);
+    Bench_report("misses", Bench_best(lookupMisses, &b), NODES);
+    start = Bench_now();
+    removeNodes(&b);
+    Bench_report("remove", Bench_now() - start, NODES);
+
+    UA_free(b.order);
+    UA_Array_delete(b.missing, NODES, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_Array_delete(b.ids, NODES, &UA_TYPES[UA_TYPES_NODEID]);
+    b.ns.deleteNodestore(b.ns.context);
+    return 0;
+}
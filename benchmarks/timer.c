@@ -0,0 +1,71 @@
+/* UA_Timer: adding, dispatching and removing many repeated callbacks, e.g. the
+ * sampling callbacks of monitored items. Half of the intervals are typical
+ * publishing intervals, the other half random in 5..10000 ms. 10 s are
+ * simulated in steps of 1 ms. */
+
+#include "bench.h"
+
+#define SIMULATED_MS 10000
+
+static const UA_UInt32 commonIntervals[] = {50, 100, 250, 500, 1000, 2000, 5000};
+
+static void
+emptyCallback(void *application, void *data) {
+    (void)application; (void)data;
+}
+
+static void
+countDispatch(void *application, UA_TimerCallback callback, void *data) {
+    (void)data;
+    ++*(size_t*)application;
+    callback(application, data);
+}
+
+static void
+runTimers(size_t timers) {
+    UA_Timer t;
+    UA_Timer_init(&t);
+    UA_UInt64 *ids = (UA_UInt64*)UA_malloc(timers * sizeof(UA_UInt64));
+    size_t dispatched = 0;
+    u32 state = 2463534242u;
+
+    /* Changes are applied in the next UA_Timer_process */
+    double start = Bench_now();
+    for(size_t i = 0; i < timers; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        UA_UInt32 interval = (i % 2 == 0) ?
+            commonIntervals[state % (sizeof(commonIntervals) / sizeof(UA_UInt32))] :
+            5 + state % 9996;
+        UA_Timer_addRepeatedCallback(&t, emptyCallback, NULL, interval, &ids[i]);
+    }
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    UA_Timer_process(&t, now, countDispatch, &dispatched);
+    Bench_report("add", Bench_now() - start, timers);
+
+    start = Bench_now();
+    for(size_t ms = 1; ms <= SIMULATED_MS; ++ms)
+        UA_Timer_process(&t, now + (UA_DateTime)ms * UA_DATETIME_MSEC,
+                         countDispatch, &dispatched);
+    Bench_report("process 10 s", Bench_now() - start, dispatched);
+    printf("%-44s %10u\n", "dispatched callbacks", (unsigned)dispatched);
+
+    start = Bench_now();
+    for(size_t i = 0; i < timers; ++i)
+        UA_Timer_removeRepeatedCallback(&t, ids[i]);
+    UA_Timer_process(&t, now + (UA_DateTime)(SIMULATED_MS + 1) * UA_DATETIME_MSEC,
+                     countDispatch, &dispatched);
+    Bench_report("remove all", Bench_now() - start, timers);
+
+    UA_Timer_deleteMembers(&t);
+    UA_free(ids);
+}
+
+int main(void) {
+    printf("UA_Timer, 10000 repeated callbacks\n");
+    runTimers(10000);
+    printf("UA_Timer, 100000 repeated callbacks\n");
+    runTimers(100000);
+    return 0;
+}
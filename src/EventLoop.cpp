@@ -0,0 +1,71 @@
+#include "EventLoop.h"
+
+namespace weatherserver {
+
+  EventLoop::EventLoop(WebService& webService, const UA_DataSource& weatherDataSource, const WeatherNodestore::LocationsLoader& locationsLoader)
+    : nodestore{ webService, weatherDataSource, locationsLoader } {}
+
+  EventLoop::~EventLoop() {
+    if (thread.joinable())
+      thread.join();
+    if (server)
+      UA_Server_delete(server);
+    if (config)
+      UA_ServerConfig_delete(config);
+  }
+
+  bool EventLoop::create(const Settings& settings, ModelCache* modelCache, Prefetcher* prefetcher) {
+    config = UA_ServerConfig_new_default();
+    if (!config)
+      return false;
+
+    if (!settings.hostName.empty()) {
+      UA_String ourHostName = UA_String_fromChars(settings.hostName.c_str());
+      UA_ServerConfig_set_customHostname(config, ourHostName);
+      UA_String_deleteMembers(&ourHostName);
+    }
+
+    nodestore.attach(config->nodestore);
+    nodestore.setModelCache(modelCache);
+    nodestore.setPrefetcher(prefetcher);
+
+    server = UA_Server_new(config);
+    if (!server)
+      return false;
+    return UA_Server_addRepeatedCallback(server, notifyCallback, this, 100, NULL) == UA_STATUSCODE_GOOD;
+  }
+
+  UA_StatusCode EventLoop::run(volatile UA_Boolean& running) {
+    return UA_Server_run(server, &running);
+  }
+
+  void EventLoop::start(volatile UA_Boolean& running) {
+    thread = std::thread([this, &running]() {
+      // The random number generator of open62541 is per thread: nonces and session ids must not repeat between event loops.
+      UA_random_seed(static_cast<UA_UInt64>(UA_DateTime_now()) ^ reinterpret_cast<uintptr_t>(this));
+      result = run(running);
+    });
+  }
+
+  UA_StatusCode EventLoop::join() {
+    if (thread.joinable())
+      thread.join();
+    return result;
+  }
+
+  void EventLoop::notifyWeatherChanged(const std::string& countryCode, const std::string& locationName) {
+    std::lock_guard<std::mutex> lock(changedMutex);
+    changedLocations.emplace_back(countryCode, locationName);
+  }
+
+  void EventLoop::notifyCallback(UA_Server* server, void* data) {
+    EventLoop* eventLoop = static_cast<EventLoop*>(data);
+    std::vector<std::pair<std::string, std::string>> locations;
+    {
+      std::lock_guard<std::mutex> lock(eventLoop->changedMutex);
+      locations.swap(eventLoop->changedLocations);
+    }
+    for (auto& location : locations)
+      WeatherNodestore::notifyWeatherChanged(server, location.first, location.second);
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "open62541.h"
+
+#include "Settings.h"
+#include "WebService.h"
+#include "WeatherNodestore.h"
+#include "ModelCache.h"
+#include "Prefetcher.h"
+
+namespace weatherserver {
+
+  /*
+  One OPC UA server: network layer, secure channels, sessions and subscriptions, run by a single thread.
+
+  Several event loops can run on their own threads and listen on the same port (SO_REUSEPORT). The kernel spreads incoming
+  connections between them, a connection and its session stay with the event loop that accepted it. The weather part of the
+  information model is shared by the nodestores of all event loops, and so is namespace 0 unless a server changes a node of it
+  (UA_Nodestore_default_shareNS0). The rest of the address space is built for every server.
+  */
+  class EventLoop {
+
+  public:
+
+    EventLoop(WebService& webService, const UA_DataSource& weatherDataSource, const WeatherNodestore::LocationsLoader& locationsLoader);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /*
+    Create the server configuration and the server.
+
+    @return false if the server could not be created.
+    */
+    bool create(const Settings& settings, ModelCache* modelCache, Prefetcher* prefetcher);
+
+    UA_Server* getServer() { return server; }
+    WeatherNodestore& getNodestore() { return nodestore; }
+
+    //Run the server on the calling thread until running is set to false.
+    UA_StatusCode run(volatile UA_Boolean& running);
+
+    //Run the server on a new thread until running is set to false.
+    void start(volatile UA_Boolean& running);
+
+    //Wait for the thread started by start() and return the result of the server.
+    UA_StatusCode join();
+
+    /*
+    Push the new weather data of the location to the MonitoredItems of this server. Can be called from any thread,
+    the notification is done by a repeated callback of the server.
+    */
+    void notifyWeatherChanged(const std::string& countryCode, const std::string& locationName);
+
+  private:
+
+    static void notifyCallback(UA_Server* server, void* data);
+
+    WeatherNodestore nodestore;
+    UA_ServerConfig* config{ nullptr };
+    UA_Server* server{ nullptr };
+    std::thread thread;
+    UA_StatusCode result{ UA_STATUSCODE_GOOD };
+
+    //Locations (country code, location name) with new weather data, not notified yet.
+    std::mutex changedMutex;
+    std::vector<std::pair<std::string, std::string>> changedLocations;
+  };
+}
@@ -14,15 +14,14 @@ namespace weatherserver {
   char LocationData::BROWSE_FLAG_INITIALIZE[] = "FlagInitialize";
 
   LocationData::LocationData(std::string name, std::string city, std::string countryCode, double latitude, double longitude,
-    bool hasBeenReceivedWeatherData, bool isInitialized, bool isAddingWeatherToAddressSpace)
+    bool hasBeenReceivedWeatherData, bool isInitialized)
     : name { name },
       city { city },
       countryCode { countryCode },
       latitude { latitude },
       longitude { longitude },
       hasBeenReceivedWeatherData { hasBeenReceivedWeatherData },
-      isInitialized { isInitialized },
-      isAddingWeatherToAddressSpace { isAddingWeatherToAddressSpace }
+      isInitialized { isInitialized }
   {
     readLastTime = std::chrono::system_clock::now();
   }
@@ -30,7 +29,6 @@ namespace weatherserver {
   LocationData::LocationData()
     : isInitialized(false),
       hasBeenReceivedWeatherData(false),
-      isAddingWeatherToAddressSpace(false),
       latitude(INVALID_LATITUDE),
       longitude(INVALID_LONGITUDE) {}
 
@@ -96,10 +94,6 @@ namespace weatherserver {
     isInitialized = initialized;
   }
 
-  void LocationData::setIsAddingWeatherToAddressSpace(const bool addingWeatherToAddressSpace) {
-    isAddingWeatherToAddressSpace = addingWeatherToAddressSpace;
-  }
-
   void LocationData::setWeatherData(const WeatherData& weather) {
     weatherData = weather;
   }
@@ -32,7 +32,7 @@ namespace weatherserver {
     LocationData();
 
     LocationData(std::string name, std::string city, std::string countryCode, double latitude, double longitude,
-      bool hasBeenReceivedWeatherData = false, bool isInitialized = false, bool isAddingWeatherToAddressSpace = false);
+      bool hasBeenReceivedWeatherData = false, bool isInitialized = false);
 
     /*
     Gets JSON value AS AN OBJECT and parses it to a new LocationData object.
@@ -56,9 +56,6 @@ namespace weatherserver {
     //Identifies that this object has received weather data for the first time.
     void setHasBeenReceivedWeatherData(const bool received);
 
-    //Identifies that weather data variable nodes are currently being added to the OPC UA information model.
-    void setIsAddingWeatherToAddressSpace(const bool addingWeatherToAddressSpace);
-
     void setWeatherData(const WeatherData& weather);
     void setReadLastTime(const std::chrono::system_clock::time_point& time);
 
@@ -70,7 +67,6 @@ namespace weatherserver {
 
     bool getIsInitialized() const { return isInitialized; }
     bool getHasBeenReceivedWeatherData() const { return hasBeenReceivedWeatherData; }
-    bool getIsAddingWeatherToAddressSpace() const { return isAddingWeatherToAddressSpace; }
     WeatherData& getWeatherData() { return weatherData; }
     std::chrono::system_clock::time_point getReadLastTime() const { return readLastTime; }
 
@@ -97,7 +93,6 @@ namespace weatherserver {
     double longitude;
     bool hasBeenReceivedWeatherData;
     bool isInitialized;
-    bool isAddingWeatherToAddressSpace;
     WeatherData weatherData;
     std::chrono::system_clock::time_point readLastTime;
   };
@@ -0,0 +1,168 @@
+#include "ModelBuilder.h"
+
+namespace weatherserver {
+
+  ModelBuilder::ModelBuilder(WebService& webService)
+    : webService{ webService },
+      completed{ std::make_shared<CompletedQueue>() } {}
+
+  void ModelBuilder::requestLocations(CountryData& country) {
+    const std::string& countryCode = country.getCode();
+    {
+      std::lock_guard<std::mutex> lock(pendingMutex);
+      if (!pendingCountries.insert(countryCode).second)
+        return;
+    }
+
+    std::cout << "Downloading locations for country " << countryCode << " (" << country.getName() << ")" << std::endl;
+
+    std::shared_ptr<CompletedQueue> queue = completed;
+    webService.fetchAllLocations(countryCode, country.getLocationsNumber())
+      .then([queue, countryCode](pplx::task<web::json::value> previousTask)
+        {
+          CompletedLocations result;
+          result.countryCode = countryCode;
+          try {
+            web::json::value response = previousTask.get();
+            result.locations = LocationData::parseJsonArray(response);
+          }
+          catch (const std::exception & e) {
+            UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_NETWORK, "Error on fetchAllLocations method: [%s]", e.what());
+          }
+
+          std::lock_guard<std::mutex> lock(queue->mutex);
+          queue->locations.push_back(std::move(result));
+        });
+  }
+
+  void ModelBuilder::requestWeather(LocationData& location) {
+    std::string locationKey = location.getCountryCode() + "." + location.getName();
+    {
+      std::lock_guard<std::mutex> lock(pendingMutex);
+      if (!pendingWeather.insert(locationKey).second)
+        return;
+    }
+
+    std::shared_ptr<CompletedQueue> queue = completed;
+    std::string countryCode = location.getCountryCode();
+    std::string locationName = location.getName();
+    webService.fetchWeather(location.getLatitude(), location.getLongitude())
+      .then([queue, countryCode, locationName](pplx::task<web::json::value> previousTask)
+        {
+          CompletedWeather result;
+          result.countryCode = countryCode;
+          result.locationName = locationName;
+          result.succeeded = false;
+          try {
+            web::json::value response = previousTask.get();
+            result.weather = WeatherData::parseJson(response);
+            result.receivedTime = std::chrono::system_clock::now();
+            result.succeeded = true;
+          }
+          catch (const std::exception & e) {
+            UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_NETWORK, "Error on fetchWeather method: [%s]", e.what());
+          }
+
+          std::lock_guard<std::mutex> lock(queue->mutex);
+          queue->weather.push_back(std::move(result));
+        });
+  }
+
+  void ModelBuilder::applyCompleted() {
+    std::vector<CompletedLocations> completedLocations;
+    std::vector<CompletedWeather> completedWeather;
+    {
+      std::lock_guard<std::mutex> lock(completed->mutex);
+      completedLocations.swap(completed->locations);
+      completedWeather.swap(completed->weather);
+    }
+    if (completedLocations.empty() && completedWeather.empty())
+      return;
+
+    std::unique_lock<std::shared_timed_mutex> modelLock(webService.getModelMutex());
+    std::unique_lock<std::mutex> pendingLock(pendingMutex);
+    for (auto& result : completedLocations)
+      pendingCountries.erase(result.countryCode);
+    for (auto& result : completedWeather)
+      pendingWeather.erase(result.countryCode + "." + result.locationName);
+    pendingLock.unlock();
+
+    auto& countries = webService.getAllCountries();
+
+    for (auto& result : completedLocations) {
+      auto itCountry = countries.find(result.countryCode);
+      if (itCountry == countries.end())
+        continue;
+      applyLocations(itCountry->second, result.locations);
+      if (modelCache && !itCountry->second.getLocations().empty())
+        modelCache->touchCountry(itCountry->second);
+    }
+
+    for (auto& result : completedWeather) {
+      if (!result.succeeded)
+        continue;
+
+      // The location could have been evicted from the data model while the download was in progress.
+      auto itCountry = countries.find(result.countryCode);
+      if (itCountry == countries.end())
+        continue;
+      auto& locations = itCountry->second.getLocations();
+      auto itLocation = locations.find(result.locationName);
+      if (itLocation == locations.end())
+        continue;
+
+      itLocation->second.setWeatherData(result.weather);
+      itLocation->second.setHasBeenReceivedWeatherData(true);
+      itLocation->second.setReadLastTime(result.receivedTime);
+      if (modelCache)
+        modelCache->touchLocation(itLocation->second);
+      if (weatherListener)
+        weatherListener(itLocation->second);
+    }
+  }
+
+  /*
+  Locations downloaded from Open AQ API are merged with the locations of the country from the settings file.
+  */
+  void ModelBuilder::applyLocations(CountryData& country, std::map<std::string, LocationData>& locations) {
+
+    uint32_t currentLocationsNumber = country.getLocationsNumber();
+
+    // Add location from configuration file:
+    int numberOfAddedLocations = 0;
+    auto configuredLocations = webService.getSettings()->getLocations(country.getCode());
+    for (auto li = configuredLocations.begin(); li != configuredLocations.end(); li++)
+    {
+      if (locations.find(li->first) == locations.end())
+      {
+        locations[li->first] = li->second;
+        numberOfAddedLocations++;
+      }
+    }
+
+    if (numberOfAddedLocations > 0)
+    {
+      std::cout << "Country " << country.getCode() << " (" << country.getName() << ") : added " << numberOfAddedLocations << " locations from configuration file" << std::endl;
+    }
+
+    for (auto& itLocation : locations)
+      itLocation.second.setIsInitialized(true);
+    country.setLocations(locations);
+
+    uint32_t parseMapSize = (uint32_t)country.getLocations().size();
+
+    if (currentLocationsNumber != parseMapSize) {
+      std::cout << "Locations number parameter for country " << country.getCode() << " doesn't match with actual JSON parse. New locations number: " << parseMapSize << std::endl;
+      country.setLocationsNumber(parseMapSize);
+    }
+  }
+
+  void ModelBuilder::applyCompletedCallback(UA_Server* server, void* data) {
+    (void)server;
+    static_cast<ModelBuilder*>(data)->applyCompleted();
+  }
+
+  UA_StatusCode ModelBuilder::schedule(UA_Server* server, UA_UInt32 intervalMs) {
+    return UA_Server_addRepeatedCallback(server, applyCompletedCallback, this, intervalMs, NULL);
+  }
+}
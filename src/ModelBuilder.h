@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <set>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <functional>
+
+#include "open62541.h"
+
+#include "WebService.h"
+#include "ModelCache.h"
+
+namespace weatherserver {
+
+  /*
+  Deferred build of the parts of the data model that are downloaded on demand: locations of a country and weather data of a location.
+
+  Nodestore lookups and data source reads only queue a download and return right away, no server thread ever waits on the network.
+  Downloads complete on the cpprestsdk thread pool, results are queued and applied to the data model by a repeated server callback,
+  holding the data model lock exclusively. Downloads can be requested from several server threads.
+  */
+  class ModelBuilder {
+
+  public:
+
+    //Called for every location whose weather data was replaced, holding the data model lock exclusively. Must not block.
+    typedef std::function<void(const LocationData& location)> WeatherListener;
+
+    ModelBuilder(WebService& webService);
+
+    //Start download of the locations of the country, unless it is in progress already.
+    void requestLocations(CountryData& country);
+
+    //Start download of the weather data of the location, unless it is in progress already.
+    void requestWeather(LocationData& location);
+
+    //Apply downloads completed since the last call to the data model. Must not be called while model nodes are in use.
+    void applyCompleted();
+
+    //Register applyCompleted() as a repeated callback of the server.
+    UA_StatusCode schedule(UA_Server* server, UA_UInt32 intervalMs);
+
+    //Report applied downloads to the cache, so data prefetched but never accessed can be evicted as well.
+    void setModelCache(ModelCache* cache) { modelCache = cache; }
+
+    //Report replaced weather data, so it can be pushed to the subscribers of the location.
+    void setWeatherListener(const WeatherListener& listener) { weatherListener = listener; }
+
+  private:
+
+    struct CompletedLocations {
+      std::string countryCode;
+      std::map<std::string, LocationData> locations;
+    };
+
+    struct CompletedWeather {
+      std::string countryCode;
+      std::string locationName;
+      bool succeeded;
+      WeatherData weather;
+      std::chrono::system_clock::time_point receivedTime;
+    };
+
+    //Shared with the download tasks, which can outlive the builder.
+    struct CompletedQueue {
+      std::mutex mutex;
+      std::vector<CompletedLocations> locations;
+      std::vector<CompletedWeather> weather;
+    };
+
+    static void applyCompletedCallback(UA_Server* server, void* data);
+
+    void applyLocations(CountryData& country, std::map<std::string, LocationData>& locations);
+
+    WebService& webService;
+    std::shared_ptr<CompletedQueue> completed;
+    ModelCache* modelCache{ nullptr };
+    WeatherListener weatherListener;
+
+    //Downloads in progress.
+    std::mutex pendingMutex;
+    std::set<std::string> pendingCountries;
+    std::set<std::string> pendingWeather;
+  };
+}
@@ -0,0 +1,110 @@
+#include "ModelCache.h"
+
+namespace weatherserver {
+
+  ModelCache::ModelCache(WebService& webService, size_t maxCountriesWithLocations, size_t maxLocationsWithWeather)
+    : webService{ webService },
+      maxCountriesWithLocations{ maxCountriesWithLocations },
+      maxLocationsWithWeather{ maxLocationsWithWeather } {}
+
+  void ModelCache::touch(LruList& list, std::unordered_map<std::string, LruList::iterator>& index, const std::string& key) {
+    auto itIndex = index.find(key);
+    if (itIndex != index.end()) {
+      list.splice(list.begin(), list, itIndex->second);
+    }
+    else {
+      list.push_front(key);
+      index[key] = list.begin();
+    }
+  }
+
+  void ModelCache::touchCountry(const CountryData& country) {
+    std::lock_guard<std::mutex> lock(mutex);
+    touch(countries, countriesIndex, country.getCode());
+  }
+
+  void ModelCache::touchLocation(const LocationData& location) {
+    std::string locationKey = location.getCountryCode() + "." + location.getName();
+    std::lock_guard<std::mutex> lock(mutex);
+    touch(locations, locationsIndex, locationKey);
+  }
+
+  void ModelCache::evict() {
+    std::unique_lock<std::shared_timed_mutex> modelLock(webService.getModelMutex());
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t evictedCountries = 0;
+    while (maxCountriesWithLocations > 0 && countries.size() > maxCountriesWithLocations) {
+      std::string countryCode = countries.back();
+      evictCountry(countryCode);
+      evictedCountries++;
+    }
+
+    size_t evictedLocations = 0;
+    while (maxLocationsWithWeather > 0 && locations.size() > maxLocationsWithWeather) {
+      std::string locationKey = locations.back();
+      evictLocation(locationKey);
+      evictedLocations++;
+    }
+
+    if (evictedCountries > 0 || evictedLocations > 0) {
+      UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+        "Model cache: evicted locations of %u countries and weather data of %u locations",
+        (unsigned)evictedCountries, (unsigned)evictedLocations);
+    }
+  }
+
+  void ModelCache::evictCountry(const std::string& countryCode) {
+    auto itIndex = countriesIndex.find(countryCode);
+    if (itIndex != countriesIndex.end()) {
+      countries.erase(itIndex->second);
+      countriesIndex.erase(itIndex);
+    }
+
+    // Weather data of the locations goes away together with the locations.
+    std::string prefix = countryCode + ".";
+    for (auto itLocation = locations.begin(); itLocation != locations.end();) {
+      if (itLocation->compare(0, prefix.size(), prefix) == 0) {
+        locationsIndex.erase(*itLocation);
+        itLocation = locations.erase(itLocation);
+      }
+      else {
+        itLocation++;
+      }
+    }
+
+    auto& allCountries = webService.getAllCountries();
+    auto itCountry = allCountries.find(countryCode);
+    if (itCountry != allCountries.end())
+      itCountry->second.setLocations(std::map<std::string, LocationData>());
+  }
+
+  void ModelCache::evictLocation(const std::string& locationKey) {
+    auto itIndex = locationsIndex.find(locationKey);
+    if (itIndex != locationsIndex.end()) {
+      locations.erase(itIndex->second);
+      locationsIndex.erase(itIndex);
+    }
+
+    // Location key is composed as CountryCode.LocationName, country code has two letters.
+    auto& allCountries = webService.getAllCountries();
+    auto itCountry = allCountries.find(locationKey.substr(0, 2));
+    if (itCountry == allCountries.end())
+      return;
+
+    auto& countryLocations = itCountry->second.getLocations();
+    auto itLocation = countryLocations.find(locationKey.substr(3));
+    if (itLocation != countryLocations.end()) {
+      itLocation->second.setWeatherData(WeatherData());
+      itLocation->second.setHasBeenReceivedWeatherData(false);
+    }
+  }
+
+  void ModelCache::evictCallback(UA_Server* server, void* data) {
+    (void)server;
+    static_cast<ModelCache*>(data)->evict();
+  }
+
+  UA_StatusCode ModelCache::schedule(UA_Server* server, UA_UInt32 intervalMs) {
+    return UA_Server_addRepeatedCallback(server, evictCallback, this, intervalMs, NULL);
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+#include "open62541.h"
+
+#include "WebService.h"
+
+namespace weatherserver {
+
+  /*
+  Least recently used tracking of the parts of the data model that are downloaded on demand:
+    - locations of a country (downloaded on first access to the country);
+    - weather data of a location (downloaded on first read of a weather variable).
+
+  Clients crawling through all countries and locations would make the data model grow until everything is downloaded.
+  The cache keeps the number of countries with locations and the number of locations with weather data within a budget.
+  Evicted parts are downloaded again on demand the next time a client accesses them.
+
+  Access is recorded while nodes are resolved, eviction runs from a repeated server callback holding the data model lock
+  exclusively, so no location referenced by a node that is currently in use is deleted.
+  */
+  class ModelCache {
+
+  public:
+
+    /*
+    @param maxCountriesWithLocations - how many countries may keep their locations, 0 for no limit.
+    @param maxLocationsWithWeather - how many locations may keep their weather data, 0 for no limit.
+    */
+    ModelCache(WebService& webService, size_t maxCountriesWithLocations, size_t maxLocationsWithWeather);
+
+    //Mark the country (and its locations) as recently used.
+    void touchCountry(const CountryData& country);
+
+    //Mark the location (and its weather data) as recently used.
+    void touchLocation(const LocationData& location);
+
+    //Drop least recently used locations lists and weather data exceeding the budget. Must not be called while model nodes are in use.
+    void evict();
+
+    //Register evict() as a repeated callback of the server.
+    UA_StatusCode schedule(UA_Server* server, UA_UInt32 intervalMs);
+
+    size_t getCountriesWithLocations() const { return countries.size(); }
+    size_t getLocationsWithWeather() const { return locations.size(); }
+
+  private:
+
+    typedef std::list<std::string> LruList;
+
+    //Move key to the front of the list, adding it if it is not there yet.
+    static void touch(LruList& list, std::unordered_map<std::string, LruList::iterator>& index, const std::string& key);
+
+    static void evictCallback(UA_Server* server, void* data);
+
+    void evictCountry(const std::string& countryCode);
+    void evictLocation(const std::string& locationKey);
+
+    WebService& webService;
+    size_t maxCountriesWithLocations;
+    size_t maxLocationsWithWeather;
+
+    //Access is recorded from several server threads.
+    std::mutex mutex;
+
+    //Country codes, most recently used first.
+    LruList countries;
+    std::unordered_map<std::string, LruList::iterator> countriesIndex;
+
+    //Location keys composed as CountryCode.LocationName, most recently used first.
+    LruList locations;
+    std::unordered_map<std::string, LruList::iterator> locationsIndex;
+  };
+}
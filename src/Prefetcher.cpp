@@ -0,0 +1,117 @@
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include "Prefetcher.h"
+
+namespace weatherserver {
+
+  const utility::string_t Prefetcher::KEY_CODE = U("code");
+  const utility::string_t Prefetcher::KEY_ACCESSES = U("accesses");
+
+  Prefetcher::Prefetcher(WebService& webService, ModelBuilder& modelBuilder, const std::string& statisticsFilePath,
+    size_t countriesNumber, size_t locationsNumber)
+    : webService{ webService },
+      modelBuilder{ modelBuilder },
+      statisticsFilePath{ statisticsFilePath },
+      countriesNumber{ countriesNumber },
+      locationsNumber{ locationsNumber } {}
+
+  void Prefetcher::onCountriesFolderAccess() {
+    if (countriesNumber == 0)
+      return;
+
+    std::vector<std::pair<uint64_t, std::string>> ranking;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ranking.reserve(accessCounts.size());
+      for (auto& itCount : accessCounts)
+        ranking.emplace_back(itCount.second, itCount.first);
+    }
+    if (ranking.empty())
+      return;
+
+    size_t topNumber = std::min(countriesNumber, ranking.size());
+    std::partial_sort(ranking.begin(), ranking.begin() + topNumber, ranking.end(),
+      [](const std::pair<uint64_t, std::string>& a, const std::pair<uint64_t, std::string>& b) { return a.first > b.first; });
+
+    auto& countries = webService.getAllCountries();
+    for (size_t index = 0; index < topNumber; index++) {
+      auto itCountry = countries.find(ranking[index].second);
+      if (itCountry != countries.end() && itCountry->second.getIsInitialized() && itCountry->second.getLocations().empty())
+        modelBuilder.requestLocations(itCountry->second);
+    }
+  }
+
+  void Prefetcher::onCountryAccess(CountryData& country) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      accessCounts[country.getCode()]++;
+      statisticsChanged = true;
+    }
+
+    size_t requested = 0;
+    auto& locations = country.getLocations();
+    for (auto itLocation = locations.begin(); itLocation != locations.end() && requested < locationsNumber; itLocation++, requested++) {
+      if (!itLocation->second.getHasBeenReceivedWeatherData())
+        modelBuilder.requestWeather(itLocation->second);
+    }
+  }
+
+  void Prefetcher::loadStatistics() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (statisticsFilePath.empty())
+      return;
+
+    std::ifstream inputFile{ statisticsFilePath };
+    if (!inputFile)
+      return;
+
+    try {
+      auto jsonFile = web::json::value::parse(inputFile);
+      if (jsonFile.is_array()) {
+        for (size_t index = 0; index < jsonFile.as_array().size(); index++) {
+          web::json::value& entry = jsonFile.as_array()[index];
+          std::string code = utility::conversions::to_utf8string(entry.at(KEY_CODE).as_string());
+          accessCounts[code] = static_cast<uint64_t>(entry.at(KEY_ACCESSES).as_double());
+        }
+      }
+      std::cout << "Access statistics loaded for " << accessCounts.size() << " countries" << std::endl;
+    }
+    catch (const web::json::json_exception & e) {
+      std::cerr << "Error while parsing access statistics file " << statisticsFilePath << ": " << e.what() << std::endl;
+    }
+  }
+
+  void Prefetcher::saveStatistics() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (statisticsFilePath.empty() || !statisticsChanged)
+      return;
+
+    web::json::value jsonArray = web::json::value::array(accessCounts.size());
+    size_t index = 0;
+    for (auto& itCount : accessCounts) {
+      web::json::value entry = web::json::value::object();
+      entry[KEY_CODE] = web::json::value::string(utility::conversions::to_string_t(itCount.first));
+      entry[KEY_ACCESSES] = web::json::value::number(static_cast<double>(itCount.second));
+      jsonArray[index++] = entry;
+    }
+
+    std::ofstream outputFile{ statisticsFilePath };
+    if (!outputFile) {
+      std::cerr << "Could not write access statistics file: " << statisticsFilePath << std::endl;
+      return;
+    }
+    outputFile << utility::conversions::to_utf8string(jsonArray.serialize());
+    statisticsChanged = false;
+  }
+
+  void Prefetcher::saveStatisticsCallback(UA_Server* server, void* data) {
+    (void)server;
+    static_cast<Prefetcher*>(data)->saveStatistics();
+  }
+
+  UA_StatusCode Prefetcher::schedule(UA_Server* server, UA_UInt32 intervalMs) {
+    return UA_Server_addRepeatedCallback(server, saveStatisticsCallback, this, intervalMs, NULL);
+  }
+}
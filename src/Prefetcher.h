@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+
+#include "open62541.h"
+
+#include "WebService.h"
+#include "ModelBuilder.h"
+
+namespace weatherserver {
+
+  /*
+  Prefetch policy for the data model downloaded on demand.
+
+  Clients usually browse "Countries", then a country, then its locations and would wait for a download at each step.
+    - When the "Countries" folder is browsed, download of locations is requested for the most popular countries.
+    - When a country is browsed, download of weather data is requested for its first locations.
+
+  Popularity of a country is the number of browses of it, stored in the statistics file between runs.
+  */
+  class Prefetcher {
+
+  public:
+
+    /*
+    @param statisticsFilePath - file keeping access counts of the countries between runs, empty to not keep them.
+    @param countriesNumber - for how many of the most popular countries to prefetch locations.
+    @param locationsNumber - for how many locations of an accessed country to prefetch weather data.
+    */
+    Prefetcher(WebService& webService, ModelBuilder& modelBuilder, const std::string& statisticsFilePath,
+      size_t countriesNumber, size_t locationsNumber);
+
+    //Called when the "Countries" folder is browsed.
+    void onCountriesFolderAccess();
+
+    //Called when the country is browsed, once per Browse request.
+    void onCountryAccess(CountryData& country);
+
+    //Read access counts from the statistics file, missing file is not an error.
+    void loadStatistics();
+
+    //Write access counts to the statistics file.
+    void saveStatistics();
+
+    //Register saving of the statistics as a repeated callback of the server.
+    UA_StatusCode schedule(UA_Server* server, UA_UInt32 intervalMs);
+
+    static const utility::string_t KEY_CODE;
+    static const utility::string_t KEY_ACCESSES;
+
+  private:
+
+    static void saveStatisticsCallback(UA_Server* server, void* data);
+
+    WebService& webService;
+    ModelBuilder& modelBuilder;
+    std::string statisticsFilePath;
+    size_t countriesNumber;
+    size_t locationsNumber;
+
+    //Access counts are updated from several server threads.
+    std::mutex mutex;
+
+    //Access count per country code.
+    std::map<std::string, uint64_t> accessCounts;
+    bool statisticsChanged{ false };
+  };
+}
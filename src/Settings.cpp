@@ -8,14 +8,35 @@ namespace weatherserver {
   const utility::string_t Settings::PARAM_NAME_API_DARKSKY_API_KEY = U("api_key");
   const utility::string_t Settings::PARAM_NAME_API_DARKSKY_UNITS = U("param_units");
   const utility::string_t Settings::PARAM_NAME_API_DARKSKY_INTERVAL_DOWNLOAD_WEATHER_DATA = U("interval_download");
+  const utility::string_t Settings::MODEL_CACHE = U("model_cache");
+  const utility::string_t Settings::PARAM_NAME_MAX_COUNTRIES_WITH_LOCATIONS = U("max-countries-with-locations");
+  const utility::string_t Settings::PARAM_NAME_MAX_LOCATIONS_WITH_WEATHER = U("max-locations-with-weather");
+  const utility::string_t Settings::PREFETCH = U("prefetch");
+  const utility::string_t Settings::PARAM_NAME_PREFETCH_COUNTRIES_NUMBER = U("countries-number");
+  const utility::string_t Settings::PARAM_NAME_PREFETCH_LOCATIONS_NUMBER = U("locations-number");
+  const utility::string_t Settings::PARAM_NAME_STATISTICS_FILE = U("statistics-file");
 
   Settings::Settings(const std::string& settingsFilePath) {
     keyApiDarksky = U("");
     units = U("si");
     intervalWeatherDataDownload = 10;
+    maxCountriesWithLocations = 50;
+    maxLocationsWithWeather = 5000;
+    prefetchCountriesNumber = 5;
+    prefetchLocationsNumber = 10;
+    //by default next to the settings file
+    statisticsFilePath = settingsFilePath.substr(0, settingsFilePath.find_last_of("/\\") + 1) + "access_statistics.json";
     port_number = 48484;
     endpointUrl = "opc.tcp://localhost:48484";
     hostName = "localhost";
+    referenceIndexThreshold = 64;
+    eventLoops = 1;
+    pooledBuffers = 64;
+    requestArenaSize = 1024 * 1024;
+    shareNamespaceZero = true;
+    notificationBatchWindow = 0.0;
+    pooledNotifications = 16384;
+    browseCacheSize = 65536;
 
     processSettingsFile(settingsFilePath);
   }
@@ -45,6 +66,42 @@ namespace weatherserver {
       this->port_number = jsonFile.at(U("opc_ua_server")).at(U("port-number")).as_integer();
       this->endpointUrl = utility::conversions::to_utf8string(jsonFile.at(U("opc_ua_server")).at(U("endpoint-url")).as_string());
       this->hostName = utility::conversions::to_utf8string(jsonFile.at(U("opc_ua_server")).at(U("host-name")).as_string());
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("reference-index-threshold")))
+        this->referenceIndexThreshold = static_cast<size_t>(std::max(0, jsonFile.at(U("opc_ua_server")).at(U("reference-index-threshold")).as_integer()));
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("event-loops")))
+        this->eventLoops = static_cast<size_t>(std::max(1, jsonFile.at(U("opc_ua_server")).at(U("event-loops")).as_integer()));
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("pooled-buffers")))
+        this->pooledBuffers = static_cast<size_t>(std::max(0, jsonFile.at(U("opc_ua_server")).at(U("pooled-buffers")).as_integer()));
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("request-arena-size")))
+        this->requestArenaSize = static_cast<size_t>(std::max(0, jsonFile.at(U("opc_ua_server")).at(U("request-arena-size")).as_integer()));
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("share-namespace-zero")))
+        this->shareNamespaceZero = jsonFile.at(U("opc_ua_server")).at(U("share-namespace-zero")).as_bool();
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("notification-batch-window")))
+        this->notificationBatchWindow = std::max(0.0, jsonFile.at(U("opc_ua_server")).at(U("notification-batch-window")).as_double());
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("pooled-notifications")))
+        this->pooledNotifications = static_cast<size_t>(std::max(0, jsonFile.at(U("opc_ua_server")).at(U("pooled-notifications")).as_integer()));
+      if (jsonFile.at(U("opc_ua_server")).has_field(U("browse-cache-size")))
+        this->browseCacheSize = static_cast<size_t>(std::max(0, jsonFile.at(U("opc_ua_server")).at(U("browse-cache-size")).as_integer()));
+
+      if (jsonFile.has_field(MODEL_CACHE))
+      {
+        auto& cacheField = jsonFile.at(MODEL_CACHE);
+        if (cacheField.has_field(PARAM_NAME_MAX_COUNTRIES_WITH_LOCATIONS))
+          maxCountriesWithLocations = static_cast<size_t>(std::max(0, cacheField.at(PARAM_NAME_MAX_COUNTRIES_WITH_LOCATIONS).as_integer()));
+        if (cacheField.has_field(PARAM_NAME_MAX_LOCATIONS_WITH_WEATHER))
+          maxLocationsWithWeather = static_cast<size_t>(std::max(0, cacheField.at(PARAM_NAME_MAX_LOCATIONS_WITH_WEATHER).as_integer()));
+      }
+
+      if (jsonFile.has_field(PREFETCH))
+      {
+        auto& prefetchField = jsonFile.at(PREFETCH);
+        if (prefetchField.has_field(PARAM_NAME_PREFETCH_COUNTRIES_NUMBER))
+          prefetchCountriesNumber = static_cast<size_t>(std::max(0, prefetchField.at(PARAM_NAME_PREFETCH_COUNTRIES_NUMBER).as_integer()));
+        if (prefetchField.has_field(PARAM_NAME_PREFETCH_LOCATIONS_NUMBER))
+          prefetchLocationsNumber = static_cast<size_t>(std::max(0, prefetchField.at(PARAM_NAME_PREFETCH_LOCATIONS_NUMBER).as_integer()));
+        if (prefetchField.has_field(PARAM_NAME_STATISTICS_FILE))
+          statisticsFilePath = utility::conversions::to_utf8string(prefetchField.at(PARAM_NAME_STATISTICS_FILE).as_string());
+      }
 
       if (jsonFile.has_field(U("countries")))
       {
@@ -98,6 +155,11 @@ namespace weatherserver {
 
     std::cout << "Weather data units: " << utility::conversions::to_utf8string(units) << std::endl;
     std::cout << "Interval in minutes for automatic update of weather data: " << intervalWeatherDataDownload << std::endl;
+    std::cout << "Maximum number of countries with locations in memory (0 - no limit): " << maxCountriesWithLocations << std::endl;
+    std::cout << "Maximum number of locations with weather data in memory (0 - no limit): " << maxLocationsWithWeather << std::endl;
+    std::cout << "Prefetch locations for most popular countries: " << prefetchCountriesNumber
+      << ", weather data for first locations of a country: " << prefetchLocationsNumber << std::endl;
+    std::cout << "Access statistics file: " << statisticsFilePath << std::endl;
 
     std::cout << "###############################################################" << std::endl << std::endl;
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -26,6 +27,11 @@ namespace weatherserver {
     const utility::string_t& getUnits() const { return units; }
     int getIntervalWeatherDataDownload() const { return intervalWeatherDataDownload; }
     const std::map<std::string, CountryData>& getCountries() const { return countries; }
+    size_t getMaxCountriesWithLocations() const { return maxCountriesWithLocations; }
+    size_t getMaxLocationsWithWeather() const { return maxLocationsWithWeather; }
+    size_t getPrefetchCountriesNumber() const { return prefetchCountriesNumber; }
+    size_t getPrefetchLocationsNumber() const { return prefetchLocationsNumber; }
+    const std::string& getStatisticsFilePath() const { return statisticsFilePath; }
 
     //this call will perform an insertion if countryCode key is not found!
     const std::map<std::string, LocationData>& getLocations(const std::string& countryCode) { return locations[countryCode]; }
@@ -36,10 +42,33 @@ namespace weatherserver {
     static const utility::string_t PARAM_NAME_API_DARKSKY_API_KEY;
     static const utility::string_t PARAM_NAME_API_DARKSKY_UNITS;
     static const utility::string_t PARAM_NAME_API_DARKSKY_INTERVAL_DOWNLOAD_WEATHER_DATA;
+    static const utility::string_t MODEL_CACHE;
+    static const utility::string_t PARAM_NAME_MAX_COUNTRIES_WITH_LOCATIONS;
+    static const utility::string_t PARAM_NAME_MAX_LOCATIONS_WITH_WEATHER;
+    static const utility::string_t PREFETCH;
+    static const utility::string_t PARAM_NAME_PREFETCH_COUNTRIES_NUMBER;
+    static const utility::string_t PARAM_NAME_PREFETCH_LOCATIONS_NUMBER;
+    static const utility::string_t PARAM_NAME_STATISTICS_FILE;
 
     int port_number;
     std::string endpointUrl;
     std::string hostName;
+    //Number of reference targets of a node above which they are indexed by a hash table.
+    size_t referenceIndexThreshold;
+    //Number of server event loops, each running on its own thread and sharing the port.
+    size_t eventLoops;
+    //Number of send and receive buffers of every size kept for reuse by the network layer of an event loop.
+    size_t pooledBuffers;
+    //Bytes kept by an event loop to decode requests into, 0 decodes every request on the heap.
+    size_t requestArenaSize;
+    //Build namespace 0 once and share it between the event loops, instead of building it for every server.
+    bool shareNamespaceZero;
+    //Milliseconds a subscription waits for further notifications before publishing them together, 0 publishes right away.
+    double notificationBatchWindow;
+    //Number of notifications and of retransmitted messages kept for reuse by the server of an event loop.
+    size_t pooledNotifications;
+    //Number of reference descriptions kept by the server of an event loop to answer browse requests, 0 disables the cache.
+    size_t browseCacheSize;
 
   private:
 
@@ -58,6 +87,13 @@ namespace weatherserver {
     utility::string_t keyApiDarksky;
     utility::string_t units;
     int intervalWeatherDataDownload;
+    //Budget of the data model downloaded on demand, 0 means no limit.
+    size_t maxCountriesWithLocations;
+    size_t maxLocationsWithWeather;
+    //Prefetch policy, 0 disables the respective prefetch.
+    size_t prefetchCountriesNumber;
+    size_t prefetchLocationsNumber;
+    std::string statisticsFilePath;
     bool settingsAreValid = false;
 
     //Countries and locations that were passed through settings file.
@@ -0,0 +1,598 @@
+#include "WeatherNodestore.h"
+
+#include <vector>
+#include <cstring>
+
+namespace weatherserver {
+
+  char WeatherNodestore::DESCRIPTION_COUNTRIES_FOLDER[] = "Organizes all the Countries object with their respective information";
+  char WeatherNodestore::DESCRIPTION_COUNTRY[] = "Country object with attributes and locations information.";
+  char WeatherNodestore::DESCRIPTION_LOCATION[] = "Location object containing weather information";
+
+  namespace {
+
+    char LOCALE[] = "en-US";
+
+    /*
+    Weather data only changes when a download completes, the new values are pushed to the MonitoredItems then
+    (WeatherNodestore::notifyWeatherChanged). Periodic samples are only needed to request the download of outdated data.
+    */
+    const UA_Double WEATHER_MINIMUM_SAMPLING_INTERVAL = 60000.0;
+
+    //Browse name, description and data type of a variable node in the information model.
+    struct VariableDescription {
+      const char* browseName;
+      const char* description;
+      const UA_DataType* dataType;
+    };
+
+    const VariableDescription COUNTRY_VARIABLES[] = {
+      { CountryData::BROWSE_NAME, "The name of a country", &UA_TYPES[UA_TYPES_STRING] },
+      { CountryData::BROWSE_CODE, "2 letters ISO code representing the Country Name", &UA_TYPES[UA_TYPES_STRING] },
+      { CountryData::BROWSE_CITIES_NUMBER, "Number of cities belonged to a country. It can be city or province", &UA_TYPES[UA_TYPES_UINT32] },
+      { CountryData::BROWSE_LOCATIONS_NUMBER, "Number of locations belonged to a country.", &UA_TYPES[UA_TYPES_UINT32] }
+    };
+
+    const VariableDescription LOCATION_VARIABLES[] = {
+      { LocationData::BROWSE_FLAG_INITIALIZE, "Auxiliary variable to indicate when to download weather data for this location.", &UA_TYPES[UA_TYPES_BOOLEAN] },
+      { WeatherData::BROWSE_LATITUDE, "The latitude of a location (in decimal degrees). Positive is north, negative is south.", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_LONGITUDE, "The longitude of a location (in decimal degrees). Positive is east, negative is west.", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_TIMEZONE, "The IANA timezone name for the requested location.", &UA_TYPES[UA_TYPES_STRING] },
+      { WeatherData::BROWSE_ICON, "A machine-readable text icon of this data point, suitable for selecting an icon for display.", &UA_TYPES[UA_TYPES_STRING] },
+      { WeatherData::BROWSE_TEMPERATURE, "The air temperature in degrees Celsius (if units=si during request) or Fahrenheit.", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_APPARENT_TEMPERATURE, "The apparent (or `feels like`) temperature in degrees Celsius (units=si) or Fahrenheit.", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_HUMIDITY, "The relative humidity, between 0 and 1, inclusive.", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_PRESSURE, "The sea-level air pressure in Hectopascals (if units=si during request) or millibars.", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_WIND_SPEED, "The wind speed in meters per second (if units=si during request) or miles per hour.", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_WIND_BEARING, "The direction that the wind is coming from in degrees, with true north at 0\xC2\xB0 and progressing clockwise. (If windSpeed is zero, then this value should be ignored.)", &UA_TYPES[UA_TYPES_DOUBLE] },
+      { WeatherData::BROWSE_CLOUD_COVER, "The percentage of sky occluded by clouds, between 0 and 1, inclusive.", &UA_TYPES[UA_TYPES_DOUBLE] }
+    };
+
+    template <size_t N>
+    const VariableDescription* findVariable(const VariableDescription (&variables)[N], const std::string& browseName) {
+      for (size_t i = 0; i < N; i++) {
+        if (browseName == variables[i].browseName)
+          return &variables[i];
+      }
+      return nullptr;
+    }
+
+    std::string countryNameId(const CountryData& country) {
+      return std::string(CountryData::COUNTRIES_FOLDER_NODE_ID) + "." + country.getCode();
+    }
+
+    std::string locationNameId(const LocationData& location) {
+      return std::string(CountryData::COUNTRIES_FOLDER_NODE_ID) + "." + location.getCountryCode() + "." + location.getName();
+    }
+
+    UA_NodeId modelNodeId(const std::string& nameId) {
+      return UA_NODEID_STRING_ALLOC(WebService::OPC_NS_INDEX, nameId.c_str());
+    }
+
+    /*
+    Append a reference kind with all "targets" to the node. Ownership of the target node ids is moved to the node.
+    The node is synthesised from scratch, so there is no need to check for duplicates as UA_Node_addReference does.
+    */
+    UA_StatusCode addReferences(UA_Node* node, UA_UInt32 referenceType, bool isInverse, std::vector<UA_NodeId>& targets) {
+      if (targets.empty())
+        return UA_STATUSCODE_GOOD;
+
+      UA_StatusCode retval = UA_STATUSCODE_BADOUTOFMEMORY;
+      UA_NodeReferenceKind* references = static_cast<UA_NodeReferenceKind*>(
+        UA_realloc(node->references, sizeof(UA_NodeReferenceKind) * (node->referencesSize + 1)));
+      if (references) {
+        node->references = references;
+        UA_ExpandedNodeId* targetIds = static_cast<UA_ExpandedNodeId*>(
+          UA_Array_new(targets.size(), &UA_TYPES[UA_TYPES_EXPANDEDNODEID]));
+        if (targetIds) {
+          for (size_t i = 0; i < targets.size(); i++)
+            targetIds[i].nodeId = targets[i];
+          UA_NodeReferenceKind& kind = references[node->referencesSize];
+          kind.referenceTypeId = UA_NODEID_NUMERIC(0, referenceType);
+          kind.isInverse = isInverse;
+          kind.targetIdsSize = targets.size();
+          kind.targetIds = targetIds;
+          kind.targetIdsIndex = NULL;
+          kind.targetIdsIndexSize = 0;
+          node->referencesSize++;
+          targets.clear();
+          return UA_STATUSCODE_GOOD;
+        }
+      }
+
+      for (auto& target : targets)
+        UA_NodeId_deleteMembers(&target);
+      targets.clear();
+      return retval;
+    }
+
+    UA_StatusCode setBrowseName(UA_Node* node, const char* name) {
+      UA_QualifiedName browseName = UA_QUALIFIEDNAME(WebService::OPC_NS_INDEX, const_cast<char*>(name));
+      return UA_QualifiedName_copy(&browseName, &node->browseName);
+    }
+
+    UA_StatusCode addReference(UA_Node* node, UA_UInt32 referenceType, bool isInverse, const UA_NodeId& target) {
+      std::vector<UA_NodeId> targets(1, target);
+      return addReferences(node, referenceType, isInverse, targets);
+    }
+  }
+
+  WeatherNodestore::WeatherNodestore(WebService& webService, const UA_DataSource& weatherDataSource, const LocationsLoader& locationsLoader)
+    : webService{ webService },
+      weatherDataSource{ weatherDataSource },
+      locationsLoader{ locationsLoader }
+  {
+    memset(&defaultNodestore, 0, sizeof(defaultNodestore));
+  }
+
+  void WeatherNodestore::attach(UA_Nodestore& nodestore) {
+    defaultNodestore = nodestore;
+
+    nodestore.context = this;
+    // Synthesised nodes are deleted on release, edits must go through getNodeCopy / replaceNode to be refused.
+    nodestore.inPlaceEditAllowed = false;
+    nodestore.deleteNodestore = deleteNodestore;
+    nodestore.newNode = newNode;
+    nodestore.deleteNode = deleteNode;
+    nodestore.getNode = getNode;
+    nodestore.releaseNode = releaseNode;
+    nodestore.getNodeCopy = getNodeCopy;
+    nodestore.insertNode = insertNode;
+    nodestore.replaceNode = replaceNode;
+    nodestore.removeNode = removeNode;
+    nodestore.iterate = iterate;
+    nodestore.notifyBrowse = notifyBrowse;
+  }
+
+  UA_StatusCode WeatherNodestore::linkToObjectsFolder() {
+    // The inverse reference is part of the synthesised "Countries" node already, only the Objects folder is edited.
+    // The server would add both directions and the synthesised side refuses edits, so the node is edited directly.
+    UA_NodeId objectsFolderId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_Node* objectsFolder = nullptr;
+    UA_StatusCode retval = defaultNodestore.getNodeCopy(defaultNodestore.context, &objectsFolderId, &objectsFolder);
+    if (retval != UA_STATUSCODE_GOOD)
+      return retval;
+
+    UA_AddReferencesItem item;
+    UA_AddReferencesItem_init(&item);
+    item.sourceNodeId = objectsFolderId;
+    item.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    item.isForward = true;
+    item.targetNodeId = UA_EXPANDEDNODEID_STRING(WebService::OPC_NS_INDEX, CountryData::COUNTRIES_FOLDER_NODE_ID);
+    item.targetNodeClass = UA_NODECLASS_OBJECT;
+    retval = UA_Node_addReference(objectsFolder, &item);
+    if (retval != UA_STATUSCODE_GOOD) {
+      defaultNodestore.deleteNode(defaultNodestore.context, objectsFolder);
+      return retval;
+    }
+    return defaultNodestore.replaceNode(defaultNodestore.context, objectsFolder);
+  }
+
+  bool WeatherNodestore::isModelNodeId(const UA_NodeId& nodeId) {
+    if (nodeId.namespaceIndex != WebService::OPC_NS_INDEX || nodeId.identifierType != UA_NODEIDTYPE_STRING)
+      return false;
+
+    const size_t folderLength = strlen(CountryData::COUNTRIES_FOLDER_NODE_ID);
+    const UA_String& identifier = nodeId.identifier.string;
+    if (identifier.length < folderLength || memcmp(identifier.data, CountryData::COUNTRIES_FOLDER_NODE_ID, folderLength) != 0)
+      return false;
+
+    return identifier.length == folderLength || identifier.data[folderLength] == '.';
+  }
+
+  WeatherNodestore::ModelNode WeatherNodestore::resolve(const UA_NodeId& nodeId) {
+    ModelNode modelNode;
+    std::string nodeIdName(reinterpret_cast<char*>(nodeId.identifier.string.data), nodeId.identifier.string.length);
+
+    if (nodeIdName == CountryData::COUNTRIES_FOLDER_NODE_ID) {
+      modelNode.kind = ModelNode::Kind::CountriesFolder;
+      return modelNode;
+    }
+
+    /*
+    Two country code letters are at position 10 and 11 (starting from 0), the rest of the node id starts at position 13.
+    */
+    if (nodeIdName.size() < 12 || (nodeIdName.size() > 12 && (nodeIdName.size() == 13 || nodeIdName[12] != '.')))
+      return modelNode;
+
+    auto& countries = webService.getAllCountries();
+    auto itCountry = countries.find(nodeIdName.substr(10, 2));
+    if (itCountry == countries.end() || !itCountry->second.getIsInitialized())
+      return modelNode;
+
+    auto& country = itCountry->second;
+    modelNode.country = &country;
+
+    if (nodeIdName.size() == 12) {
+      // While the "Countries" folder is browsed, the country is only described - do not download locations for all of them.
+      if (countriesFolderInUse == 0 && country.getLocations().empty())
+        locationsLoader(country);
+      if (modelCache && !country.getLocations().empty())
+        modelCache->touchCountry(country);
+      modelNode.kind = ModelNode::Kind::Country;
+      return modelNode;
+    }
+
+    std::string childName = nodeIdName.substr(13);
+    if (findVariable(COUNTRY_VARIABLES, childName)) {
+      if (country.getLocations().empty())
+        locationsLoader(country);
+      if (modelCache)
+        modelCache->touchCountry(country);
+      modelNode.kind = ModelNode::Kind::CountryVariable;
+      modelNode.variableName = childName;
+      return modelNode;
+    }
+
+    if (country.getLocations().empty())
+      locationsLoader(country);
+    if (modelCache)
+      modelCache->touchCountry(country);
+    auto& locations = country.getLocations();
+
+    /*
+    Some locations have '.' within the name, so look for the full name first.
+    For example, the following node ids are both locations:
+      Countries.CA.Brandon
+      Countries.CA.Main St.
+    Variable names never contain a '.', so the last part of the node id is the variable name otherwise:
+      Countries.CA.Main St.FlagInitialize
+    */
+    auto itLocation = locations.find(childName);
+    if (itLocation != locations.end()) {
+      modelNode.kind = ModelNode::Kind::Location;
+      modelNode.location = &itLocation->second;
+      return modelNode;
+    }
+
+    size_t posDot = childName.rfind('.');
+    if (posDot == std::string::npos)
+      return modelNode;
+
+    std::string variableName = childName.substr(posDot + 1);
+    itLocation = locations.find(childName.substr(0, posDot));
+    if (itLocation != locations.end() && findVariable(LOCATION_VARIABLES, variableName)) {
+      modelNode.kind = ModelNode::Kind::LocationVariable;
+      modelNode.location = &itLocation->second;
+      modelNode.variableName = variableName;
+      if (modelCache)
+        modelCache->touchLocation(itLocation->second);
+    }
+    return modelNode;
+  }
+
+  UA_Node* WeatherNodestore::createNode(const ModelNode& modelNode) {
+    switch (modelNode.kind) {
+    case ModelNode::Kind::CountriesFolder:
+      return createCountriesFolderNode();
+    case ModelNode::Kind::Country:
+      return createCountryNode(*modelNode.country);
+    case ModelNode::Kind::CountryVariable:
+      return createCountryVariableNode(*modelNode.country, modelNode.variableName);
+    case ModelNode::Kind::Location:
+      return createLocationNode(*modelNode.location);
+    case ModelNode::Kind::LocationVariable:
+      return createLocationVariableNode(*modelNode.location, modelNode.variableName);
+    default:
+      return nullptr;
+    }
+  }
+
+  UA_Node* WeatherNodestore::createCountriesFolderNode() {
+    UA_Node* node = newNode(this, UA_NODECLASS_OBJECT);
+    if (!node)
+      return nullptr;
+
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT(LOCALE, DESCRIPTION_COUNTRIES_FOLDER);
+    attr.displayName = UA_LOCALIZEDTEXT(LOCALE, CountryData::COUNTRIES_FOLDER_NODE_ID);
+
+    node->nodeId = modelNodeId(CountryData::COUNTRIES_FOLDER_NODE_ID);
+    UA_StatusCode retval = setBrowseName(node, CountryData::COUNTRIES_FOLDER_NODE_ID);
+    retval |= UA_Node_setAttributes(node, &attr, &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES]);
+    retval |= addReference(node, UA_NS0ID_HASTYPEDEFINITION, false, UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE));
+    retval |= addReference(node, UA_NS0ID_ORGANIZES, true, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER));
+
+    std::vector<UA_NodeId> countryIds;
+    for (auto& itCountry : webService.getAllCountries()) {
+      if (itCountry.second.getIsInitialized())
+        countryIds.push_back(modelNodeId(countryNameId(itCountry.second)));
+    }
+    retval |= addReferences(node, UA_NS0ID_ORGANIZES, false, countryIds);
+
+    if (retval != UA_STATUSCODE_GOOD) {
+      deleteNode(this, node);
+      return nullptr;
+    }
+    return node;
+  }
+
+  UA_Node* WeatherNodestore::createCountryNode(CountryData& country) {
+    UA_Node* node = newNode(this, UA_NODECLASS_OBJECT);
+    if (!node)
+      return nullptr;
+
+    std::string nameId = countryNameId(country);
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT(LOCALE, DESCRIPTION_COUNTRY);
+    attr.displayName = UA_LOCALIZEDTEXT(LOCALE, const_cast<char*>(country.getName().c_str()));
+
+    node->nodeId = modelNodeId(nameId);
+    UA_StatusCode retval = setBrowseName(node, country.getName().c_str());
+    retval |= UA_Node_setAttributes(node, &attr, &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES]);
+    retval |= addReference(node, UA_NS0ID_HASTYPEDEFINITION, false, UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE));
+    retval |= addReference(node, UA_NS0ID_ORGANIZES, true, modelNodeId(CountryData::COUNTRIES_FOLDER_NODE_ID));
+
+    std::vector<UA_NodeId> variableIds;
+    for (auto& variable : COUNTRY_VARIABLES)
+      variableIds.push_back(modelNodeId(nameId + "." + variable.browseName));
+    retval |= addReferences(node, UA_NS0ID_HASCOMPONENT, false, variableIds);
+
+    std::vector<UA_NodeId> locationIds;
+    locationIds.reserve(country.getLocations().size());
+    for (auto& itLocation : country.getLocations()) {
+      if (itLocation.second.getIsInitialized())
+        locationIds.push_back(modelNodeId(nameId + "." + itLocation.first));
+    }
+    retval |= addReferences(node, UA_NS0ID_ORGANIZES, false, locationIds);
+
+    if (retval != UA_STATUSCODE_GOOD) {
+      deleteNode(this, node);
+      return nullptr;
+    }
+    return node;
+  }
+
+  UA_Node* WeatherNodestore::createCountryVariableNode(CountryData& country, const std::string& variableName) {
+    const VariableDescription* description = findVariable(COUNTRY_VARIABLES, variableName);
+    UA_Node* node = newNode(this, UA_NODECLASS_VARIABLE);
+    if (!node)
+      return nullptr;
+
+    std::string parentNameId = countryNameId(country);
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT(LOCALE, const_cast<char*>(description->description));
+    attr.displayName = UA_LOCALIZEDTEXT(LOCALE, const_cast<char*>(description->browseName));
+    attr.dataType = description->dataType->typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+
+    // Values are taken from the data model every time the node is synthesised.
+    UA_String stringValue;
+    UA_UInt32 numberValue = 0;
+    if (variableName == CountryData::BROWSE_NAME) {
+      stringValue = UA_STRING(const_cast<char*>(country.getName().c_str()));
+      UA_Variant_setScalar(&attr.value, &stringValue, &UA_TYPES[UA_TYPES_STRING]);
+    }
+    else if (variableName == CountryData::BROWSE_CODE) {
+      stringValue = UA_STRING(const_cast<char*>(country.getCode().c_str()));
+      UA_Variant_setScalar(&attr.value, &stringValue, &UA_TYPES[UA_TYPES_STRING]);
+    }
+    else {
+      numberValue = variableName == CountryData::BROWSE_CITIES_NUMBER ? country.getCitiesNumber() : country.getLocationsNumber();
+      UA_Variant_setScalar(&attr.value, &numberValue, &UA_TYPES[UA_TYPES_UINT32]);
+    }
+
+    node->nodeId = modelNodeId(parentNameId + "." + variableName);
+    UA_StatusCode retval = setBrowseName(node, description->browseName);
+    retval |= UA_Node_setAttributes(node, &attr, &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES]);
+    retval |= addReference(node, UA_NS0ID_HASTYPEDEFINITION, false, UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE));
+    retval |= addReference(node, UA_NS0ID_HASCOMPONENT, true, modelNodeId(parentNameId));
+
+    if (retval != UA_STATUSCODE_GOOD) {
+      deleteNode(this, node);
+      return nullptr;
+    }
+    return node;
+  }
+
+  UA_Node* WeatherNodestore::createLocationNode(LocationData& location) {
+    UA_Node* node = newNode(this, UA_NODECLASS_OBJECT);
+    if (!node)
+      return nullptr;
+
+    std::string nameId = locationNameId(location);
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT(LOCALE, DESCRIPTION_LOCATION);
+    attr.displayName = UA_LOCALIZEDTEXT(LOCALE, const_cast<char*>(location.getName().c_str()));
+
+    node->nodeId = modelNodeId(nameId);
+    UA_StatusCode retval = setBrowseName(node, location.getName().c_str());
+    retval |= UA_Node_setAttributes(node, &attr, &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES]);
+    retval |= addReference(node, UA_NS0ID_HASTYPEDEFINITION, false, UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+    retval |= addReference(node, UA_NS0ID_ORGANIZES, true,
+      modelNodeId(std::string(CountryData::COUNTRIES_FOLDER_NODE_ID) + "." + location.getCountryCode()));
+
+    std::vector<UA_NodeId> variableIds;
+    for (auto& variable : LOCATION_VARIABLES)
+      variableIds.push_back(modelNodeId(nameId + "." + variable.browseName));
+    retval |= addReferences(node, UA_NS0ID_HASCOMPONENT, false, variableIds);
+
+    if (retval != UA_STATUSCODE_GOOD) {
+      deleteNode(this, node);
+      return nullptr;
+    }
+    return node;
+  }
+
+  UA_Node* WeatherNodestore::createLocationVariableNode(LocationData& location, const std::string& variableName) {
+    const VariableDescription* description = findVariable(LOCATION_VARIABLES, variableName);
+    UA_Node* node = newNode(this, UA_NODECLASS_VARIABLE);
+    if (!node)
+      return nullptr;
+
+    std::string parentNameId = locationNameId(location);
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT(LOCALE, const_cast<char*>(description->description));
+    attr.displayName = UA_LOCALIZEDTEXT(LOCALE, const_cast<char*>(description->browseName));
+    attr.dataType = description->dataType->typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+
+    UA_Boolean flagInitializeValue = true;
+    bool isFlagInitialize = variableName == LocationData::BROWSE_FLAG_INITIALIZE;
+    if (isFlagInitialize)
+      UA_Variant_setScalar(&attr.value, &flagInitializeValue, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    else
+      attr.minimumSamplingInterval = WEATHER_MINIMUM_SAMPLING_INTERVAL;
+
+    node->nodeId = modelNodeId(parentNameId + "." + variableName);
+    UA_StatusCode retval = setBrowseName(node, description->browseName);
+    retval |= UA_Node_setAttributes(node, &attr, &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES]);
+    retval |= addReference(node, UA_NS0ID_HASTYPEDEFINITION, false, UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE));
+    retval |= addReference(node, UA_NS0ID_HASCOMPONENT, true, modelNodeId(parentNameId));
+
+    // Weather variables are read through the data source, with the location as the node context.
+    if (!isFlagInitialize) {
+      UA_VariableNode* variableNode = reinterpret_cast<UA_VariableNode*>(node);
+      UA_DataValue_deleteMembers(&variableNode->value.data.value);
+      variableNode->valueSource = UA_VALUESOURCE_DATASOURCE;
+      variableNode->value.dataSource = weatherDataSource;
+      node->context = &location;
+    }
+
+    if (retval != UA_STATUSCODE_GOOD) {
+      deleteNode(this, node);
+      return nullptr;
+    }
+    return node;
+  }
+
+  void WeatherNodestore::notifyWeatherChanged(UA_Server* server, const std::string& countryCode, const std::string& locationName) {
+    std::string parentNameId = std::string(CountryData::COUNTRIES_FOLDER_NODE_ID) + "." + countryCode + "." + locationName;
+    for (auto& variable : LOCATION_VARIABLES) {
+      if (std::strcmp(variable.browseName, LocationData::BROWSE_FLAG_INITIALIZE) == 0)
+        continue;
+      UA_NodeId nodeId = modelNodeId(parentNameId + "." + variable.browseName);
+      UA_Server_notifyValueChange(server, nodeId);
+      UA_NodeId_deleteMembers(&nodeId);
+    }
+  }
+
+  void WeatherNodestore::deleteNodestore(void* context) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (store->defaultNodestore.deleteNodestore)
+      store->defaultNodestore.deleteNodestore(store->defaultNodestore.context);
+    memset(&store->defaultNodestore, 0, sizeof(store->defaultNodestore));
+  }
+
+  UA_Node* WeatherNodestore::newNode(void* context, UA_NodeClass nodeClass) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    return store->defaultNodestore.newNode(store->defaultNodestore.context, nodeClass);
+  }
+
+  void WeatherNodestore::deleteNode(void* context, UA_Node* node) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    store->defaultNodestore.deleteNode(store->defaultNodestore.context, node);
+  }
+
+  void WeatherNodestore::lockModel() {
+    if (modelNodesInUse++ == 0)
+      webService.getModelMutex().lock_shared();
+  }
+
+  void WeatherNodestore::unlockModel() {
+    if (--modelNodesInUse == 0)
+      webService.getModelMutex().unlock_shared();
+  }
+
+  const UA_Node* WeatherNodestore::getNode(void* context, const UA_NodeId* nodeId) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (!isModelNodeId(*nodeId))
+      return store->defaultNodestore.getNode(store->defaultNodestore.context, nodeId);
+
+    store->lockModel();
+    ModelNode modelNode = store->resolve(*nodeId);
+    UA_Node* node = store->createNode(modelNode);
+    if (!node)
+      store->unlockModel();
+    else if (modelNode.kind == ModelNode::Kind::CountriesFolder)
+      store->countriesFolderInUse++;
+    return node;
+  }
+
+  void WeatherNodestore::releaseNode(void* context, const UA_Node* node) {
+    if (!node)
+      return;
+
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (!isModelNodeId(node->nodeId)) {
+      store->defaultNodestore.releaseNode(store->defaultNodestore.context, node);
+      return;
+    }
+
+    // Synthesised nodes are owned by the caller of getNode only, release deletes them.
+    const UA_String& identifier = node->nodeId.identifier.string;
+    if (identifier.length == strlen(CountryData::COUNTRIES_FOLDER_NODE_ID) && store->countriesFolderInUse > 0)
+      store->countriesFolderInUse--;
+    deleteNode(context, const_cast<UA_Node*>(node));
+    store->unlockModel();
+  }
+
+  UA_StatusCode WeatherNodestore::getNodeCopy(void* context, const UA_NodeId* nodeId, UA_Node** outNode) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (!isModelNodeId(*nodeId))
+      return store->defaultNodestore.getNodeCopy(store->defaultNodestore.context, nodeId, outNode);
+
+    // A synthesised node is a copy already.
+    store->lockModel();
+    *outNode = store->createNode(store->resolve(*nodeId));
+    store->unlockModel();
+    return *outNode ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADNODEIDUNKNOWN;
+  }
+
+  UA_StatusCode WeatherNodestore::insertNode(void* context, UA_Node* node, UA_NodeId* addedNodeId) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (!isModelNodeId(node->nodeId))
+      return store->defaultNodestore.insertNode(store->defaultNodestore.context, node, addedNodeId);
+
+    // Nodes of the model exist implicitly, they are generated from the data model.
+    deleteNode(context, node);
+    return UA_STATUSCODE_BADNODEIDEXISTS;
+  }
+
+  UA_StatusCode WeatherNodestore::replaceNode(void* context, UA_Node* node) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (!isModelNodeId(node->nodeId))
+      return store->defaultNodestore.replaceNode(store->defaultNodestore.context, node);
+
+    // The data model is the only source of the nodes, edits of the synthesised copy cannot be stored.
+    deleteNode(context, node);
+    return UA_STATUSCODE_BADNOTWRITABLE;
+  }
+
+  UA_StatusCode WeatherNodestore::removeNode(void* context, const UA_NodeId* nodeId) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (!isModelNodeId(*nodeId))
+      return store->defaultNodestore.removeNode(store->defaultNodestore.context, nodeId);
+    return UA_STATUSCODE_BADNOTSUPPORTED;
+  }
+
+  void WeatherNodestore::notifyBrowse(void* context, const UA_NodeId* nodeId) {
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    if (!store->prefetcher || !isModelNodeId(*nodeId))
+      return;
+
+    // Nodes are synthesised for attribute reads and descriptions of references as well, only a browse is counted.
+    std::string nodeIdName(reinterpret_cast<char*>(nodeId->identifier.string.data), nodeId->identifier.string.length);
+    bool isCountriesFolder = nodeIdName == CountryData::COUNTRIES_FOLDER_NODE_ID;
+    if (!isCountriesFolder && nodeIdName.size() != 12)
+      return;
+
+    store->lockModel();
+    if (isCountriesFolder) {
+      store->prefetcher->onCountriesFolderAccess();
+    }
+    else {
+      auto& countries = store->webService.getAllCountries();
+      auto itCountry = countries.find(nodeIdName.substr(10, 2));
+      if (itCountry != countries.end() && itCountry->second.getIsInitialized())
+        store->prefetcher->onCountryAccess(itCountry->second);
+    }
+    store->unlockModel();
+  }
+
+  void WeatherNodestore::iterate(void* context, void* visitorContext, UA_NodestoreVisitor visitor) {
+    // Only stored nodes are visited, the synthesised model would be generated completely otherwise.
+    WeatherNodestore* store = static_cast<WeatherNodestore*>(context);
+    store->defaultNodestore.iterate(store->defaultNodestore.context, visitorContext, visitor);
+  }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include "open62541.h"
+
+#include "WebService.h"
+#include "ModelCache.h"
+#include "Prefetcher.h"
+
+namespace weatherserver {
+
+  /*
+  Nodestore for the weather part of the OPC UA information model (namespace WebService::OPC_NS_INDEX).
+
+  Country, location and weather variable nodes are never inserted into the default UA_NodeMap. They are synthesised
+  on every getNode call from the in-memory data model kept by the WebService and deleted again on releaseNode.
+  Therefore the number of nodes does not grow with usage, no matter how much of the world is browsed by clients.
+  Browsing a node synthesises only the node itself while its references are unchanged, the descriptions of the children
+  are kept by the browse cache of the server (UA_Server_browseCacheSize).
+
+  All other nodes (namespace 0 and everything outside of the "Countries" hierarchy) are delegated to the default nodestore.
+  Synthesised nodes cannot be edited: attribute writes and reference changes on them fail with BadNotWritable.
+
+  The NodeId of every node of the model is composed as: Countries.CountryCode.LocationName.Variable
+  */
+  class WeatherNodestore {
+
+  public:
+
+    /*
+    Called when a country or a node below it is accessed and locations for this country were not downloaded yet.
+    Must not block: the download is only requested, until it completes the country is browsed without locations.
+    */
+    typedef std::function<void(CountryData& country)> LocationsLoader;
+
+    /*
+    @param webService - service holding the data model the nodes are generated from.
+    @param weatherDataSource - data source used for every weather variable node. Node context is the LocationData object.
+    @param locationsLoader - callback to request download of locations of the country on first access.
+    */
+    WeatherNodestore(WebService& webService, const UA_DataSource& weatherDataSource, const LocationsLoader& locationsLoader);
+
+    /*
+    Take over the nodestore of the server configuration. The original (default) nodestore is used for all nodes that are
+    not part of the weather model. Has to be called before UA_Server_new, the object has to outlive the configuration.
+    */
+    void attach(UA_Nodestore& nodestore);
+
+    /*
+    Add the reference from the standard Objects folder to the "Countries" folder. Has to be called after UA_Server_new,
+    before the server runs.
+    */
+    UA_StatusCode linkToObjectsFolder();
+
+    //Report every access to countries and locations to the cache, so least recently used ones can be evicted.
+    void setModelCache(ModelCache* cache) { modelCache = cache; }
+
+    //Report browsing of the "Countries" folder and of countries to the prefetch policy.
+    void setPrefetcher(Prefetcher* policy) { prefetcher = policy; }
+
+    //Returns true if the node id belongs to the synthesised part of the information model.
+    static bool isModelNodeId(const UA_NodeId& nodeId);
+
+    /*
+    Publish the weather data of the location to the MonitoredItems on its weather variables right away, after it was replaced.
+    Has to be called from the thread running the server.
+    */
+    static void notifyWeatherChanged(UA_Server* server, const std::string& countryCode, const std::string& locationName);
+
+    //C-style strings representing display names and descriptions of the nodes in OPC UA information model.
+    static char DESCRIPTION_COUNTRIES_FOLDER[];
+    static char DESCRIPTION_COUNTRY[];
+    static char DESCRIPTION_LOCATION[];
+
+  private:
+
+    //Part of the data model a node id is referring to.
+    struct ModelNode {
+      enum class Kind { None, CountriesFolder, Country, CountryVariable, Location, LocationVariable };
+
+      Kind kind = Kind::None;
+      CountryData* country = nullptr;
+      LocationData* location = nullptr;
+      std::string variableName;
+    };
+
+    /*
+    Parse node id and search for the country / location in the data model.
+    Download of locations of the country is requested on first access to the country or any node below it.
+    */
+    ModelNode resolve(const UA_NodeId& nodeId);
+
+    UA_Node* createNode(const ModelNode& modelNode);
+    UA_Node* createCountriesFolderNode();
+    UA_Node* createCountryNode(CountryData& country);
+    UA_Node* createCountryVariableNode(CountryData& country, const std::string& variableName);
+    UA_Node* createLocationNode(LocationData& location);
+    UA_Node* createLocationVariableNode(LocationData& location, const std::string& variableName);
+
+    // ########## UA_Nodestore interface, context is the WeatherNodestore object.
+    static void deleteNodestore(void* context);
+    static UA_Node* newNode(void* context, UA_NodeClass nodeClass);
+    static void deleteNode(void* context, UA_Node* node);
+    static const UA_Node* getNode(void* context, const UA_NodeId* nodeId);
+    static void releaseNode(void* context, const UA_Node* node);
+    static UA_StatusCode getNodeCopy(void* context, const UA_NodeId* nodeId, UA_Node** outNode);
+    static UA_StatusCode insertNode(void* context, UA_Node* node, UA_NodeId* addedNodeId);
+    static UA_StatusCode replaceNode(void* context, UA_Node* node);
+    static UA_StatusCode removeNode(void* context, const UA_NodeId* nodeId);
+    static void iterate(void* context, void* visitorContext, UA_NodestoreVisitor visitor);
+    static void notifyBrowse(void* context, const UA_NodeId* nodeId);
+
+    WebService& webService;
+    UA_DataSource weatherDataSource;
+    LocationsLoader locationsLoader;
+    UA_Nodestore defaultNodestore;
+    ModelCache* modelCache{ nullptr };
+    Prefetcher* prefetcher{ nullptr };
+
+    //Hold the data model lock shared while synthesised nodes are in use. Nodes can be nested, e.g. during browse.
+    void lockModel();
+    void unlockModel();
+
+    /*
+    Number of "Countries" folder nodes currently handed out by getNode. While the folder is held (it is being browsed),
+    its country nodes are only described and must not trigger the download of their locations.
+    */
+    size_t countriesFolderInUse{ 0 };
+
+    //Number of synthesised nodes currently handed out by getNode. A nodestore is used by one server thread only.
+    size_t modelNodesInUse{ 0 };
+  };
+}
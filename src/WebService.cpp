@@ -46,7 +46,7 @@ namespace weatherserver {
         });
   }
 
-  web::json::value WebService::fetchAllLocations(const std::string& countryName, const uint32_t limit) {
+  pplx::task<web::json::value> WebService::fetchAllLocations(const std::string& countryName, const uint32_t limit) {
 
     web::uri_builder uriBuilder(ENDPOINT_API_OPENAQ);
     uriBuilder.append_path(PATH_API_OPENAQ_LOCATIONS);
@@ -55,45 +55,28 @@ namespace weatherserver {
 
     web::http::client::http_client client(uriBuilder.to_string());
 
-    web::json::value allLocations;
-
-    try {
-
-        allLocations = client.request(web::http::methods::GET)
-        .then([this, &countryName, limit](web::http::http_response requestResponse)
-          {
-            std::cout << "fetchAllLocations() request completed!" << std::endl;
-
-            return requestResponse.extract_json();
-          })
-        .then([this, &countryName, limit](web::json::value jsonValue)
-          {
-            std::cout << "JSON extracted from fetchAllLocations() completed!" << std::endl;
-
-            auto metaData = jsonValue.at(U("meta"));
-            size_t foundResultsNumber = metaData.at(U("found")).as_integer();
-
-            web::json::value result;
-
-            if (foundResultsNumber <= limit) {
-              result = jsonValue.at(U("results"));
-            }
-            else {
-              result = this->fetchAllLocations(countryName, foundResultsNumber);
-            }
-
-            return result;
-          }).get();
-
-    }
-    catch (const std::exception & e) {
-      UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_NETWORK,
-        "Error on fetchAllLocations method!");
-      UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_NETWORK,
-        e.what());
-      return web::json::value();
-    }
-    return allLocations;
+    //The task outlives this call, so the country code is captured by value.
+    std::string countryCode = countryName;
+
+    return client.request(web::http::methods::GET)
+      .then([](web::http::http_response requestResponse)
+        {
+          std::cout << "fetchAllLocations() request completed!" << std::endl;
+
+          return requestResponse.extract_json();
+        })
+      .then([this, countryCode, limit](web::json::value jsonValue)
+        {
+          std::cout << "JSON extracted from fetchAllLocations() completed!" << std::endl;
+
+          auto metaData = jsonValue.at(U("meta"));
+          size_t foundResultsNumber = metaData.at(U("found")).as_integer();
+
+          if (foundResultsNumber <= limit)
+            return pplx::task_from_result(jsonValue.at(U("results")));
+
+          return this->fetchAllLocations(countryCode, static_cast<uint32_t>(foundResultsNumber));
+        });
   }
 
   pplx::task<web::json::value> WebService::fetchWeather(const double latitude, const double longitude) {
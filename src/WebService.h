@@ -9,6 +9,7 @@
 #include "LocationData.h"
 #include "WeatherData.h"
 #include <memory>
+#include <shared_mutex>
 
 namespace weatherserver {
 
@@ -34,11 +35,11 @@ namespace weatherserver {
 
     @param countryCode - two letter ISO code that represents the country.
     @param limit - number of locations to be returned. Default = 100 and max = 10000.
-    @return JSON array value containing all location data objects.
+    @return task for JSON array value containing all location data objects.
 
     Check the LocationData class to see the JSON representation.
     */
-    web::json::value fetchAllLocations(const std::string& countryCode, const uint32_t limit = 100);
+    pplx::task<web::json::value> fetchAllLocations(const std::string& countryCode, const uint32_t limit = 100);
 
     /*
     Makes http requests to Dark Sky API to fetch weather data for a specific location specified by latitude and longitude.
@@ -56,6 +57,12 @@ namespace weatherserver {
     std::shared_ptr<Settings> getSettings() { return settings; }
     std::map<std::string, CountryData>& getAllCountries() { return fetchedAllCountries; }
 
+    /*
+    Lock of the data model (locations of the countries and their weather data) for several server event loops.
+    It is held shared while nodes referring to the data model are in use and exclusively to change the data model.
+    */
+    std::shared_timed_mutex& getModelMutex() { return modelMutex; }
+
     //String constants for API services: endpoints, keys, paths, queries etc.
     static const uint16_t OPC_NS_INDEX;
     static const utility::string_t ENDPOINT_API_OPENAQ;
@@ -88,5 +95,6 @@ namespace weatherserver {
     UA_Server* server{ nullptr };
     std::shared_ptr<Settings> settings;
     std::map<std::string, CountryData> fetchedAllCountries;
+    std::shared_timed_mutex modelMutex;
   };
 }
@@ -41,6 +41,7 @@
 #include "open62541.h"
 int custom_port_number = 48484;
 const char* custom_endpoint_url = "opc.tcp://localhost:48484";
+int custom_reuse_port = 0;
 
 /*********************************** amalgamated original file "/home/travis/build/open62541/open62541/deps/queue.h" ***********************************/
 
@@ -906,6 +907,101 @@ UA_atomic_subSize(volatile size_t *addr, size_t decrease) {
 #endif
 }
 
+/* Sequentially consistent load of a word (for lock-free free lists) */
+static UA_INLINE size_t
+UA_atomic_loadSize(volatile size_t *addr) {
+#ifndef UA_ENABLE_MULTITHREADING
+    return *addr;
+#else
+# ifdef _MSC_VER /* Visual Studio */
+    size_t value = *addr;
+    MemoryBarrier();
+    return value;
+# else /* GCC/Clang */
+    return __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+# endif
+#endif
+}
+
+static UA_INLINE void
+UA_atomic_storePtr(void * volatile *addr, void *value) {
+#ifndef UA_ENABLE_MULTITHREADING
+    *addr = value;
+#else
+# ifdef _MSC_VER /* Visual Studio */
+    MemoryBarrier();
+    *addr = value;
+    MemoryBarrier();
+# else /* GCC/Clang */
+    __atomic_store_n(addr, value, __ATOMIC_SEQ_CST);
+# endif
+#endif
+}
+
+/* Returns true if the value was exchanged */
+static UA_INLINE UA_Boolean
+UA_atomic_cmpxchgSize(volatile size_t *addr, size_t expected, size_t newvalue) {
+#ifndef UA_ENABLE_MULTITHREADING
+    if(*addr != expected)
+        return false;
+    *addr = newvalue;
+    return true;
+#else
+# ifdef _MSC_VER /* Visual Studio */
+    return _InterlockedCompareExchangePointer((void * volatile *)addr, (void*)newvalue,
+                                              (void*)expected) == (void*)expected;
+# else /* GCC/Clang */
+    return __sync_bool_compare_and_swap(addr, expected, newvalue);
+# endif
+#endif
+}
+
+/* Lock-free Free List
+ * -------------------
+ * Free list of the slots of a memory pool. The head holds the first free slot
+ * plus one in the lower half (0 for the empty list) and a tag in the upper
+ * half. The tag changes with every pop, so that the head is updated with a
+ * single compare-and-swap without the ABA problem. The links between the free
+ * slots (the next slot plus one, 0 at the end) are kept by the pool and found
+ * with the nextFree callback. */
+
+#define UA_FREELIST_SLOTBITS (sizeof(size_t) * 4)
+#define UA_FREELIST_SLOTMASK (((size_t)1 << UA_FREELIST_SLOTBITS) - 1)
+#define UA_FREELIST_MAXSLOTS (UA_FREELIST_SLOTMASK - 1)
+
+typedef volatile UA_UInt32 * (*UA_FreeList_nextFree)(void *context, size_t slot);
+
+/* Returns false if the list is empty */
+static UA_INLINE UA_Boolean
+UA_FreeList_pop(volatile size_t *head, UA_FreeList_nextFree nextFree,
+                void *context, size_t *slot) {
+    size_t oldHead, newHead, first;
+    do {
+        oldHead = UA_atomic_loadSize(head);
+        first = oldHead & UA_FREELIST_SLOTMASK;
+        if(first == 0)
+            return false;
+        /* The slot may be taken in between. Then the link is stale, but the
+         * tag has changed and the exchange fails. */
+        newHead = ((oldHead & ~UA_FREELIST_SLOTMASK) + UA_FREELIST_SLOTMASK + 1) |
+            *nextFree(context, first - 1);
+    } while(!UA_atomic_cmpxchgSize(head, oldHead, newHead));
+    *slot = first - 1;
+    return true;
+}
+
+/* Push the chain of slots from first to last, already linked */
+static UA_INLINE void
+UA_FreeList_push(volatile size_t *head, UA_FreeList_nextFree nextFree,
+                 void *context, size_t first, size_t last) {
+    size_t oldHead, newHead;
+    do {
+        oldHead = UA_atomic_loadSize(head);
+        *nextFree(context, last) = (UA_UInt32)(oldHead & UA_FREELIST_SLOTMASK);
+        newHead = (oldHead & ~UA_FREELIST_SLOTMASK) | (first + 1);
+    } while(!UA_atomic_cmpxchgSize(head, oldHead, newHead));
+}
+
 /* Utility Functions
  * ----------------- */
 
@@ -994,6 +1090,33 @@ UA_decodeBinary(const UA_ByteString *src, size_t *offset, void *dst,
                 const UA_DataType *type, size_t customTypesSize,
                 const UA_DataType *customTypes) UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
+/* Bump allocator for decoded values. Memory is taken from blocks that are
+ * released all at once with UA_Arena_reset. The arena is not thread-safe. */
+typedef struct UA_ArenaBlock UA_ArenaBlock;
+
+typedef struct {
+    UA_ArenaBlock *blocks; /* The block allocated from first */
+    size_t maxRetained; /* Kept by UA_Arena_reset up to this size */
+} UA_Arena;
+
+void UA_Arena_init(UA_Arena *arena, size_t maxRetained);
+
+/* Frees everything allocated from the arena. A single block is kept for the
+ * next use if it is not larger than maxRetained. */
+void UA_Arena_reset(UA_Arena *arena);
+
+void UA_Arena_deleteMembers(UA_Arena *arena);
+
+/* Decodes like UA_decodeBinary, but all memory of the decoded value is taken
+ * from the arena. The value must not be deleted with UA_deleteMembers. It is
+ * valid until the arena is reset. If decoding fails, the value is zeroed and
+ * the memory is only released with the arena. */
+UA_StatusCode
+UA_decodeBinaryArena(const UA_ByteString *src, size_t *offset, void *dst,
+                     const UA_DataType *type, size_t customTypesSize,
+                     const UA_DataType *customTypes,
+                     UA_Arena *arena) UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
 /* Returns the number of bytes the value p takes in binary encoding. Returns
  * zero if an error occurs. UA_calcSizeBinary is thread-safe and reentrant since
  * it does not access global (thread-local) variables. */
@@ -3683,8 +3806,9 @@ typedef UA_StatusCode (*UA_Connection_processChunk)(void *application,
  *
  * If an entire chunk is received, it is forwarded directly. But the memory
  * needs to be freed with the networklayer-specific mechanism. If a half message
- * is received, we copy it into a local buffer. Then, the stack-specific free
- * needs to be used.
+ * is received, we copy it into a local buffer that has the size of the chunk.
+ * Only the missing bytes are copied from the next packet. Then, the
+ * stack-specific free needs to be used.
  *
  * @param connection The connection
  * @param application The client or server application
@@ -3769,17 +3893,14 @@ typedef struct UA_SessionHeader {
     UA_SecureChannel *channel; /* The pointer back to the SecureChannel in the session. */
 } UA_SessionHeader;
 
-/* For chunked requests */
-struct ChunkPayload {
-    SIMPLEQ_ENTRY(ChunkPayload) pointers;
-    UA_ByteString bytes;
-};
-
+/* For chunked requests. The chunk bodies are appended to a single buffer that
+ * is handed to the decoder once the final chunk arrives. */
 struct MessageEntry {
     LIST_ENTRY(MessageEntry) pointers;
     UA_UInt32 requestId;
-    SIMPLEQ_HEAD(chunkpayload_pointerlist, ChunkPayload) chunkPayload;
-    size_t chunkPayloadSize;
+    UA_ByteString message; /* The bodies received so far */
+    size_t messageCapacity;
+    size_t chunkCount;
 };
 
 typedef enum {
@@ -3860,7 +3981,11 @@ UA_SecureChannel_sendSymmetricMessage(UA_SecureChannel *channel, UA_UInt32 reque
 
 /* The MessageContext is forwarded into the encoding layer so that we can send
  * chunks before continuing to encode. This lets us reuse a fixed chunk-sized
- * messages buffer. */
+ * messages buffer. If the connection sends several chunks at once, finished
+ * chunks are queued and sent together when the message is complete or the
+ * queue is full. */
+#define UA_MESSAGECONTEXT_MAXQUEUEDCHUNKS 16
+
 typedef struct {
     UA_SecureChannel *channel;
     UA_UInt32 requestId;
@@ -3873,6 +3998,9 @@ typedef struct {
     UA_Byte *buf_pos;
     const UA_Byte *buf_end;
 
+    UA_ByteString queuedChunks[UA_MESSAGECONTEXT_MAXQUEUEDCHUNKS];
+    size_t queuedChunksSize;
+
     UA_Boolean final;
 } UA_MessageContext;
 
@@ -4018,30 +4146,56 @@ extern "C" {
  * removing and changing repeated callbacks can be done from independent
  * threads. Processing the changes and dispatching callbacks must be done by a
  * single "mainloop" process.
- * Timer callbacks with the same recurring interval are batched into blocks in
- * order to reduce linear search for re-entry to the sorted list after processing.
- * Callbacks are inserted in reversed order (last callback are put first in the block)
- * to allow the monitored items of a subscription (if created in a sequence with the
- * same publish/sample interval) to be executed before the subscription publish the
- * notifications. When callbacks are entered to the timer list after execution they
- * are added in the same order as before execution. */
+ * The callbacks are kept in a 4-ary min-heap ordered by the execution
+ * timestamp, so adding, removing and rescheduling a callback is O(log n). An
+ * index from the callback id to the entry finds callbacks to be removed or
+ * changed without a search.
+ * The first execution of a callback is moved up to one second earlier if this
+ * aligns it with the callbacks of the same interval added before. Callbacks due
+ * at the same time are executed in reversed order of their registration (last
+ * callback first). This allows the monitored items of a subscription (if
+ * created in a sequence with the same publish/sample interval) to be executed
+ * before the subscription publish the notifications. */
 
 /* Forward declaration */
 struct UA_TimerCallbackEntry;
 typedef struct UA_TimerCallbackEntry UA_TimerCallbackEntry;
 
-/* Linked-list definition */
-typedef SLIST_HEAD(UA_TimerCallbackList, UA_TimerCallbackEntry) UA_TimerCallbackList;
+/* Phase of a recently added repeated interval */
+typedef struct {
+    UA_UInt64 interval;
+    UA_DateTime nextTime;
+} UA_TimerPhase;
+
+#define UA_TIMER_PHASES 16
 
 typedef struct {
-    /* The linked list of callbacks is sorted according to the execution timestamp. */
-    UA_TimerCallbackList repeatedCallbacks;
+    /* The heap of callbacks is ordered according to the execution timestamp. */
+    UA_TimerCallbackEntry **heap;
+    size_t heapSize;
+    size_t heapCapacity;
+
+    /* Callbacks by id. Open addressing with linear probing, the size is a
+     * power of two (or zero). */
+    UA_TimerCallbackEntry **ids;
+    size_t idsSize;
+    size_t idsBits;
+    size_t idsCount;
+
+    /* Phases of the intervals added last, to batch callbacks with the same
+     * interval */
+    UA_TimerPhase phases[UA_TIMER_PHASES];
+    size_t nextPhase;
 
     /* Changes to the repeated callbacks in a multi-producer single-consumer queue */
     UA_TimerCallbackEntry * volatile changes_head;
     UA_TimerCallbackEntry *changes_tail;
     UA_TimerCallbackEntry *changes_stub;
 
+    /* Dequeued change that could not be applied for lack of memory. It is
+     * retried before the queue is processed further. */
+    UA_TimerCallbackEntry *pendingChange;
+
     UA_UInt64 idCounter;
 } UA_Timer;
 
@@ -4148,6 +4302,8 @@ typedef struct {
     UA_UInt32        numSubscriptions;
     UA_UInt32        numPublishReq;
     size_t           totalRetransmissionQueueSize; /* Retransmissions of all subscriptions */
+    TAILQ_HEAD(UA_SessionRetransmissionQueue, UA_NotificationMessageEntry)
+                     retransmissionQueue; /* Of all subscriptions, oldest first */
 #endif
 } UA_Session;
 
@@ -4268,6 +4424,39 @@ UA_PublishResponseEntry* UA_Session_dequeuePublishReq(UA_Session *session);
 
 
 
+/*************/
+/* BlockPool */
+/*************/
+
+/* Notifications and retransmitted messages are taken from pools of equally
+ * sized blocks of the server instead of being allocated one by one. Blocks are
+ * cut from slabs of UA_BLOCKPOOL_SLABSIZE blocks. The slabs are allocated on
+ * demand up to the maximum number of blocks of the pool and kept until the
+ * pool is deleted. Beyond the maximum, blocks are allocated and freed on their
+ * own.
+ *
+ * Like the buffer pool of the network layer, the free blocks form a lock-free
+ * free list, also when the sample and publish callbacks run in worker
+ * threads. */
+
+#define UA_BLOCKPOOL_SLABSIZE 64
+
+typedef struct {
+    size_t blockSize; /* Including the header */
+    size_t maxSlabs;
+    volatile size_t freeHead;
+    volatile size_t slabsUsed;
+    UA_Byte **slabs;
+} UA_BlockPool;
+
+void UA_BlockPool_init(UA_BlockPool *pool, size_t size, size_t maxBlocks);
+
+/* Run only when no block is in use anymore */
+void UA_BlockPool_deleteMembers(UA_BlockPool *pool);
+
+void * UA_BlockPool_alloc(UA_BlockPool *pool);
+void UA_BlockPool_free(UA_BlockPool *pool, void *p);
+
 /**
  * MonitoredItems create Notifications. Subscriptions collect Notifications from
  * (several) MonitoredItems and publish them to the client.
@@ -4338,11 +4527,33 @@ struct UA_MonitoredItem {
     UA_ByteString lastSampledValue;
     UA_Boolean sampleCallbackIsRegistered;
 
+    /* Sample Group (instead of an own sample callback) */
+    struct UA_SampleGroup *sampleGroup;
+    LIST_ENTRY(UA_MonitoredItem) sampleGroupEntry;
+
     /* Notification Queue */
     NotificationQueue queue;
     UA_UInt32 queueSize;
 };
 
+/* MonitoredItems sampling the value of the same node with the same settings
+ * share one repeated callback. The value is read and encoded once per interval
+ * and the sample is handed to every member. The groups are kept in a hash map
+ * of the server. */
+typedef struct UA_SampleGroup {
+    struct UA_SampleGroup *next; /* In the same bucket of the hash map */
+    UA_UInt32 hash;
+
+    /* Settings */
+    UA_NodeId nodeId;
+    UA_String indexRange;
+    UA_TimestampsToReturn timestampsToReturn;
+    UA_Double samplingInterval; // [ms]
+
+    UA_UInt64 sampleCallbackId;
+    LIST_HEAD(UA_ListOfSampleGroupMembers, UA_MonitoredItem) members;
+} UA_SampleGroup;
+
 UA_MonitoredItem * UA_MonitoredItem_new(UA_MonitoredItemType);
 void MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem);
 void UA_MonitoredItem_SampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem);
@@ -4351,7 +4562,7 @@ UA_StatusCode MonitoredItem_unregisterSampleCallback(UA_Server *server, UA_Monit
 
 /* Remove entries until mon->maxQueueSize is reached. Sets infobits for lost
  * data if required. */
-void MonitoredItem_ensureQueueSpace(UA_MonitoredItem *mon);
+void MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon);
 
 /****************/
 /* Subscription */
@@ -4359,6 +4570,8 @@ void MonitoredItem_ensureQueueSpace(UA_MonitoredItem *mon);
 
 typedef struct UA_NotificationMessageEntry {
     TAILQ_ENTRY(UA_NotificationMessageEntry) listEntry;
+    TAILQ_ENTRY(UA_NotificationMessageEntry) sessionEntry; /* Oldest first */
+    UA_Subscription *sub;
     UA_NotificationMessage message;
 } UA_NotificationMessageEntry;
 
@@ -4395,6 +4608,8 @@ struct UA_Subscription {
     /* Publish Callback */
     UA_UInt64 publishCallbackId;
     UA_Boolean publishCallbackIsRegistered;
+    UA_DateTime publishDeferredSince; /* Waiting for a batch of notifications
+                                       * since then, otherwise 0 */
 
     /* MonitoredItems */
     UA_UInt32 lastMonitoredItemId; /* increase the identifiers */
@@ -4405,6 +4620,7 @@ struct UA_Subscription {
     NotificationQueue notificationQueue;
     UA_UInt32 notificationQueueSize;
     UA_UInt32 readyNotifications; /* Notifications to be sent out now (already late) */
+    UA_DateTime lastNotificationTime; /* Monotonic, only with a batch window */
 
     /* Retransmission Queue */
     ListOfNotificationMessages retransmissionQueue;
@@ -4423,7 +4639,8 @@ UA_Subscription_deleteMonitoredItem(UA_Server *server, UA_Subscription *sub,
                                     UA_UInt32 monitoredItemId);
 
 void UA_Subscription_publish(UA_Server *server, UA_Subscription *sub);
-UA_StatusCode UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequenceNumber);
+UA_StatusCode UA_Subscription_removeRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
+                                                         UA_UInt32 sequenceNumber);
 void UA_Subscription_answerPublishRequestsNoSubscription(UA_Server *server, UA_Session *session);
 UA_Boolean UA_Subscription_reachedPublishReqLimit(UA_Server *server,  UA_Session *session);
 
@@ -4449,6 +4666,8 @@ extern "C" {
 
 typedef struct session_list_entry {
     LIST_ENTRY(session_list_entry) pointers;
+    UA_UInt32 tokenHash; /* Hash of the authentication token */
+    UA_UInt32 idHash; /* Hash of the session id */
     UA_Session session;
 } session_list_entry;
 
@@ -4456,6 +4675,19 @@ typedef struct UA_SessionManager {
     LIST_HEAD(session_list, session_list_entry) sessions; // doubly-linked list of sessions
     UA_UInt32 currentSessionCount;
     UA_Server *server;
+
+    /* Sessions by authentication token and by session id. Open addressing
+     * with linear probing, both have the same size, a power of two (or
+     * zero). */
+    session_list_entry **byToken;
+    session_list_entry **byId;
+    size_t indexSize;
+
+    /* Repeated callback removing the sessions that timed out. It is due at
+     * nextTimeout, which is never after the end of the lifetime of a session.
+     * Lookups don't check the lifetime. */
+    UA_UInt64 timeoutCallbackId;
+    UA_DateTime nextTimeout;
 } UA_SessionManager;
 
 UA_StatusCode
@@ -4466,7 +4698,8 @@ void UA_SessionManager_deleteMembers(UA_SessionManager *sm);
 
 /* Deletes all sessions that have timed out. Deletion is implemented via a
  * delayed callback. So all currently scheduled jobs with a pointer to the
- * session can complete. */
+ * session can complete. Called from the repeated callback of the session
+ * manager, which is then rescheduled for the next session to time out. */
 void UA_SessionManager_cleanupTimedOut(UA_SessionManager *sm,
                                        UA_DateTime nowMonotonic);
 
@@ -4629,6 +4862,50 @@ typedef struct serverOnNetwork_hash_entry {
 #endif /* UA_ENABLE_DISCOVERY_MULTICAST */
 #endif /* UA_ENABLE_DISCOVERY */
 
+/* Browse results are built from the descriptions of the reference targets
+ * kept for the browsed nodes. Otherwise every target has to be taken from the
+ * nodestore for its BrowseName, DisplayName and type definition.
+ *
+ * The descriptions are kept per reference kind of the node and made when the
+ * kind is browsed for the first time. Before they are used, the targets of the
+ * kind are compared with the current targets of the node. So they are built
+ * again whenever the references change. Changes to the attributes of the
+ * targets increase the epoch of the server, which outdates all entries.
+ * Entries are evicted least recently used first, when the number of cached
+ * descriptions exceeds the maximum. */
+typedef struct {
+    UA_NodeId referenceTypeId;
+    UA_Boolean isInverse;
+    UA_ReferenceDescription *targets; /* NULL until the kind was browsed */
+    size_t targetsSize;
+} UA_BrowseCacheKind;
+
+typedef struct UA_BrowseCacheEntry {
+    struct UA_BrowseCacheEntry *next; /* In the same bucket of the hash map */
+    TAILQ_ENTRY(UA_BrowseCacheEntry) lruEntry; /* Most recently used first */
+    UA_UInt32 hash;
+    UA_NodeId nodeId;
+    size_t epoch;
+    size_t kindsSize;
+    UA_BrowseCacheKind *kinds;
+} UA_BrowseCacheEntry;
+
+typedef struct {
+    UA_BrowseCacheEntry **buckets;
+    size_t bucketsSize; /* Number of buckets, a power of two */
+    size_t entriesCount;
+    size_t referencesCount; /* Cached descriptions of all entries */
+    size_t maxReferences;
+    TAILQ_HEAD(UA_BrowseCacheLru, UA_BrowseCacheEntry) lru;
+} UA_BrowseCache;
+
+void UA_BrowseCache_init(UA_BrowseCache *cache, size_t maxReferences);
+void UA_BrowseCache_deleteMembers(UA_BrowseCache *cache);
+
+/* Outdate the cached descriptions after BrowseName, DisplayName or type
+ * definition of a node have changed, or a node was deleted */
+void UA_BrowseCache_invalidate(UA_Server *server);
+
 struct UA_Server {
     /* Meta */
     UA_DateTime startTime;
@@ -4680,6 +4957,17 @@ struct UA_Server {
     /* Delayed callbacks */
     SLIST_HEAD(DelayedCallbacksList, UA_DelayedCallback) delayedCallbacks;
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* MonitoredItems sharing a sample callback */
+    UA_SampleGroup **sampleGroups; /* Buckets of the hash map */
+    size_t sampleGroupsSize; /* Number of buckets, a power of two */
+    size_t sampleGroupsCount;
+
+    /* Notifications and retransmitted messages of all Subscriptions */
+    UA_BlockPool notificationPool;
+    UA_BlockPool retransmissionPool;
+#endif
+
     /* Worker threads */
 #ifdef UA_ENABLE_MULTITHREADING
     UA_Worker *workers; /* there are nThread workers in a running server */
@@ -4696,6 +4984,15 @@ struct UA_Server {
     /* Config */
     UA_ServerConfig config;
 
+    /* Requests are decoded into the arena. Taken while a request is processed,
+     * a concurrent request finding NULL is decoded on the heap. */
+    UA_Arena * volatile requestArena;
+
+    /* Taken while a browse uses it like the arena. A concurrent browse finding
+     * NULL takes the targets from the nodestore. */
+    UA_BrowseCache * volatile browseCache;
+    volatile size_t browseCacheEpoch;
+
     /* Local access to the services (for startup and maintenance) uses this
      * Session with all possible access rights (Session Id: 1) */
     UA_Session adminSession;
@@ -5701,8 +5998,15 @@ UA_findDataType(const UA_NodeId *typeId) {
 /* Random Number Generator */
 /***************************/
 
-//TODO is this safe for multithreading?
-static pcg32_random_t UA_rng = PCG32_INITIALIZER;
+/* Every thread has its own generator state, so that servers can run on
+ * several threads. A thread has to call UA_random_seed before the first use;
+ * UA_Server_new does so for the thread creating the server. */
+#if defined(_MSC_VER)
+# define UA_RNG_THREAD_LOCAL __declspec(thread)
+#else
+# define UA_RNG_THREAD_LOCAL __thread
+#endif
+static UA_RNG_THREAD_LOCAL pcg32_random_t UA_rng = PCG32_INITIALIZER;
 
 void
 UA_random_seed(u64 seed) {
@@ -5952,6 +6256,37 @@ UA_ExpandedNodeId_equal(const UA_ExpandedNodeId *n1, const UA_ExpandedNodeId *n2
     return UA_NodeId_equal(&n1->nodeId, &n2->nodeId);
 }
 
+#ifdef UA_ENABLE_FAST_NODEID_HASH
+/* Word-at-a-time hash: consumes eight bytes per multiplication instead of one.
+ * Words are loaded with memcpy, so the buffer needs no alignment. The hash
+ * depends on the byte order of the platform; it is only used in-process. */
+#define WORDHASH_MUL_1 UINT64_C(0x9E3779B97F4A7C15)
+#define WORDHASH_MUL_2 UINT64_C(0xFF51AFD7ED558CCD)
+#define WORDHASH_MUL_3 UINT64_C(0xC4CEB9FE1A85EC53)
+static u32
+wordHash(u32 seed, const u8 *buf, size_t size) {
+    u64 h = seed ^ ((u64)size * WORDHASH_MUL_1);
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8) {
+        u64 word;
+        memcpy(&word, &buf[i], 8);
+        h = (h ^ word) * WORDHASH_MUL_2;
+        h ^= h >> 29;
+    }
+    if(i < size) {
+        u64 tail = 0;
+        memcpy(&tail, &buf[i], size - i);
+        h = (h ^ tail) * WORDHASH_MUL_2;
+        h ^= h >> 29;
+    }
+    /* Final avalanche (MurmurHash3 fmix64) */
+    h ^= h >> 33;
+    h *= WORDHASH_MUL_3;
+    h ^= h >> 33;
+    return (u32)h;
+}
+#define UA_NODEID_BUFFER_HASH wordHash
+#else
 /* FNV non-cryptographic hash function. See
  * https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function */
 #define FNV_PRIME_32 16777619
@@ -5963,6 +6298,8 @@ fnv32(u32 fnv, const u8 *buf, size_t size) {
     }
     return fnv;
 }
+#define UA_NODEID_BUFFER_HASH fnv32
+#endif
 
 u32
 UA_NodeId_hash(const UA_NodeId *n) {
@@ -5973,9 +6310,9 @@ UA_NodeId_hash(const UA_NodeId *n) {
         return (u32)((n->namespaceIndex + ((n->identifier.numeric * (u64)2654435761) >> (32))) & UINT32_C(4294967295)); /*  Knuth's multiplicative hashing */
     case UA_NODEIDTYPE_STRING:
     case UA_NODEIDTYPE_BYTESTRING:
-        return fnv32(n->namespaceIndex, n->identifier.string.data, n->identifier.string.length);
+        return UA_NODEID_BUFFER_HASH(n->namespaceIndex, n->identifier.string.data, n->identifier.string.length);
     case UA_NODEIDTYPE_GUID:
-        return fnv32(n->namespaceIndex, (const u8*)&n->identifier.guid, sizeof(UA_Guid));
+        return UA_NODEID_BUFFER_HASH(n->namespaceIndex, (const u8*)&n->identifier.guid, sizeof(UA_Guid));
     }
 }
 
@@ -6796,6 +7133,8 @@ typedef struct {
 
     UA_exchangeEncodeBuffer exchangeBufferCallback;
     void *exchangeBufferCallbackHandle;
+
+    UA_Arena *arena; /* Decode into the arena instead of the heap if set */
 } Ctx;
 
 typedef status (*encodeBinarySignature)(const void *UA_RESTRICT src, const UA_DataType *type,
@@ -6823,6 +7162,139 @@ extern const calcSizeBinarySignature calcSizeBinaryJumpTable[UA_BUILTIN_TYPES_CO
 static status encodeBinaryInternal(const void *src, const UA_DataType *type, Ctx *ctx);
 static status decodeBinaryInternal(void *dst, const UA_DataType *type, Ctx *ctx);
 
+/* Straight-line codecs for the structures of the hot services. NULL for all
+ * other types. */
+static encodeBinarySignature specialisedEncoder(const UA_DataType *type);
+static decodeBinarySignature specialisedDecoder(const UA_DataType *type);
+
+/**
+ * Arena
+ * ^^^^^
+ * Decoding into an arena replaces the many small allocations of strings,
+ * arrays and nested values by bumping a pointer in a larger block. The decoded
+ * value is never deleted member by member, the arena is reset instead. When
+ * decoding into an arena, the decoding methods must therefore neither free
+ * memory nor mix in memory from the heap. They use the ctx* helpers below. */
+
+#define UA_ARENA_ALIGNMENT 16 /* Like malloc for all builtin types */
+#define UA_ARENA_MINBLOCKSIZE 16384
+
+struct UA_ArenaBlock {
+    UA_ArenaBlock *next;
+    size_t size; /* Bytes available behind the header */
+    size_t used;
+};
+
+#define UA_ARENA_HEADERSIZE                                             \
+    ((sizeof(UA_ArenaBlock) + UA_ARENA_ALIGNMENT - 1) & ~(size_t)(UA_ARENA_ALIGNMENT - 1))
+
+static UA_ArenaBlock *
+UA_ArenaBlock_new(size_t size, UA_ArenaBlock *next) {
+    UA_ArenaBlock *block = (UA_ArenaBlock*)UA_malloc(UA_ARENA_HEADERSIZE + size);
+    if(!block)
+        return NULL;
+    block->next = next;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+void
+UA_Arena_init(UA_Arena *arena, size_t maxRetained) {
+    arena->blocks = NULL;
+    arena->maxRetained = maxRetained;
+}
+
+static void *
+UA_Arena_alloc(UA_Arena *arena, size_t size) {
+    if(size > SIZE_MAX - UA_ARENA_HEADERSIZE - UA_ARENA_ALIGNMENT)
+        return NULL;
+    size = (size + UA_ARENA_ALIGNMENT - 1) & ~(size_t)(UA_ARENA_ALIGNMENT - 1);
+
+    /* Continue in a new block, at least twice the size of the last one */
+    UA_ArenaBlock *block = arena->blocks;
+    if(!block || block->size - block->used < size) {
+        size_t blockSize = UA_ARENA_MINBLOCKSIZE;
+        if(block && block->size <= SIZE_MAX / 2 - UA_ARENA_HEADERSIZE)
+            blockSize = block->size * 2;
+        if(blockSize < size)
+            blockSize = size;
+        block = UA_ArenaBlock_new(blockSize, block);
+        if(!block)
+            return NULL;
+        arena->blocks = block;
+    }
+
+    void *p = (u8*)block + UA_ARENA_HEADERSIZE + block->used;
+    block->used += size;
+    return p;
+}
+
+void
+UA_Arena_reset(UA_Arena *arena) {
+    UA_ArenaBlock *block = arena->blocks;
+    if(!block)
+        return;
+
+    /* Keep the single block */
+    if(!block->next && block->size <= arena->maxRetained) {
+        block->used = 0;
+        return;
+    }
+
+    /* Replace the blocks with one that is large enough for all of them. So the
+     * next value of that size is decoded into a single block. */
+    size_t total = 0;
+    while(block) {
+        UA_ArenaBlock *next = block->next;
+        total += block->size;
+        UA_free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    if(total <= arena->maxRetained)
+        arena->blocks = UA_ArenaBlock_new(total, NULL);
+}
+
+void
+UA_Arena_deleteMembers(UA_Arena *arena) {
+    UA_ArenaBlock *block = arena->blocks;
+    while(block) {
+        UA_ArenaBlock *next = block->next;
+        UA_free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+}
+
+/* Zeroed memory for an array of decoded values */
+static void *
+ctxCalloc(Ctx *ctx, size_t nmemb, size_t size) {
+    if(!ctx->arena)
+        return UA_calloc(nmemb, size);
+    if(size > 0 && nmemb > SIZE_MAX / size)
+        return NULL;
+    void *p = UA_Arena_alloc(ctx->arena, nmemb * size);
+    if(p)
+        memset(p, 0, nmemb * size);
+    return p;
+}
+
+static void
+ctxFree(Ctx *ctx, void *p) {
+    if(!ctx->arena)
+        UA_free(p);
+}
+
+/* Deletes the members of a partially decoded value and zeroes it */
+static void
+ctxDeleteMembers(Ctx *ctx, void *p, const UA_DataType *type) {
+    if(!ctx->arena)
+        UA_deleteMembers(p, type);
+    else
+        memset(p, 0, type->memSize);
+}
+
 /**
  * Chunking
  * ^^^^^^^^
@@ -7186,6 +7658,11 @@ Array_encodeBinaryComplex(uintptr_t ptr, size_t length, const UA_DataType *type,
      * UA_BUILTIN_TYPES_COUNT points to the generic UA_encodeBinary method */
     size_t encode_index = type->builtin ? type->typeIndex : UA_BUILTIN_TYPES_COUNT;
     encodeBinarySignature encodeType = encodeBinaryJumpTable[encode_index];
+    if(!type->builtin) {
+        encodeBinarySignature specialised = specialisedEncoder(type);
+        if(specialised)
+            encodeType = specialised;
+    }
 
     /* Encode every element */
     for(size_t i = 0; i < length; ++i) {
@@ -7259,14 +7736,14 @@ Array_decodeBinary(void *UA_RESTRICT *UA_RESTRICT dst, size_t *out_length,
         return UA_STATUSCODE_BADDECODINGERROR;
 
     /* Allocate memory */
-    *dst = UA_calloc(length, type->memSize);
+    *dst = ctxCalloc(ctx, length, type->memSize);
     if(!*dst)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     if(type->overlayable) {
         /* memcpy overlayable array */
         if(ctx->end < ctx->pos + (type->memSize * length)) {
-            UA_free(*dst);
+            ctxFree(ctx, *dst);
             *dst = NULL;
             return UA_STATUSCODE_BADDECODINGERROR;
         }
@@ -7276,11 +7753,18 @@ Array_decodeBinary(void *UA_RESTRICT *UA_RESTRICT dst, size_t *out_length,
         /* Decode array members */
         uintptr_t ptr = (uintptr_t)*dst;
         size_t decode_index = type->builtin ? type->typeIndex : UA_BUILTIN_TYPES_COUNT;
+        decodeBinarySignature decodeType = decodeBinaryJumpTable[decode_index];
+        if(!type->builtin) {
+            decodeBinarySignature specialised = specialisedDecoder(type);
+            if(specialised)
+                decodeType = specialised;
+        }
         for(size_t i = 0; i < length; ++i) {
-            ret = decodeBinaryJumpTable[decode_index]((void*)ptr, type, ctx);
+            ret = decodeType((void*)ptr, type, ctx);
             if(ret != UA_STATUSCODE_GOOD) {
                 /* +1 because last element is also already initialized */
-                UA_Array_delete(*dst, i+1, type);
+                if(!ctx->arena)
+                    UA_Array_delete(*dst, i+1, type);
                 *dst = NULL;
                 return ret;
             }
@@ -7644,12 +8128,15 @@ ExtensionObject_decodeBinaryContent(UA_ExtensionObject *dst, const UA_NodeId *ty
     /* Unknown type, just take the binary content */
     if(!type) {
         dst->encoding = UA_EXTENSIONOBJECT_ENCODED_BYTESTRING;
-        UA_NodeId_copy(typeId, &dst->content.encoded.typeId);
+        if(!ctx->arena)
+            UA_NodeId_copy(typeId, &dst->content.encoded.typeId);
+        else
+            dst->content.encoded.typeId = *typeId; /* The caller does not free it */
         return DECODE_DIRECT(&dst->content.encoded.body, String); /* ByteString */
     }
 
     /* Allocate memory */
-    dst->content.decoded.data = UA_new(type);
+    dst->content.decoded.data = ctxCalloc(ctx, 1, type->memSize);
     if(!dst->content.decoded.data)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
@@ -7675,13 +8162,13 @@ DECODE_BINARY(ExtensionObject) {
     ret |= DECODE_DIRECT(&binTypeId, NodeId);
     ret |= DECODE_DIRECT(&encoding, Byte);
     if(ret != UA_STATUSCODE_GOOD) {
-        UA_NodeId_deleteMembers(&binTypeId);
+        ctxDeleteMembers(ctx, &binTypeId, &UA_TYPES[UA_TYPES_NODEID]);
         return ret;
     }
 
     if(encoding == UA_EXTENSIONOBJECT_ENCODED_BYTESTRING) {
         ret = ExtensionObject_decodeBinaryContent(dst, &binTypeId, ctx);
-        UA_NodeId_deleteMembers(&binTypeId);
+        ctxDeleteMembers(ctx, &binTypeId, &UA_TYPES[UA_TYPES_NODEID]);
     } else if(encoding == UA_EXTENSIONOBJECT_ENCODED_NOBODY) {
         dst->encoding = (UA_ExtensionObjectEncoding)encoding;
         dst->content.encoded.typeId = binTypeId; /* move to dst */
@@ -7691,9 +8178,9 @@ DECODE_BINARY(ExtensionObject) {
         dst->content.encoded.typeId = binTypeId; /* move to dst */
         ret = DECODE_DIRECT(&dst->content.encoded.body, String); /* ByteString */
         if(ret != UA_STATUSCODE_GOOD)
-            UA_NodeId_deleteMembers(&dst->content.encoded.typeId);
+            ctxDeleteMembers(ctx, &dst->content.encoded.typeId, &UA_TYPES[UA_TYPES_NODEID]);
     } else {
-        UA_NodeId_deleteMembers(&binTypeId);
+        ctxDeleteMembers(ctx, &binTypeId, &UA_TYPES[UA_TYPES_NODEID]);
         ret = UA_STATUSCODE_BADDECODINGERROR;
     }
 
@@ -7808,7 +8295,7 @@ Variant_decodeBinaryUnwrapExtensionObject(UA_Variant *dst, Ctx *ctx) {
     u8 encoding;
     ret = DECODE_DIRECT(&encoding, Byte);
     if(ret != UA_STATUSCODE_GOOD) {
-        UA_NodeId_deleteMembers(&typeId);
+        ctxDeleteMembers(ctx, &typeId, &UA_TYPES[UA_TYPES_NODEID]);
         return ret;
     }
 
@@ -7821,11 +8308,11 @@ Variant_decodeBinaryUnwrapExtensionObject(UA_Variant *dst, Ctx *ctx) {
         /* Reset and decode as ExtensionObject */
         dst->type = &UA_TYPES[UA_TYPES_EXTENSIONOBJECT];
         ctx->pos = old_pos;
-        UA_NodeId_deleteMembers(&typeId);
+        ctxDeleteMembers(ctx, &typeId, &UA_TYPES[UA_TYPES_NODEID]);
     }
 
     /* Allocate memory */
-    dst->data = UA_new(dst->type);
+    dst->data = ctxCalloc(ctx, 1, dst->type->memSize);
     if(!dst->data)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
@@ -7870,7 +8357,7 @@ DECODE_BINARY(Variant) {
     if(isArray) {
         ret = Array_decodeBinary(&dst->data, &dst->arrayLength, dst->type, ctx);
     } else if(typeIndex != UA_TYPES_EXTENSIONOBJECT) {
-        dst->data = UA_new(dst->type);
+        dst->data = ctxCalloc(ctx, 1, dst->type->memSize);
         if(!dst->data)
             return UA_STATUSCODE_BADOUTOFMEMORY;
         ret = decodeBinaryJumpTable[typeIndex](dst->data, dst->type, ctx);
@@ -7888,6 +8375,92 @@ DECODE_BINARY(Variant) {
 }
 
 /* DataValue */
+
+#if defined(UA_ENABLE_SPECIALISED_CODECS) && UA_BINARY_OVERLAYABLE_INTEGER && UA_BINARY_OVERLAYABLE_FLOAT
+/* Straight-line encoding of a DataValue without a value or with a scalar
+ * Double or String, the values of most variables. Returns false without
+ * writing anything for other values or if the DataValue does not fit into the
+ * current chunk. */
+static UA_Boolean
+DataValue_encodeBinaryScalar(const UA_DataValue *src, u8 encodingMask, Ctx *ctx) {
+    /* Compute the encoded length */
+    const UA_String *str = NULL;
+    size_t length = 1;
+    if(src->hasValue) {
+        const UA_Variant *v = &src->value;
+        if(v->arrayLength > 0 || v->data <= UA_EMPTY_ARRAY_SENTINEL)
+            return false;
+        if(v->type == &UA_TYPES[UA_TYPES_DOUBLE]) {
+            length += 1 + sizeof(UA_Double);
+        } else if(v->type == &UA_TYPES[UA_TYPES_STRING]) {
+            str = (const UA_String*)v->data;
+            if(str->length > UA_INT32_MAX)
+                return false;
+            length += 1 + sizeof(i32) + str->length;
+        } else {
+            return false;
+        }
+    }
+    if(src->hasStatus)
+        length += sizeof(UA_StatusCode);
+    if(src->hasSourceTimestamp)
+        length += sizeof(UA_DateTime);
+    if(src->hasSourcePicoseconds)
+        length += sizeof(u16);
+    if(src->hasServerTimestamp)
+        length += sizeof(UA_DateTime);
+    if(src->hasServerPicoseconds)
+        length += sizeof(u16);
+    if(ctx->pos + length > ctx->end)
+        return false;
+
+    /* Encode in the order of DataValue_encodeBinary */
+    u8 *pos = ctx->pos;
+    *pos++ = encodingMask;
+    if(src->hasValue) {
+        *pos++ = (u8)(src->value.type->typeIndex + 1); /* Variant encoding */
+        if(!str) {
+            memcpy(pos, src->value.data, sizeof(UA_Double));
+            pos += sizeof(UA_Double);
+        } else {
+            i32 signed_length = -1;
+            if(str->length > 0)
+                signed_length = (i32)str->length;
+            else if(str->data == UA_EMPTY_ARRAY_SENTINEL)
+                signed_length = 0;
+            memcpy(pos, &signed_length, sizeof(i32));
+            pos += sizeof(i32);
+            if(str->length > 0) {
+                memcpy(pos, str->data, str->length);
+                pos += str->length;
+            }
+        }
+    }
+    if(src->hasStatus) {
+        memcpy(pos, &src->status, sizeof(UA_StatusCode));
+        pos += sizeof(UA_StatusCode);
+    }
+    if(src->hasSourceTimestamp) {
+        memcpy(pos, &src->sourceTimestamp, sizeof(UA_DateTime));
+        pos += sizeof(UA_DateTime);
+    }
+    if(src->hasSourcePicoseconds) {
+        memcpy(pos, &src->sourcePicoseconds, sizeof(u16));
+        pos += sizeof(u16);
+    }
+    if(src->hasServerTimestamp) {
+        memcpy(pos, &src->serverTimestamp, sizeof(UA_DateTime));
+        pos += sizeof(UA_DateTime);
+    }
+    if(src->hasServerPicoseconds) {
+        memcpy(pos, &src->serverPicoseconds, sizeof(u16));
+        pos += sizeof(u16);
+    }
+    ctx->pos = pos;
+    return true;
+}
+#endif
+
 ENCODE_BINARY(DataValue) {
     /* Set up the encoding mask */
     u8 encodingMask = (u8)
@@ -7898,6 +8471,11 @@ ENCODE_BINARY(DataValue) {
          ((u8)src->hasSourcePicoseconds << 4) |
          ((u8)src->hasServerPicoseconds << 5));
 
+#if defined(UA_ENABLE_SPECIALISED_CODECS) && UA_BINARY_OVERLAYABLE_INTEGER && UA_BINARY_OVERLAYABLE_FLOAT
+    if(DataValue_encodeBinaryScalar(src, encodingMask, ctx))
+        return UA_STATUSCODE_GOOD;
+#endif
+
     /* Encode the encoding byte */
     status ret = ENCODE_DIRECT(&encodingMask, Byte);
     if(ret != UA_STATUSCODE_GOOD)
@@ -7928,6 +8506,20 @@ ENCODE_BINARY(DataValue) {
 
 #define MAX_PICO_SECONDS 9999
 
+#ifdef UA_ENABLE_SPECIALISED_CODECS
+/* Straight-line decoding of a scalar Double or String variant. The encoding
+ * byte was checked by the caller. */
+static status
+Variant_decodeBinaryScalar(UA_Variant *dst, u8 encoding, Ctx *ctx) {
+    ++ctx->pos;
+    dst->type = &UA_TYPES[encoding - 1];
+    dst->data = ctxCalloc(ctx, 1, dst->type->memSize);
+    if(!dst->data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    return decodeBinaryJumpTable[encoding - 1](dst->data, dst->type, ctx);
+}
+#endif
+
 DECODE_BINARY(DataValue) {
     /* Decode the encoding mask */
     u8 encodingMask;
@@ -7944,7 +8536,13 @@ DECODE_BINARY(DataValue) {
     /* Decode the content */
     if(encodingMask & 0x01) {
         dst->hasValue = true;
-        ret |= DECODE_DIRECT(&dst->value, Variant);
+#ifdef UA_ENABLE_SPECIALISED_CODECS
+        u8 variantEncoding = ctx->pos < ctx->end ? *ctx->pos : 0;
+        if(variantEncoding == UA_TYPES_DOUBLE + 1 || variantEncoding == UA_TYPES_STRING + 1)
+            ret |= Variant_decodeBinaryScalar(&dst->value, variantEncoding, ctx);
+        else
+#endif
+            ret |= DECODE_DIRECT(&dst->value, Variant);
     }
     if(encodingMask & 0x02) {
         dst->hasStatus = true;
@@ -8056,9 +8654,9 @@ DECODE_BINARY(DiagnosticInfo) {
         ret |= DECODE_DIRECT(&dst->innerStatusCode, UInt32); /* StatusCode */
     }
     if(encodingMask & 0x40) {
-        /* innerDiagnosticInfo is allocated on the heap */
+        /* innerDiagnosticInfo is allocated separately */
         dst->innerDiagnosticInfo = (UA_DiagnosticInfo*)
-            UA_calloc(1, sizeof(UA_DiagnosticInfo));
+            ctxCalloc(ctx, 1, sizeof(UA_DiagnosticInfo));
         if(!dst->innerDiagnosticInfo)
             return UA_STATUSCODE_BADOUTOFMEMORY;
         dst->hasInnerDiagnosticInfo = true;
@@ -8074,6 +8672,253 @@ DECODE_BINARY(DiagnosticInfo) {
     return ret;
 }
 
+/**********************/
+/* Specialised Codecs */
+/**********************/
+
+/* The messages of the hot services are en- and decoded by straight-line
+ * functions instead of walking the member descriptions with a jumptable call
+ * for every member. The functions follow the member order of the type
+ * descriptions. They are found by specialisedEncoder / specialisedDecoder from
+ * encodeBinaryInternal, decodeBinaryInternal and the array codecs. All other
+ * structures use the generic codec. The server encodes the responses and
+ * decodes the requests, so only these directions are specialised. Without
+ * UA_ENABLE_SPECIALISED_CODECS, all types use the generic codec. */
+
+#ifdef UA_ENABLE_SPECIALISED_CODECS
+
+/* Encode a member, switch to the next chunk and retry if it does not fit into
+ * the current one. Like the member loop of encodeBinaryInternal. */
+static UA_INLINE status
+encodeMember(const void *src, const UA_DataType *type,
+             encodeBinarySignature encodeFunc, Ctx *ctx) {
+    u8 *oldpos = ctx->pos;
+    status ret = encodeFunc(src, type, ctx);
+    if(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED)
+        return ret;
+    ctx->pos = oldpos;
+    ret = exchangeBuffer(ctx);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+    ret = encodeFunc(src, type, ctx);
+    if(ret == UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED)
+        ret = UA_STATUSCODE_BADRESPONSETOOLARGE; /* Too large for an empty chunk */
+    return ret;
+}
+
+#define ENCODE_MEMBER(SRC, TYPE) \
+    encodeMember((const void*)(SRC), NULL, (encodeBinarySignature)TYPE##_encodeBinary, ctx)
+#define ENCODE_STRUCTMEMBER(SRC, TYPEINDEX) \
+    encodeMember((const void*)(SRC), &UA_TYPES[TYPEINDEX], \
+                 (encodeBinarySignature)encodeBinaryInternal, ctx)
+#define ENCODE_ARRAYMEMBER(SRC, SIZE, TYPEINDEX) \
+    Array_encodeBinary((const void*)(SRC), SIZE, &UA_TYPES[TYPEINDEX], ctx)
+
+#define DECODE_STRUCTMEMBER(DST, TYPEINDEX) \
+    decodeBinaryInternal((void*)(DST), &UA_TYPES[TYPEINDEX], ctx)
+#define DECODE_ARRAYMEMBER(DST, SIZE, TYPEINDEX) \
+    Array_decodeBinary((void *UA_RESTRICT *UA_RESTRICT)&(DST), &(SIZE), &UA_TYPES[TYPEINDEX], ctx)
+
+/* Read */
+DECODE_BINARY(ReadValueId) {
+    status ret = DECODE_DIRECT(&dst->nodeId, NodeId);
+    ret |= DECODE_DIRECT(&dst->attributeId, UInt32);
+    ret |= DECODE_DIRECT(&dst->indexRange, String);
+    ret |= DECODE_DIRECT(&dst->dataEncoding.namespaceIndex, UInt16);
+    ret |= DECODE_DIRECT(&dst->dataEncoding.name, String);
+    return ret;
+}
+
+DECODE_BINARY(ReadRequest) {
+    status ret = DECODE_STRUCTMEMBER(&dst->requestHeader, UA_TYPES_REQUESTHEADER);
+    ret |= decodeBinaryJumpTable[UA_TYPES_DOUBLE](&dst->maxAge, NULL, ctx);
+    ret |= DECODE_DIRECT(&dst->timestampsToReturn, UInt32); /* Enum */
+    ret |= DECODE_ARRAYMEMBER(dst->nodesToRead, dst->nodesToReadSize, UA_TYPES_READVALUEID);
+    return ret;
+}
+
+ENCODE_BINARY(ReadResponse) {
+    status ret = ENCODE_STRUCTMEMBER(&src->responseHeader, UA_TYPES_RESPONSEHEADER);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->results, src->resultsSize, UA_TYPES_DATAVALUE);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->diagnosticInfos, src->diagnosticInfosSize,
+                                 UA_TYPES_DIAGNOSTICINFO);
+    return ret;
+}
+
+/* Publish */
+DECODE_BINARY(PublishRequest) {
+    status ret = DECODE_STRUCTMEMBER(&dst->requestHeader, UA_TYPES_REQUESTHEADER);
+    ret |= DECODE_ARRAYMEMBER(dst->subscriptionAcknowledgements,
+                              dst->subscriptionAcknowledgementsSize,
+                              UA_TYPES_SUBSCRIPTIONACKNOWLEDGEMENT);
+    return ret;
+}
+
+ENCODE_BINARY(MonitoredItemNotification) {
+    status ret = ENCODE_MEMBER(&src->clientHandle, UInt32);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->value, DataValue);
+    return ret;
+}
+
+ENCODE_BINARY(DataChangeNotification) {
+    status ret = ENCODE_ARRAYMEMBER(src->monitoredItems, src->monitoredItemsSize,
+                                    UA_TYPES_MONITOREDITEMNOTIFICATION);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->diagnosticInfos, src->diagnosticInfosSize,
+                                 UA_TYPES_DIAGNOSTICINFO);
+    return ret;
+}
+
+ENCODE_BINARY(PublishResponse) {
+    status ret = ENCODE_STRUCTMEMBER(&src->responseHeader, UA_TYPES_RESPONSEHEADER);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->subscriptionId, UInt32);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->availableSequenceNumbers,
+                                 src->availableSequenceNumbersSize, UA_TYPES_UINT32);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->moreNotifications, Boolean);
+    /* NotificationMessage */
+    const UA_NotificationMessage *msg = &src->notificationMessage;
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&msg->sequenceNumber, UInt32);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&msg->publishTime, UInt64); /* DateTime */
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(msg->notificationData, msg->notificationDataSize,
+                                 UA_TYPES_EXTENSIONOBJECT);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->results, src->resultsSize, UA_TYPES_STATUSCODE);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->diagnosticInfos, src->diagnosticInfosSize,
+                                 UA_TYPES_DIAGNOSTICINFO);
+    return ret;
+}
+
+/* Browse */
+DECODE_BINARY(BrowseDescription) {
+    status ret = DECODE_DIRECT(&dst->nodeId, NodeId);
+    ret |= DECODE_DIRECT(&dst->browseDirection, UInt32); /* Enum */
+    ret |= DECODE_DIRECT(&dst->referenceTypeId, NodeId);
+    ret |= DECODE_DIRECT(&dst->includeSubtypes, Boolean);
+    ret |= DECODE_DIRECT(&dst->nodeClassMask, UInt32);
+    ret |= DECODE_DIRECT(&dst->resultMask, UInt32);
+    return ret;
+}
+
+DECODE_BINARY(BrowseRequest) {
+    status ret = DECODE_STRUCTMEMBER(&dst->requestHeader, UA_TYPES_REQUESTHEADER);
+    ret |= DECODE_DIRECT(&dst->view.viewId, NodeId);
+    ret |= DECODE_DIRECT(&dst->view.timestamp, UInt64); /* DateTime */
+    ret |= DECODE_DIRECT(&dst->view.viewVersion, UInt32);
+    ret |= DECODE_DIRECT(&dst->requestedMaxReferencesPerNode, UInt32);
+    ret |= DECODE_ARRAYMEMBER(dst->nodesToBrowse, dst->nodesToBrowseSize,
+                              UA_TYPES_BROWSEDESCRIPTION);
+    return ret;
+}
+
+ENCODE_BINARY(ReferenceDescription) {
+    status ret = ENCODE_MEMBER(&src->referenceTypeId, NodeId);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->isForward, Boolean);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->nodeId, ExpandedNodeId);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->browseName.namespaceIndex, UInt16);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->browseName.name, String);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->displayName, LocalizedText);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->nodeClass, UInt32); /* Enum */
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->typeDefinition, ExpandedNodeId);
+    return ret;
+}
+
+ENCODE_BINARY(BrowseResult) {
+    status ret = ENCODE_MEMBER(&src->statusCode, UInt32); /* StatusCode */
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_MEMBER(&src->continuationPoint, String); /* ByteString */
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->references, src->referencesSize,
+                                 UA_TYPES_REFERENCEDESCRIPTION);
+    return ret;
+}
+
+ENCODE_BINARY(BrowseResponse) {
+    status ret = ENCODE_STRUCTMEMBER(&src->responseHeader, UA_TYPES_RESPONSEHEADER);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->results, src->resultsSize, UA_TYPES_BROWSERESULT);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = ENCODE_ARRAYMEMBER(src->diagnosticInfos, src->diagnosticInfosSize,
+                                 UA_TYPES_DIAGNOSTICINFO);
+    return ret;
+}
+
+static encodeBinarySignature
+specialisedEncoder(const UA_DataType *type) {
+    if(type->typeIndex >= UA_TYPES_COUNT || type != &UA_TYPES[type->typeIndex])
+        return NULL;
+    switch(type->typeIndex) {
+    case UA_TYPES_READRESPONSE:
+        return (encodeBinarySignature)ReadResponse_encodeBinary;
+    case UA_TYPES_MONITOREDITEMNOTIFICATION:
+        return (encodeBinarySignature)MonitoredItemNotification_encodeBinary;
+    case UA_TYPES_DATACHANGENOTIFICATION:
+        return (encodeBinarySignature)DataChangeNotification_encodeBinary;
+    case UA_TYPES_PUBLISHRESPONSE:
+        return (encodeBinarySignature)PublishResponse_encodeBinary;
+    case UA_TYPES_REFERENCEDESCRIPTION:
+        return (encodeBinarySignature)ReferenceDescription_encodeBinary;
+    case UA_TYPES_BROWSERESULT:
+        return (encodeBinarySignature)BrowseResult_encodeBinary;
+    case UA_TYPES_BROWSERESPONSE:
+        return (encodeBinarySignature)BrowseResponse_encodeBinary;
+    default:
+        return NULL;
+    }
+}
+
+static decodeBinarySignature
+specialisedDecoder(const UA_DataType *type) {
+    if(type->typeIndex >= UA_TYPES_COUNT || type != &UA_TYPES[type->typeIndex])
+        return NULL;
+    switch(type->typeIndex) {
+    case UA_TYPES_READVALUEID:
+        return (decodeBinarySignature)ReadValueId_decodeBinary;
+    case UA_TYPES_READREQUEST:
+        return (decodeBinarySignature)ReadRequest_decodeBinary;
+    case UA_TYPES_PUBLISHREQUEST:
+        return (decodeBinarySignature)PublishRequest_decodeBinary;
+    case UA_TYPES_BROWSEDESCRIPTION:
+        return (decodeBinarySignature)BrowseDescription_decodeBinary;
+    case UA_TYPES_BROWSEREQUEST:
+        return (decodeBinarySignature)BrowseRequest_decodeBinary;
+    default:
+        return NULL;
+    }
+}
+
+#else /* UA_ENABLE_SPECIALISED_CODECS */
+
+static encodeBinarySignature
+specialisedEncoder(const UA_DataType *type) {
+    (void)type;
+    return NULL;
+}
+
+static decodeBinarySignature
+specialisedDecoder(const UA_DataType *type) {
+    (void)type;
+    return NULL;
+}
+
+#endif /* UA_ENABLE_SPECIALISED_CODECS */
+
 /********************/
 /* Structured Types */
 /********************/
@@ -8114,8 +8959,15 @@ encodeBinaryInternal(const void *src, const UA_DataType *type, Ctx *ctx) {
         return UA_STATUSCODE_BADENCODINGERROR;
     ctx->depth++;
 
-    uintptr_t ptr = (uintptr_t)src;
     status ret = UA_STATUSCODE_GOOD;
+    encodeBinarySignature specialised = specialisedEncoder(type);
+    if(specialised) {
+        ret = specialised(src, type, ctx);
+        ctx->depth--;
+        return ret;
+    }
+
+    uintptr_t ptr = (uintptr_t)src;
     u8 membersSize = type->membersSize;
     const UA_DataType *typelists[2] = { UA_TYPES, &type[-type->typeIndex] };
     for(size_t i = 0; i < membersSize && ret == UA_STATUSCODE_GOOD; ++i) {
@@ -8214,8 +9066,15 @@ decodeBinaryInternal(void *dst, const UA_DataType *type, Ctx *ctx) {
         return UA_STATUSCODE_BADENCODINGERROR;
     ctx->depth++;
 
-    uintptr_t ptr = (uintptr_t)dst;
     status ret = UA_STATUSCODE_GOOD;
+    decodeBinarySignature specialised = specialisedDecoder(type);
+    if(specialised) {
+        ret = specialised(dst, type, ctx);
+        ctx->depth--;
+        return ret;
+    }
+
+    uintptr_t ptr = (uintptr_t)dst;
     u8 membersSize = type->membersSize;
     const UA_DataType *typelists[2] = { UA_TYPES, &type[-type->typeIndex] };
     for(size_t i = 0; i < membersSize && ret == UA_STATUSCODE_GOOD; ++i) {
@@ -8241,9 +9100,9 @@ decodeBinaryInternal(void *dst, const UA_DataType *type, Ctx *ctx) {
 }
 
 status
-UA_decodeBinary(const UA_ByteString *src, size_t *offset, void *dst,
-                const UA_DataType *type, size_t customTypesSize,
-                const UA_DataType *customTypes) {
+UA_decodeBinaryArena(const UA_ByteString *src, size_t *offset, void *dst,
+                     const UA_DataType *type, size_t customTypesSize,
+                     const UA_DataType *customTypes, UA_Arena *arena) {
     /* Set up the context */
     Ctx ctx;
     ctx.pos = &src->data[*offset];
@@ -8251,6 +9110,7 @@ UA_decodeBinary(const UA_ByteString *src, size_t *offset, void *dst,
     ctx.depth = 0;
     ctx.customTypesArraySize = customTypesSize;
     ctx.customTypesArray = customTypes;
+    ctx.arena = arena;
 
     /* Decode */
     memset(dst, 0, type->memSize); /* Initialize the value */
@@ -8261,12 +9121,20 @@ UA_decodeBinary(const UA_ByteString *src, size_t *offset, void *dst,
         *offset = (size_t)(ctx.pos - src->data) / sizeof(u8);
     } else {
         /* Clean up */
-        UA_deleteMembers(dst, type);
+        ctxDeleteMembers(&ctx, dst, type);
         memset(dst, 0, type->memSize);
     }
     return ret;
 }
 
+status
+UA_decodeBinary(const UA_ByteString *src, size_t *offset, void *dst,
+                const UA_DataType *type, size_t customTypesSize,
+                const UA_DataType *customTypes) {
+    return UA_decodeBinaryArena(src, offset, dst, type, customTypesSize,
+                                customTypes, NULL);
+}
+
 /**
  * Compute the Message Size
  * ------------------------
@@ -17293,11 +18161,11 @@ UA_parseEndpointUrl(const UA_String *endpointUrl, UA_String *outHostname,
  * by Dmitry Vyukov.
  * http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
  *
- * The RepeatedCallback structure is used both in the sorted list of callbacks
- * and in the MPSC changes queue. For the changes queue, we differentiate
- * between three cases encoded in the callback pointer.
+ * The RepeatedCallback structure is used both in the heap of callbacks and in
+ * the MPSC changes queue. For the changes queue, we differentiate between three
+ * cases encoded in the callback pointer.
  *
- * callback > 0x01: add the new repeated callback to the sorted list
+ * callback > 0x01: add the new repeated callback to the heap
  * callback == 0x00: remove the callback with the same id
  * callback == 0x01: change the interval of the existing callback */
 
@@ -17305,19 +18173,23 @@ UA_parseEndpointUrl(const UA_String *endpointUrl, UA_String *outHostname,
 #define CHANGE_SENTINEL 0x01
 
 struct UA_TimerCallbackEntry {
-    SLIST_ENTRY(UA_TimerCallbackEntry) next; /* Next element in the list */
+    SLIST_ENTRY(UA_TimerCallbackEntry) next; /* Next element in the changes
+                                              * queue */
     UA_DateTime nextTime;                    /* The next time when the callbacks
                                               * are to be executed */
     UA_UInt64 interval;                      /* Interval in 100ns resolution */
     UA_UInt64 id;                            /* Id of the repeated callback */
+    size_t heapIndex;                        /* Position in the heap */
 
     UA_TimerCallback callback;
     void *data;
 };
 
+#define UA_TIMER_MINSIZE 16
+
 void
 UA_Timer_init(UA_Timer *t) {
-    SLIST_INIT(&t->repeatedCallbacks);
+    memset(t, 0, sizeof(UA_Timer));
     t->changes_head = (UA_TimerCallbackEntry*)&t->changes_stub;
     t->changes_tail = (UA_TimerCallbackEntry*)&t->changes_stub;
     t->changes_stub = NULL;
@@ -17399,39 +18271,221 @@ UA_Timer_addRepeatedCallback(UA_Timer *t, UA_TimerCallback callback,
     return UA_STATUSCODE_GOOD;
 }
 
+/**************/
+/* Heap Order */
+/**************/
+
+/* Callbacks due at the same time are executed last registered first */
+static UA_Boolean
+executedBefore(const UA_TimerCallbackEntry *a, const UA_TimerCallbackEntry *b) {
+    if(a->nextTime != b->nextTime)
+        return a->nextTime < b->nextTime;
+    return a->id > b->id;
+}
+
 static void
-addTimerCallbackEntry(UA_Timer *t, UA_TimerCallbackEntry * UA_RESTRICT tc) {
-    /* Find the last entry before this callback */
-    UA_TimerCallbackEntry *tmpTc, *afterTc = NULL;
-    SLIST_FOREACH(tmpTc, &t->repeatedCallbacks, next) {
-        if(tmpTc->nextTime >= tc->nextTime)
+heapSet(UA_Timer *t, size_t i, UA_TimerCallbackEntry *tc) {
+    t->heap[i] = tc;
+    tc->heapIndex = i;
+}
+
+static void
+heapSiftUp(UA_Timer *t, size_t i) {
+    UA_TimerCallbackEntry *tc = t->heap[i];
+    while(i > 0) {
+        size_t parent = (i - 1) / 4;
+        if(!executedBefore(tc, t->heap[parent]))
             break;
+        heapSet(t, i, t->heap[parent]);
+        i = parent;
+    }
+    heapSet(t, i, tc);
+}
 
-        /* The goal is to have many repeated callbacks with the same repetition
-         * interval in a "block" in order to reduce linear search for re-entry
-         * to the sorted list after processing. Allow the first execution to lie
-         * between "nextTime - 1s" and "nextTime" if this adjustment groups
-         * callbacks with the same repetition interval.
-         * Callbacks of a block are added in reversed order. This design allows
-         * the monitored items of a subscription (if created in a sequence with the
-         * same publish/sample interval) to be executed before the subscription
-         * publish the notifications */
-        if(tmpTc->interval == tc->interval &&
-           tmpTc->nextTime > (tc->nextTime - UA_DATETIME_SEC)) {
-            tc->nextTime = tmpTc->nextTime;
+static void
+heapSiftDown(UA_Timer *t, size_t i) {
+    UA_TimerCallbackEntry *tc = t->heap[i];
+    while(true) {
+        size_t first = (4 * i) + 1;
+        if(first >= t->heapSize)
             break;
+        size_t last = first + 4;
+        if(last > t->heapSize)
+            last = t->heapSize;
+        size_t best = first;
+        for(size_t c = first + 1; c < last; c++) {
+            if(executedBefore(t->heap[c], t->heap[best]))
+                best = c;
         }
+        if(!executedBefore(t->heap[best], tc))
+            break;
+        heapSet(t, i, t->heap[best]);
+        i = best;
+    }
+    heapSet(t, i, tc);
+}
 
-        /* tc is neither in the same interval nor supposed to be executed sooner
-         * than tmpTc. Update afterTc to push tc further back in the timer list. */
-        afterTc = tmpTc;
+static void
+heapRemove(UA_Timer *t, UA_TimerCallbackEntry *tc) {
+    size_t i = tc->heapIndex;
+    UA_TimerCallbackEntry *last = t->heap[--t->heapSize];
+    if(i < t->heapSize) {
+        heapSet(t, i, last);
+        if(i > 0 && executedBefore(last, t->heap[(i - 1) / 4]))
+            heapSiftUp(t, i);
+        else
+            heapSiftDown(t, i);
     }
 
-    /* Add the repeated callback */
-    if(afterTc)
-        SLIST_INSERT_AFTER(afterTc, tc, next);
-    else
-        SLIST_INSERT_HEAD(&t->repeatedCallbacks, tc, next);
+    /* Give back memory. Failure to shrink is not an error. */
+    if(t->heapCapacity > UA_TIMER_MINSIZE && t->heapSize * 4 < t->heapCapacity) {
+        UA_TimerCallbackEntry **heap = (UA_TimerCallbackEntry**)
+            UA_realloc(t->heap, sizeof(UA_TimerCallbackEntry*) * (t->heapCapacity / 2));
+        if(heap) {
+            t->heap = heap;
+            t->heapCapacity /= 2;
+        }
+    }
+}
+
+/************/
+/* Id Index */
+/************/
+
+/* Ids are handed out sequentially. With the lower bits of the id as the home
+ * slot, they would form one long run of occupied slots that every removal has
+ * to scan to its end. Fibonacci hashing spreads them over the table instead. */
+static size_t
+idHome(const UA_Timer *t, UA_UInt64 callbackId) {
+    return (size_t)((callbackId * UINT64_C(11400714819323198485)) >> (64 - t->idsBits));
+}
+
+static UA_TimerCallbackEntry **
+findId(const UA_Timer *t, UA_UInt64 callbackId) {
+    if(t->idsSize == 0)
+        return NULL;
+    size_t mask = t->idsSize - 1;
+    for(size_t i = idHome(t, callbackId); t->ids[i]; i = (i + 1) & mask) {
+        if(t->ids[i]->id == callbackId)
+            return &t->ids[i];
+    }
+    return NULL;
+}
+
+static void
+insertId(UA_Timer *t, UA_TimerCallbackEntry *tc) {
+    size_t mask = t->idsSize - 1;
+    size_t i = idHome(t, tc->id);
+    while(t->ids[i])
+        i = (i + 1) & mask;
+    t->ids[i] = tc;
+    t->idsCount++;
+}
+
+static UA_StatusCode
+resizeIds(UA_Timer *t, size_t size) {
+    UA_TimerCallbackEntry **ids = (UA_TimerCallbackEntry**)
+        UA_calloc(size, sizeof(UA_TimerCallbackEntry*));
+    if(!ids)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_TimerCallbackEntry **oldIds = t->ids;
+    size_t oldSize = t->idsSize;
+    t->ids = ids;
+    t->idsSize = size;
+    t->idsBits = 0;
+    while(((size_t)1 << t->idsBits) < size)
+        t->idsBits++;
+    t->idsCount = 0;
+    for(size_t i = 0; i < oldSize; i++) {
+        if(oldIds[i])
+            insertId(t, oldIds[i]);
+    }
+    UA_free(oldIds);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Remove with backward shift: move following entries of the probe sequence
+ * into the gap unless that would put them before their home position */
+static void
+removeId(UA_Timer *t, UA_TimerCallbackEntry **slot) {
+    size_t mask = t->idsSize - 1;
+    size_t gap = (size_t)(slot - t->ids);
+    for(size_t i = (gap + 1) & mask; t->ids[i]; i = (i + 1) & mask) {
+        size_t home = idHome(t, t->ids[i]->id);
+        if(((i - home) & mask) >= ((i - gap) & mask)) {
+            t->ids[gap] = t->ids[i];
+            gap = i;
+        }
+    }
+    t->ids[gap] = NULL;
+    t->idsCount--;
+
+    /* Give back memory. Failure to shrink is not an error. */
+    if(t->idsSize > UA_TIMER_MINSIZE && t->idsCount * 8 < t->idsSize)
+        resizeIds(t, t->idsSize / 2);
+}
+
+/* Allocate space for one more callback in the heap and the id index */
+static UA_StatusCode
+reserveTimerCallbackEntry(UA_Timer *t) {
+    if(t->heapSize == t->heapCapacity) {
+        size_t capacity = t->heapCapacity ? t->heapCapacity * 2 : UA_TIMER_MINSIZE;
+        UA_TimerCallbackEntry **heap = (UA_TimerCallbackEntry**)
+            UA_realloc(t->heap, sizeof(UA_TimerCallbackEntry*) * capacity);
+        if(!heap)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        t->heap = heap;
+        t->heapCapacity = capacity;
+    }
+    if((t->idsCount + 1) * 2 > t->idsSize)
+        return resizeIds(t, t->idsSize ? t->idsSize * 2 : UA_TIMER_MINSIZE);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The goal is to have many repeated callbacks with the same repetition interval
+ * in a "block" that is executed together. Allow the first execution to lie
+ * between "nextTime - 1s" and "nextTime" if this adjustment groups callbacks
+ * with the same repetition interval. */
+static void
+alignTimerCallbackEntry(UA_Timer *t, UA_TimerCallbackEntry *tc) {
+    for(size_t i = 0; i < UA_TIMER_PHASES; i++) {
+        UA_TimerPhase *phase = &t->phases[i];
+        if(phase->interval != tc->interval)
+            continue;
+
+        /* Last execution of the block at or before nextTime */
+        if(phase->nextTime <= tc->nextTime) {
+            UA_UInt64 behind = (UA_UInt64)(tc->nextTime - phase->nextTime);
+            UA_DateTime blockTime =
+                tc->nextTime - (UA_DateTime)(behind % tc->interval);
+            if(tc->nextTime - blockTime < UA_DATETIME_SEC) {
+                tc->nextTime = blockTime;
+                return;
+            }
+        }
+
+        /* Start a new block for the interval */
+        phase->nextTime = tc->nextTime;
+        return;
+    }
+
+    /* Remember the phase of the interval, replacing the oldest one */
+    UA_TimerPhase *phase = &t->phases[t->nextPhase];
+    t->nextPhase = (t->nextPhase + 1) % UA_TIMER_PHASES;
+    phase->interval = tc->interval;
+    phase->nextTime = tc->nextTime;
+}
+
+static UA_StatusCode
+addTimerCallbackEntry(UA_Timer *t, UA_TimerCallbackEntry * UA_RESTRICT tc) {
+    UA_StatusCode retval = reserveTimerCallbackEntry(t);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    alignTimerCallbackEntry(t, tc);
+    insertId(t, tc);
+    heapSet(t, t->heapSize++, tc);
+    heapSiftUp(t, tc->heapIndex);
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -17461,32 +18515,26 @@ UA_Timer_changeRepeatedCallbackInterval(UA_Timer *t, UA_UInt64 callbackId,
 static void
 changeTimerCallbackEntryInterval(UA_Timer *t, UA_UInt64 callbackId,
                                  UA_UInt64 interval, UA_DateTime nextTime) {
-    /* Remove from the sorted list */
-    UA_TimerCallbackEntry *tc, *prev = NULL;
-    SLIST_FOREACH(tc, &t->repeatedCallbacks, next) {
-        if(callbackId == tc->id) {
-            if(prev)
-                SLIST_REMOVE_AFTER(prev, next);
-            else
-                SLIST_REMOVE_HEAD(&t->repeatedCallbacks, next);
-            break;
-        }
-        prev = tc;
-    }
-    if(!tc)
+    UA_TimerCallbackEntry **slot = findId(t, callbackId);
+    if(!slot)
         return;
+    UA_TimerCallbackEntry *tc = *slot;
 
     /* Adjust settings */
     tc->interval = interval;
     tc->nextTime = nextTime;
+    alignTimerCallbackEntry(t, tc);
 
-    /* Reinsert at the new position */
-    addTimerCallbackEntry(t, tc);
+    /* Move to the new position */
+    if(tc->heapIndex > 0 && executedBefore(tc, t->heap[(tc->heapIndex - 1) / 4]))
+        heapSiftUp(t, tc->heapIndex);
+    else
+        heapSiftDown(t, tc->heapIndex);
 }
 
 /* Removing a repeated callback: Add an entry with the "nextTime" timestamp set
  * to UA_INT64_MAX. The next iteration picks this up and removes the repated
- * callback from the linked list. */
+ * callback from the heap. */
 UA_StatusCode
 UA_Timer_removeRepeatedCallback(UA_Timer *t, UA_UInt64 callbackId) {
     /* Allocate the repeated callback structure */
@@ -17506,25 +18554,21 @@ UA_Timer_removeRepeatedCallback(UA_Timer *t, UA_UInt64 callbackId) {
 
 static void
 removeRepeatedCallback(UA_Timer *t, UA_UInt64 callbackId) {
-    UA_TimerCallbackEntry *tc, *prev = NULL;
-    SLIST_FOREACH(tc, &t->repeatedCallbacks, next) {
-        if(callbackId == tc->id) {
-            if(prev)
-                SLIST_REMOVE_AFTER(prev, next);
-            else
-                SLIST_REMOVE_HEAD(&t->repeatedCallbacks, next);
-            UA_free(tc);
-            break;
-        }
-        prev = tc;
-    }
+    UA_TimerCallbackEntry **slot = findId(t, callbackId);
+    if(!slot)
+        return;
+    UA_TimerCallbackEntry *tc = *slot;
+    removeId(t, slot);
+    heapRemove(t, tc);
+    UA_free(tc);
 }
 
 /* Process the changes that were added to the MPSC queue (by other threads) */
 static void
 processChanges(UA_Timer *t) {
     UA_TimerCallbackEntry *change;
-    while((change = dequeueChange(t))) {
+    while((change = t->pendingChange ? t->pendingChange : dequeueChange(t))) {
+        t->pendingChange = NULL;
         switch((uintptr_t)change->callback) {
         case REMOVE_SENTINEL:
             removeRepeatedCallback(t, change->id);
@@ -17536,7 +18580,12 @@ processChanges(UA_Timer *t) {
             UA_free(change);
             break;
         default:
-            addTimerCallbackEntry(t, change);
+            /* Out of memory. Keep the order of the changes and retry in the
+             * next iteration. */
+            if(addTimerCallbackEntry(t, change) != UA_STATUSCODE_GOOD) {
+                t->pendingChange = change;
+                return;
+            }
         }
     }
 }
@@ -17548,37 +18597,12 @@ UA_Timer_process(UA_Timer *t, UA_DateTime nowMonotonic,
     /* Insert and remove callbacks */
     processChanges(t);
 
-    /* Find the last callback to be executed now */
-    UA_TimerCallbackEntry *firstAfter, *lastNow = NULL;
-    SLIST_FOREACH(firstAfter, &t->repeatedCallbacks, next) {
-        if(firstAfter->nextTime > nowMonotonic)
+    /* Dispatch the callbacks that are due. Changes from within the callbacks
+     * are queued, so the heap is only modified here. */
+    while(t->heapSize > 0) {
+        UA_TimerCallbackEntry *tc = t->heap[0];
+        if(tc->nextTime > nowMonotonic)
             break;
-        lastNow = firstAfter;
-    }
-
-    /* Nothing to do */
-    if(!lastNow) {
-        if(firstAfter)
-            return firstAfter->nextTime;
-        return UA_INT64_MAX;
-    }
-
-    /* Put the callbacks that are executed now in a separate list */
-    UA_TimerCallbackList executedNowList;
-    executedNowList.slh_first = SLIST_FIRST(&t->repeatedCallbacks);
-    lastNow->next.sle_next = NULL;
-
-    /* Fake entry to represent the first element in the newly-sorted list */
-    UA_TimerCallbackEntry tmp_first;
-    tmp_first.nextTime = nowMonotonic - 1; /* never matches for last_dispatched */
-    tmp_first.next.sle_next = firstAfter;
-    UA_TimerCallbackEntry *last_dispatched = &tmp_first;
-
-    /* Iterate over the list of callbacks to process now */
-    UA_TimerCallbackEntry *tc;
-    while((tc = SLIST_FIRST(&executedNowList))) {
-        /* Remove from the list */
-        SLIST_REMOVE_HEAD(&executedNowList, next);
 
         /* Dispatch/process callback */
         dispatchCallback(application, tc->callback, tc->data);
@@ -17586,67 +18610,42 @@ UA_Timer_process(UA_Timer *t, UA_DateTime nowMonotonic,
         /* Set the time for the next execution. Prevent an infinite loop by
          * forcing the next processing into the next iteration. */
         tc->nextTime += (UA_Int64)tc->interval;
-        if(tc->nextTime < nowMonotonic)
+        if(tc->nextTime <= nowMonotonic)
             tc->nextTime = nowMonotonic + 1;
 
-        /* Find the new position for tc to keep the list sorted */
-        UA_TimerCallbackEntry *prev_tc;
-        if(last_dispatched->nextTime == tc->nextTime) {
-            /* We try to "batch" repeatedCallbacks with the same interval. This
-             * saves a linear search when the last dispatched entry has the same
-             * nextTime timestamp as this entry. */
-            UA_assert(last_dispatched != &tmp_first);
-            prev_tc = last_dispatched;
-        } else {
-            /* Find the position for the next execution by a linear search
-             * starting at last_dispatched or the first element */
-            if(last_dispatched->nextTime < tc->nextTime)
-                prev_tc = last_dispatched;
-            else
-                prev_tc = &tmp_first;
-
-            while(true) {
-                UA_TimerCallbackEntry *n = SLIST_NEXT(prev_tc, next);
-                if(!n || n->nextTime >= tc->nextTime)
-                    break;
-                prev_tc = n;
-            }
-        }
-
-        /* Update last_dispatched to make sure batched callbacks are added in the
-         * same sequence as before they were executed and to save some iterations
-         * of the linear search for callbacks to be added further back in the list. */
-        last_dispatched = tc;
-
-        /* Add entry to the new position in the sorted list */
-        SLIST_INSERT_AFTER(prev_tc, tc, next);
+        /* Move to the new position. Callbacks of a block keep their order. */
+        heapSiftDown(t, 0);
     }
 
-    /* Set the entry-point for the newly sorted list */
-    t->repeatedCallbacks.slh_first = tmp_first.next.sle_next;
-
     /* Re-repeat processAddRemoved since one of the callbacks might have removed
      * or added a callback. So we return a correct timeout. */
     processChanges(t);
 
     /* Return timestamp of next repetition */
-    tc = SLIST_FIRST(&t->repeatedCallbacks);
-    if(!tc)
+    if(t->heapSize == 0)
         return UA_INT64_MAX; /* Main-loop has a max timeout / will continue earlier */
-    return tc->nextTime;
+    return t->heap[0]->nextTime;
 }
 
 void
 UA_Timer_deleteMembers(UA_Timer *t) {
     /* Process changes to empty the MPSC queue */
     processChanges(t);
+    UA_free(t->pendingChange);
+    t->pendingChange = NULL;
 
     /* Remove repeated callbacks */
-    UA_TimerCallbackEntry *current;
-    while((current = SLIST_FIRST(&t->repeatedCallbacks))) {
-        SLIST_REMOVE_HEAD(&t->repeatedCallbacks, next);
-        UA_free(current);
-    }
+    for(size_t i = 0; i < t->heapSize; i++)
+        UA_free(t->heap[i]);
+    UA_free(t->heap);
+    t->heap = NULL;
+    t->heapSize = 0;
+    t->heapCapacity = 0;
+    UA_free(t->ids);
+    t->ids = NULL;
+    t->idsSize = 0;
+    t->idsBits = 0;
+    t->idsCount = 0;
 }
 
 /*********************************** amalgamated original file "/home/travis/build/open62541/open62541/src/ua_connection.c" ***********************************/
@@ -17707,34 +18706,108 @@ UA_Connection_sendError(UA_Connection *connection, UA_TcpErrorMessage *error) {
     connection->send(connection, &msg);
 }
 
+#define UA_CHUNK_HEADER_LENGTH 8
+
+/* Check the message type and the length in the header of a chunk. At least
+ * UA_CHUNK_HEADER_LENGTH bytes are required. */
 static UA_StatusCode
-prependIncompleteChunk(UA_Connection *connection, UA_ByteString *message) {
-    /* Allocate the new message buffer */
-    size_t length = connection->incompleteMessage.length + message->length;
-    UA_Byte *data = (UA_Byte*)UA_realloc(connection->incompleteMessage.data, length);
-    if(!data) {
-        UA_ByteString_deleteMembers(&connection->incompleteMessage);
-        return UA_STATUSCODE_BADOUTOFMEMORY;
+checkChunkHeader(const UA_Connection *connection, const UA_Byte *pos,
+                 UA_UInt32 *chunkLength) {
+    /* Check the message type */
+    UA_MessageType msgtype = (UA_MessageType)((UA_UInt32)pos[0] + ((UA_UInt32)pos[1] << 8) +
+        ((UA_UInt32)pos[2] << 16));
+    if(msgtype != UA_MESSAGETYPE_MSG && msgtype != UA_MESSAGETYPE_ERR &&
+       msgtype != UA_MESSAGETYPE_OPN && msgtype != UA_MESSAGETYPE_HEL &&
+       msgtype != UA_MESSAGETYPE_ACK && msgtype != UA_MESSAGETYPE_CLO) {
+        /* The message type is not recognized */
+        return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
     }
 
-    /* Copy / release the current message buffer */
-    memcpy(&data[connection->incompleteMessage.length], message->data, message->length);
-    message->length = length;
-    message->data = data;
-    connection->incompleteMessage = UA_BYTESTRING_NULL;
+    UA_Byte isFinal = pos[3];
+    if(isFinal != 'C' && isFinal != 'F' && isFinal != 'A') {
+        /* The message type is not recognized */
+        return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
+    }
+
+    UA_ByteString temp = { UA_CHUNK_HEADER_LENGTH, (UA_Byte*)(uintptr_t)pos };
+    size_t temp_offset = 4;
+    /* Decoding the UInt32 cannot fail */
+    UA_UInt32_decodeBinary(&temp, &temp_offset, chunkLength);
+
+    /* The message size is not allowed */
+    if(*chunkLength < 16 || *chunkLength > connection->localConf.recvBufferSize)
+        return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
     return UA_STATUSCODE_GOOD;
 }
 
+/* Buffer the beginning of a chunk that continues in the next packet. The buffer
+ * is allocated for the entire chunk if the header is known. The length of
+ * connection->incompleteMessage is the number of bytes received so far. */
 static UA_StatusCode
-bufferIncompleteChunk(UA_Connection *connection, const UA_Byte *pos, const UA_Byte *end) {
+bufferIncompleteChunk(UA_Connection *connection, const UA_Byte *pos,
+                      const UA_Byte *end, size_t chunkLength) {
     size_t length = (uintptr_t)end - (uintptr_t)pos;
-    UA_StatusCode retval = UA_ByteString_allocBuffer(&connection->incompleteMessage, length);
+    if(length == 0)
+        return UA_STATUSCODE_GOOD;
+    UA_StatusCode retval = UA_ByteString_allocBuffer(&connection->incompleteMessage,
+                                                     chunkLength);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
     memcpy(connection->incompleteMessage.data, pos, length);
+    connection->incompleteMessage.length = length;
     return UA_STATUSCODE_GOOD;
 }
 
+/* Copy only the missing bytes of the buffered chunk from the beginning of the
+ * packet. The position is moved behind the copied bytes. The buffer is released
+ * if an error occurs. */
+static UA_StatusCode
+completeIncompleteChunk(UA_Connection *connection, const UA_Byte **posp,
+                        const UA_Byte *end, UA_Boolean *complete) {
+    UA_ByteString *buf = &connection->incompleteMessage;
+    UA_UInt32 chunkLength = UA_CHUNK_HEADER_LENGTH;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    *complete = false;
+
+    /* If the header is known, the buffer has the size of the chunk */
+    UA_Boolean headerKnown = (buf->length >= UA_CHUNK_HEADER_LENGTH);
+    if(headerKnown)
+        retval = checkChunkHeader(connection, buf->data, &chunkLength);
+
+    while(retval == UA_STATUSCODE_GOOD && *posp < end) {
+        size_t missing = chunkLength - buf->length;
+        size_t available = (uintptr_t)end - (uintptr_t)*posp;
+        size_t length = missing < available ? missing : available;
+        memcpy(&buf->data[buf->length], *posp, length);
+        buf->length += length;
+        *posp += length;
+        if(buf->length < chunkLength)
+            break;
+
+        /* The chunk is complete */
+        if(headerKnown) {
+            *complete = true;
+            break;
+        }
+
+        /* The header is complete. Grow the buffer to the size of the chunk. */
+        retval = checkChunkHeader(connection, buf->data, &chunkLength);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
+        UA_Byte *data = (UA_Byte*)UA_realloc(buf->data, chunkLength);
+        if(!data) {
+            retval = UA_STATUSCODE_BADOUTOFMEMORY;
+            break;
+        }
+        buf->data = data;
+        headerKnown = true;
+    }
+
+    if(retval != UA_STATUSCODE_GOOD)
+        UA_ByteString_deleteMembers(buf);
+    return retval;
+}
+
 static UA_StatusCode
 processChunk(UA_Connection *connection, void *application,
              UA_Connection_processChunk processCallback,
@@ -17743,43 +18816,20 @@ processChunk(UA_Connection *connection, void *application,
     size_t length = (uintptr_t)end - (uintptr_t)pos;
 
     /* At least 8 byte needed for the header. Wait for the next chunk. */
-    if(length < 8) {
-        bufferIncompleteChunk(connection, pos, end);
+    if(length < UA_CHUNK_HEADER_LENGTH) {
         *done = true;
-        return UA_STATUSCODE_GOOD;
-    }
-
-    /* Check the message type */
-    UA_MessageType msgtype = (UA_MessageType)((UA_UInt32)pos[0] + ((UA_UInt32)pos[1] << 8) +
-        ((UA_UInt32)pos[2] << 16));
-    if(msgtype != UA_MESSAGETYPE_MSG && msgtype != UA_MESSAGETYPE_ERR &&
-       msgtype != UA_MESSAGETYPE_OPN && msgtype != UA_MESSAGETYPE_HEL &&
-       msgtype != UA_MESSAGETYPE_ACK && msgtype != UA_MESSAGETYPE_CLO) {
-        /* The message type is not recognized */
-        return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
-    }
-
-    UA_Byte isFinal = pos[3];
-    if(isFinal != 'C' && isFinal != 'F' && isFinal != 'A') {
-        /* The message type is not recognized */
-        return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
+        return bufferIncompleteChunk(connection, pos, end, UA_CHUNK_HEADER_LENGTH);
     }
 
     UA_UInt32 chunk_length = 0;
-    UA_ByteString temp = { 8, (UA_Byte*)(uintptr_t)pos }; /* At least 8 byte left */
-    size_t temp_offset = 4;
-    /* Decoding the UInt32 cannot fail */
-    UA_UInt32_decodeBinary(&temp, &temp_offset, &chunk_length);
-
-    /* The message size is not allowed */
-    if(chunk_length < 16 || chunk_length > connection->localConf.recvBufferSize)
-        return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
+    UA_StatusCode retval = checkChunkHeader(connection, pos, &chunk_length);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
 
     /* Wait for the next packet to process the complete chunk */
     if(chunk_length > length) {
-        bufferIncompleteChunk(connection, pos, end);
         *done = true;
-        return UA_STATUSCODE_GOOD;
+        return bufferIncompleteChunk(connection, pos, end, chunk_length);
     }
 
     /* Set pendingMessage if there is a message after this message */
@@ -17787,9 +18837,9 @@ processChunk(UA_Connection *connection, void *application,
         connection->pendingMessage = true;
 
     /* Process the chunk; forward the position pointer */
-    temp.length = chunk_length;
+    UA_ByteString temp = { chunk_length, (UA_Byte*)(uintptr_t)pos };
     *posp += chunk_length;
-    *done = false;
+    *done = (*posp == end);
     return processCallback(application, connection, &temp);
 }
 
@@ -17797,31 +18847,34 @@ UA_StatusCode
 UA_Connection_processChunks(UA_Connection *connection, void *application,
                             UA_Connection_processChunk processCallback,
                             const UA_ByteString *packet) {
-    /* If we have stored an incomplete chunk, prefix to the received message.
-     * After this block, connection->incompleteMessage is always empty. The
-     * message and the buffer is released if allocating the memory fails. */
-    UA_Boolean realloced = false;
-    UA_ByteString message = *packet;
-    UA_StatusCode retval;
+    const UA_Byte *pos = packet->data;
+    const UA_Byte *end = &packet->data[packet->length];
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+
+    /* Complete a chunk stored from the previous packet. Only the missing bytes
+     * are copied. The remainder of the packet is processed in place. */
     if(connection->incompleteMessage.length > 0) {
-        retval = prependIncompleteChunk(connection, &message);
-        if(retval != UA_STATUSCODE_GOOD)
+        UA_Boolean complete = false;
+        retval = completeIncompleteChunk(connection, &pos, end, &complete);
+        if(retval != UA_STATUSCODE_GOOD || !complete)
             return retval;
-        realloced = true;
+
+        UA_ByteString chunk = connection->incompleteMessage;
+        connection->incompleteMessage = UA_BYTESTRING_NULL;
+        if(pos < end)
+            connection->pendingMessage = true;
+        retval = processCallback(application, connection, &chunk);
+        connection->pendingMessage = false;
+        UA_ByteString_deleteMembers(&chunk);
     }
 
     /* Loop over the received chunks. pos is increased with each chunk. */
-    const UA_Byte *pos = message.data;
-    const UA_Byte *end = &message.data[message.length];
-    UA_Boolean done = true;
-    do {
+    UA_Boolean done = (pos == end);
+    while(!done && retval == UA_STATUSCODE_GOOD) {
         retval = processChunk(connection, application, processCallback,
                               &pos, end, &done);
         connection->pendingMessage = false;
-    } while(!done && retval == UA_STATUSCODE_GOOD);
-
-    if(realloced)
-        UA_ByteString_deleteMembers(&message);
+    }
     return retval;
 }
 
@@ -18005,11 +19058,7 @@ UA_SecureChannel_deleteMembersCleanup(UA_SecureChannel *channel) {
     /* Remove the buffered chunks */
     struct MessageEntry *me, *temp_me;
     LIST_FOREACH_SAFE(me, &channel->chunks, pointers, temp_me) {
-        struct ChunkPayload *cp, *temp_cp;
-        SIMPLEQ_FOREACH_SAFE(cp, &me->chunkPayload, pointers, temp_cp) {
-            UA_ByteString_deleteMembers(&cp->bytes);
-            UA_free(cp);
-        }
+        UA_ByteString_deleteMembers(&me->message);
         LIST_REMOVE(me, pointers);
         UA_free(me);
     }
@@ -18410,6 +19459,15 @@ setBufPos(UA_MessageContext *mc) {
     }
 }
 
+/* Release the chunks of a message that is not sent completely */
+static void
+releaseQueuedChunks(UA_MessageContext *mc) {
+    UA_Connection *connection = mc->channel->connection;
+    for(size_t i = 0; i < mc->queuedChunksSize; i++)
+        connection->releaseSendBuffer(connection, &mc->queuedChunks[i]);
+    mc->queuedChunksSize = 0;
+}
+
 static UA_StatusCode
 sendSymmetricChunk(UA_MessageContext *mc) {
     UA_StatusCode res = UA_STATUSCODE_GOOD;
@@ -18433,6 +19491,7 @@ sendSymmetricChunk(UA_MessageContext *mc) {
         res = UA_STATUSCODE_BADRESPONSETOOLARGE;
     if(res != UA_STATUSCODE_GOOD) {
         connection->releaseSendBuffer(channel->connection, &mc->messageBuffer);
+        releaseQueuedChunks(mc);
         return res;
     }
 
@@ -18518,11 +19577,25 @@ sendSymmetricChunk(UA_MessageContext *mc) {
 
     if(res != UA_STATUSCODE_GOOD) {
         connection->releaseSendBuffer(channel->connection, &mc->messageBuffer);
+        releaseQueuedChunks(mc);
         return res;
     }
 
     /* Send the chunk, the buffer is freed in the network layer */
-    return connection->send(channel->connection, &mc->messageBuffer);
+    if(!connection->sendChunks)
+        return connection->send(channel->connection, &mc->messageBuffer);
+
+    /* Queue the chunk. Send the queue with the last chunk of the message or
+     * when it is full. */
+    mc->queuedChunks[mc->queuedChunksSize] = mc->messageBuffer;
+    mc->queuedChunksSize++;
+    UA_ByteString_init(&mc->messageBuffer);
+    if(!mc->final && mc->queuedChunksSize < UA_MESSAGECONTEXT_MAXQUEUEDCHUNKS)
+        return UA_STATUSCODE_GOOD;
+    size_t queuedChunksSize = mc->queuedChunksSize;
+    mc->queuedChunksSize = 0;
+    return connection->sendChunks(channel->connection, mc->queuedChunks,
+                                  queuedChunksSize);
 }
 
 /* Callback from the encoding layer. Send the chunk and replace the buffer. */
@@ -18569,6 +19642,7 @@ UA_MessageContext_begin(UA_MessageContext *mc, UA_SecureChannel *channel,
     mc->messageSizeSoFar = 0;
     mc->final = false;
     mc->messageBuffer = UA_BYTESTRING_NULL;
+    mc->queuedChunksSize = 0;
     mc->messageType = messageType;
 
     /* Minimum required size */
@@ -18598,6 +19672,7 @@ UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
             UA_Connection *connection = mc->channel->connection;
             connection->releaseSendBuffer(connection, &mc->messageBuffer);
         }
+        releaseQueuedChunks(mc);
     }
     return retval;
 }
@@ -18612,6 +19687,7 @@ void
 UA_MessageContext_abort(UA_MessageContext *mc) {
     UA_Connection *connection = mc->channel->connection;
     connection->releaseSendBuffer(connection, &mc->messageBuffer);
+    releaseQueuedChunks(mc);
 }
 
 UA_StatusCode
@@ -18656,11 +19732,7 @@ UA_SecureChannel_removeChunks(UA_SecureChannel *channel, UA_UInt32 requestId) {
     struct MessageEntry *me;
     LIST_FOREACH(me, &channel->chunks, pointers) {
         if(me->requestId == requestId) {
-            struct ChunkPayload *cp, *temp_cp;
-            SIMPLEQ_FOREACH_SAFE(cp, &me->chunkPayload, pointers, temp_cp) {
-                UA_ByteString_deleteMembers(&cp->bytes);
-                UA_free(cp);
-            }
+            UA_ByteString_deleteMembers(&me->message);
             LIST_REMOVE(me, pointers);
             UA_free(me);
             return;
@@ -18668,16 +19740,43 @@ UA_SecureChannel_removeChunks(UA_SecureChannel *channel, UA_UInt32 requestId) {
     }
 }
 
+/* Copy the chunk body to the end of the message. This is the only copy of the
+ * body before it is decoded. The buffer grows geometrically, so that reallocs
+ * are rare. Large blocks are mostly moved without copying by realloc. The
+ * limits are those announced to the remote side in the HEL/ACK handshake. */
 static UA_StatusCode
-appendChunk(struct MessageEntry *messageEntry, const UA_ByteString *chunkBody) {
-    
-    struct ChunkPayload* cp = (struct ChunkPayload*)UA_malloc(sizeof(struct ChunkPayload));
-    UA_StatusCode retval = UA_ByteString_copy(chunkBody, &cp->bytes);
-    if (retval != UA_STATUSCODE_GOOD)
-        return retval;
-    
-    SIMPLEQ_INSERT_TAIL(&messageEntry->chunkPayload, cp, pointers);
-    messageEntry->chunkPayloadSize += chunkBody->length;
+appendChunk(UA_SecureChannel *channel, struct MessageEntry *messageEntry,
+            const UA_ByteString *chunkBody) {
+    UA_UInt32 maxMessageSize = 0;
+    UA_UInt32 maxChunkCount = 0;
+    if(channel->connection) {
+        maxMessageSize = channel->connection->localConf.maxMessageSize;
+        maxChunkCount = channel->connection->localConf.maxChunkCount;
+    }
+
+    size_t length = messageEntry->message.length + chunkBody->length;
+    messageEntry->chunkCount++;
+    if((maxMessageSize != 0 && length > maxMessageSize) ||
+       (maxChunkCount != 0 && messageEntry->chunkCount > maxChunkCount))
+        return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
+
+    if(length > messageEntry->messageCapacity) {
+        /* Leave room for at least one more chunk of the same size */
+        size_t capacity = messageEntry->messageCapacity * 2;
+        if(capacity < length + chunkBody->length)
+            capacity = length + chunkBody->length;
+        if(maxMessageSize != 0 && capacity > maxMessageSize)
+            capacity = maxMessageSize;
+        UA_Byte *data = (UA_Byte*)UA_realloc(messageEntry->message.data, capacity);
+        if(!data)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        messageEntry->message.data = data;
+        messageEntry->messageCapacity = capacity;
+    }
+
+    memcpy(&messageEntry->message.data[messageEntry->message.length],
+           chunkBody->data, chunkBody->length);
+    messageEntry->message.length = length;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -18697,11 +19796,10 @@ UA_SecureChannel_appendChunk(UA_SecureChannel *channel, UA_UInt32 requestId,
             return UA_STATUSCODE_BADOUTOFMEMORY;
         memset(me, 0, sizeof(struct MessageEntry));
         me->requestId = requestId;
-        SIMPLEQ_INIT(&me->chunkPayload);
         LIST_INSERT_HEAD(&channel->chunks, me, pointers);
     }
 
-    return appendChunk(me, chunkBody);
+    return appendChunk(channel, me, chunkBody);
 }
 
 static UA_StatusCode
@@ -18714,38 +19812,22 @@ UA_SecureChannel_finalizeChunk(UA_SecureChannel *channel, UA_UInt32 requestId,
             break;
     }
 
+    /* A single chunk is decoded from the received buffer */
     UA_ByteString bytes;
     if(!messageEntry) {
         bytes = *chunkBody;
-    } else {
-        UA_StatusCode retval = appendChunk(messageEntry, chunkBody);
-        if(retval != UA_STATUSCODE_GOOD)
-            return retval;
-        
-        UA_ByteString_init(&bytes);
-
-        bytes.data = (UA_Byte*) UA_malloc(messageEntry->chunkPayloadSize);
-        if (!bytes.data)
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-
-        struct ChunkPayload *cp, *temp_cp;
-        size_t curPos = 0;
-        SIMPLEQ_FOREACH_SAFE(cp, &messageEntry->chunkPayload, pointers, temp_cp) {
-            memcpy(&bytes.data[curPos], cp->bytes.data, cp->bytes.length);
-            curPos += cp->bytes.length;
-            UA_ByteString_deleteMembers(&cp->bytes);
-            UA_free(cp);
-        }
-
-        bytes.length = messageEntry->chunkPayloadSize;
-
-        LIST_REMOVE(messageEntry, pointers);
-        UA_free(messageEntry);
+        return callback(application, channel, messageType, requestId, &bytes);
     }
 
-    UA_StatusCode retval = callback(application, channel, messageType, requestId, &bytes);
-    if(messageEntry)
-        UA_ByteString_deleteMembers(&bytes);
+    /* Take the assembled message from the channel */
+    UA_StatusCode retval = appendChunk(channel, messageEntry, chunkBody);
+    bytes = messageEntry->message;
+    LIST_REMOVE(messageEntry, pointers);
+    UA_free(messageEntry);
+
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = callback(application, channel, messageType, requestId, &bytes);
+    UA_ByteString_deleteMembers(&bytes);
     return retval;
 }
 
@@ -19098,6 +20180,7 @@ void UA_Session_init(UA_Session *session) {
     session->availableContinuationPoints = UA_MAXCONTINUATIONPOINTS;
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     SIMPLEQ_INIT(&session->responseQueue);
+    TAILQ_INIT(&session->retransmissionQueue);
 #endif
 }
 
@@ -19714,6 +20797,102 @@ UA_Node_setAttributes(UA_Node *node, const void *attributes,
 /* Manage References */
 /*********************/
 
+size_t UA_Node_referenceIndexThreshold = 64;
+
+/* The target index is an open-addressing hash table with linear probing. Its
+ * size is a power of two and it is kept at most half full. */
+
+static void
+deleteReferenceIndex(UA_NodeReferenceKind *refs) {
+    UA_free(refs->targetIdsIndex);
+    refs->targetIdsIndex = NULL;
+    refs->targetIdsIndexSize = 0;
+}
+
+static size_t
+referenceIndexHome(const UA_NodeReferenceKind *refs, const UA_NodeId *targetId) {
+    return UA_NodeId_hash(targetId) & (refs->targetIdsIndexSize - 1);
+}
+
+static void
+referenceIndexInsert(UA_NodeReferenceKind *refs, size_t position) {
+    size_t mask = refs->targetIdsIndexSize - 1;
+    size_t idx = referenceIndexHome(refs, &refs->targetIds[position].nodeId);
+    while(refs->targetIdsIndex[idx] != 0)
+        idx = (idx + 1) & mask;
+    refs->targetIdsIndex[idx] = position + 1;
+}
+
+/* (Re)build the index for the current targets. Without memory, the targets are
+ * just scanned linearly. */
+static void
+buildReferenceIndex(UA_NodeReferenceKind *refs) {
+    size_t size = 16;
+    while(size < refs->targetIdsSize * 2)
+        size <<= 1;
+    size_t *index = (size_t*)UA_calloc(size, sizeof(size_t));
+    if(!index) {
+        deleteReferenceIndex(refs);
+        return;
+    }
+    UA_free(refs->targetIdsIndex);
+    refs->targetIdsIndex = index;
+    refs->targetIdsIndexSize = size;
+    for(size_t i = 0; i < refs->targetIdsSize; i++)
+        referenceIndexInsert(refs, i);
+}
+
+/* Returns the index bucket holding the target position, or the index size if
+ * no target matches. With matchExpanded, the namespace uri and server index of
+ * the target have to match as well. */
+static size_t
+referenceIndexFind(const UA_NodeReferenceKind *refs, const UA_ExpandedNodeId *target,
+                   UA_Boolean matchExpanded) {
+    size_t mask = refs->targetIdsIndexSize - 1;
+    size_t idx = referenceIndexHome(refs, &target->nodeId);
+    while(refs->targetIdsIndex[idx] != 0) {
+        const UA_ExpandedNodeId *candidate = &refs->targetIds[refs->targetIdsIndex[idx] - 1];
+        if(matchExpanded ? UA_ExpandedNodeId_equal(candidate, target) :
+           UA_NodeId_equal(&candidate->nodeId, &target->nodeId))
+            return idx;
+        idx = (idx + 1) & mask;
+    }
+    return refs->targetIdsIndexSize;
+}
+
+/* Remove the bucket and move the following buckets of the probe sequence back
+ * to close the gap */
+static void
+referenceIndexRemoveBucket(UA_NodeReferenceKind *refs, size_t idx) {
+    size_t mask = refs->targetIdsIndexSize - 1;
+    size_t next = (idx + 1) & mask;
+    while(refs->targetIdsIndex[next] != 0) {
+        size_t home = referenceIndexHome(refs, &refs->targetIds[refs->targetIdsIndex[next] - 1].nodeId);
+        /* Move the bucket if its home is not in the cyclic range (idx, next] */
+        if(((next - home) & mask) >= ((next - idx) & mask)) {
+            refs->targetIdsIndex[idx] = refs->targetIdsIndex[next];
+            idx = next;
+        }
+        next = (next + 1) & mask;
+    }
+    refs->targetIdsIndex[idx] = 0;
+}
+
+/* Point the bucket of the target at oldPosition to newPosition. The probe
+ * sequence ends at the first empty bucket. */
+static void
+referenceIndexMove(UA_NodeReferenceKind *refs, size_t oldPosition, size_t newPosition) {
+    size_t mask = refs->targetIdsIndexSize - 1;
+    size_t idx = referenceIndexHome(refs, &refs->targetIds[oldPosition].nodeId);
+    while(refs->targetIdsIndex[idx] != 0) {
+        if(refs->targetIdsIndex[idx] == oldPosition + 1) {
+            refs->targetIdsIndex[idx] = newPosition + 1;
+            return;
+        }
+        idx = (idx + 1) & mask;
+    }
+}
+
 static UA_StatusCode
 addReferenceTarget(UA_NodeReferenceKind *refs, const UA_ExpandedNodeId *target) {
     UA_ExpandedNodeId *targets =
@@ -19733,6 +20912,16 @@ addReferenceTarget(UA_NodeReferenceKind *refs, const UA_ExpandedNodeId *target)
         UA_free(refs->targetIds);
         refs->targetIds = NULL;
     }
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(!refs->targetIdsIndex && refs->targetIdsSize <= UA_Node_referenceIndexThreshold)
+        return retval;
+
+    /* Maintain the target index */
+    if(refs->targetIdsIndex && refs->targetIdsSize * 2 <= refs->targetIdsIndexSize)
+        referenceIndexInsert(refs, refs->targetIdsSize - 1);
+    else
+        buildReferenceIndex(refs);
     return retval;
 }
 
@@ -19775,10 +20964,16 @@ UA_Node_addReference(UA_Node *node, const UA_AddReferencesItem *item) {
         }
     }
     if(existingRefs != NULL) {
-        for(size_t i = 0; i < existingRefs->targetIdsSize; i++) {
-            if(UA_ExpandedNodeId_equal(&existingRefs->targetIds[i],
-                                       &item->targetNodeId)) {
+        if(existingRefs->targetIdsIndex) {
+            if(referenceIndexFind(existingRefs, &item->targetNodeId, true) !=
+               existingRefs->targetIdsIndexSize)
                 return UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED;
+        } else {
+            for(size_t i = 0; i < existingRefs->targetIdsSize; i++) {
+                if(UA_ExpandedNodeId_equal(&existingRefs->targetIds[i],
+                                           &item->targetNodeId)) {
+                    return UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED;
+                }
             }
         }
         return addReferenceTarget(existingRefs, &item->targetNodeId);
@@ -19795,7 +20990,20 @@ UA_Node_deleteReference(UA_Node *node, const UA_DeleteReferencesItem *item) {
         if(!UA_NodeId_equal(&item->referenceTypeId, &refs->referenceTypeId))
             continue;
 
-        for(size_t j = refs->targetIdsSize; j > 0; --j) {
+        size_t j = refs->targetIdsSize;
+        if(refs->targetIdsIndex) {
+            /* Look up the target in the index and keep the index up to date
+             * for the removal and for the last target moving into the gap */
+            size_t idx = referenceIndexFind(refs, &item->targetNodeId, false);
+            if(idx == refs->targetIdsIndexSize)
+                continue;
+            j = refs->targetIdsIndex[idx];
+            referenceIndexRemoveBucket(refs, idx);
+            if(j != refs->targetIdsSize)
+                referenceIndexMove(refs, refs->targetIdsSize - 1, j - 1);
+        }
+
+        for(; j > 0; --j) {
             if(!UA_NodeId_equal(&item->targetNodeId.nodeId, &refs->targetIds[j-1].nodeId))
                 continue;
 
@@ -19809,11 +21017,16 @@ UA_Node_deleteReference(UA_Node *node, const UA_DeleteReferencesItem *item) {
                                                // and destination overlap in
                                                // memcpy
                     refs->targetIds[j-1] = refs->targetIds[refs->targetIdsSize];
+                /* Below the threshold, the targets are scanned again */
+                if(refs->targetIdsIndex &&
+                   refs->targetIdsSize <= UA_Node_referenceIndexThreshold)
+                    deleteReferenceIndex(refs);
                 return UA_STATUSCODE_GOOD;
             }
 
             /* Remove refs */
             UA_free(refs->targetIds);
+            deleteReferenceIndex(refs);
             UA_NodeId_deleteMembers(&refs->referenceTypeId);
             node->referencesSize--;
             if(node->referencesSize > 0) {
@@ -19837,6 +21050,7 @@ void UA_Node_deleteReferences(UA_Node *node) {
     for(size_t i = 0; i < node->referencesSize; ++i) {
         UA_NodeReferenceKind *refs = &node->references[i];
         UA_Array_delete(refs->targetIds, refs->targetIdsSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+        deleteReferenceIndex(refs);
         UA_NodeId_deleteMembers(&refs->referenceTypeId);
     }
     if(node->references)
@@ -19947,6 +21161,14 @@ void UA_Server_delete(UA_Server *server) {
     UA_SecureChannelManager_deleteMembers(&server->secureChannelManager);
     UA_SessionManager_deleteMembers(&server->sessionManager);
     UA_Array_delete(server->namespaces, server->namespacesSize, &UA_TYPES[UA_TYPES_STRING]);
+    if(server->requestArena) {
+        UA_Arena_deleteMembers(server->requestArena);
+        UA_free(server->requestArena);
+    }
+    if(server->browseCache) {
+        UA_BrowseCache_deleteMembers(server->browseCache);
+        UA_free(server->browseCache);
+    }
 
 #ifdef UA_ENABLE_DISCOVERY
     registeredServer_list_entry *rs, *rs_tmp;
@@ -20001,6 +21223,12 @@ void UA_Server_delete(UA_Server *server) {
     UA_Server_cleanupDelayedCallbacks(server);
 #endif
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* The Subscriptions are deleted with the sessions */
+    UA_BlockPool_deleteMembers(&server->notificationPool);
+    UA_BlockPool_deleteMembers(&server->retransmissionPool);
+#endif
+
     /* Delete the timed work */
     UA_Timer_deleteMembers(&server->timer);
 
@@ -20008,11 +21236,11 @@ void UA_Server_delete(UA_Server *server) {
     UA_free(server);
 }
 
-/* Recurring cleanup. Removing unused and timed-out channels and sessions */
+/* Recurring cleanup. Removing unused and timed-out channels. Sessions are
+ * removed by a callback of the session manager when they time out. */
 static void
 UA_Server_cleanup(UA_Server *server, void *_) {
     UA_DateTime nowMonotonic = UA_DateTime_nowMonotonic();
-    UA_SessionManager_cleanupTimedOut(&server->sessionManager, nowMonotonic);
     UA_SecureChannelManager_cleanupTimedOut(&server->secureChannelManager, nowMonotonic);
 #ifdef UA_ENABLE_DISCOVERY
     UA_Discovery_cleanupTimedOut(server, nowMonotonic);
@@ -20023,6 +21251,8 @@ UA_Server_cleanup(UA_Server *server, void *_) {
 /* Server Lifecycle */
 /********************/
 
+size_t UA_Server_requestArenaSize = 1024 * 1024;
+
 UA_Server *
 UA_Server_new(const UA_ServerConfig *config) {
     /* A config is required */
@@ -20070,6 +21300,27 @@ UA_Server_new(const UA_ServerConfig *config) {
     SLIST_INIT(&server->delayedCallbacks);
 #endif
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    UA_BlockPool_init(&server->notificationPool, sizeof(UA_Notification),
+                      UA_Server_maxPooledNotifications);
+    UA_BlockPool_init(&server->retransmissionPool, sizeof(UA_NotificationMessageEntry),
+                      UA_Server_maxPooledNotifications);
+#endif
+
+    /* Without the arena, requests are decoded on the heap */
+    if(UA_Server_requestArenaSize > 0) {
+        server->requestArena = (UA_Arena*)UA_malloc(sizeof(UA_Arena));
+        if(server->requestArena)
+            UA_Arena_init(server->requestArena, UA_Server_requestArenaSize);
+    }
+
+    /* Without the cache, every browse takes the targets from the nodestore */
+    if(UA_Server_browseCacheSize > 0) {
+        server->browseCache = (UA_BrowseCache*)UA_malloc(sizeof(UA_BrowseCache));
+        if(server->browseCache)
+            UA_BrowseCache_init(server->browseCache, UA_Server_browseCacheSize);
+    }
+
     /* Initialized the dispatch queue for worker threads */
 #ifdef UA_ENABLE_MULTITHREADING
     SIMPLEQ_INIT(&server->dispatchQueue);
@@ -20712,26 +21963,64 @@ writeNs0VariableArray(UA_Server *server, UA_UInt32 id, void *v,
     return UA_Server_writeValue(server, UA_NODEID_NUMERIC(0, id), var);
 }
 
+/* The first server of the process builds namespace 0 into a nodestore of its
+ * own that becomes the image shared by the default nodestores. Returns true if
+ * the nodestore of the server finds the nodes of the image. */
+static UA_Boolean
+useNS0Image(UA_Server *server) {
+    if(!UA_Nodestore_default_hasNS0Image()) {
+        UA_Nodestore nodestore = server->config.nodestore;
+        if(UA_Nodestore_default_new(&server->config.nodestore) != UA_STATUSCODE_GOOD) {
+            server->config.nodestore = nodestore;
+            return false;
+        }
+        server->bootstrapNS0 = true;
+        UA_StatusCode retVal = UA_Server_createNS0_base(server);
+        if(retVal == UA_STATUSCODE_GOOD)
+            retVal = ua_namespace0(server);
+        server->bootstrapNS0 = false;
+        UA_Nodestore image = server->config.nodestore;
+        server->config.nodestore = nodestore;
+        if(retVal == UA_STATUSCODE_GOOD)
+            retVal = UA_Nodestore_default_setNS0Image(&image);
+        if(retVal != UA_STATUSCODE_GOOD) {
+            image.deleteNodestore(image.context);
+            /* Another server of the process was faster */
+            if(!UA_Nodestore_default_hasNS0Image())
+                return false;
+        }
+    }
+
+    UA_NodeId serverNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    const UA_Node *node = UA_Nodestore_get(server, &serverNodeId);
+    if(!node)
+        return false;
+    UA_Nodestore_release(server, node);
+    return true;
+}
+
 /* Initialize the nodeset 0 by using the generated code of the nodeset compiler.
  * This also initialized the data sources for various variables, such as for
  * example server time. */
 UA_StatusCode
 UA_Server_initNS0(UA_Server *server) {
-
-    /* Initialize base nodes which are always required an cannot be created
-     * through the NS compiler */
-    server->bootstrapNS0 = true;
-    UA_StatusCode retVal = UA_Server_createNS0_base(server);
-    server->bootstrapNS0 = false;
-    if(retVal != UA_STATUSCODE_GOOD)
-        return retVal;
-
-    /* Load nodes and references generated from the XML ns0 definition */
-    server->bootstrapNS0 = true;
-    retVal = ua_namespace0(server);
-    server->bootstrapNS0 = false;
-    if(retVal != UA_STATUSCODE_GOOD)
-        return retVal;
+    UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+    if(!UA_Nodestore_default_shareNS0 || !useNS0Image(server)) {
+        /* Initialize base nodes which are always required an cannot be created
+         * through the NS compiler */
+        server->bootstrapNS0 = true;
+        retVal = UA_Server_createNS0_base(server);
+        server->bootstrapNS0 = false;
+        if(retVal != UA_STATUSCODE_GOOD)
+            return retVal;
+
+        /* Load nodes and references generated from the XML ns0 definition */
+        server->bootstrapNS0 = true;
+        retVal = ua_namespace0(server);
+        server->bootstrapNS0 = false;
+        if(retVal != UA_STATUSCODE_GOOD)
+            return retVal;
+    }
 
     /* NamespaceArray */
     UA_DataSource namespaceDataSource = {readNamespaces, NULL};
@@ -26188,6 +27477,19 @@ processOPN(UA_Server *server, UA_SecureChannel *channel,
     return retval;
 }
 
+/* Deletes the decoded request. If it was decoded into the arena, the arena is
+ * reset and given back to the server. */
+static void
+deleteRequest(UA_Server *server, UA_Arena *arena, void *request,
+              const UA_DataType *requestType) {
+    if(!arena) {
+        UA_deleteMembers(request, requestType);
+        return;
+    }
+    UA_Arena_reset(arena);
+    UA_atomic_storePtr((void * volatile *)&server->requestArena, arena);
+}
+
 static UA_StatusCode
 processMSG(UA_Server *server, UA_SecureChannel *channel,
            UA_UInt32 requestId, const UA_ByteString *msg) {
@@ -26230,13 +27532,20 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
     }
     UA_assert(responseType);
 
-    /* Decode the request */
+    /* Decode the request. Take the arena unless another request is using it.
+     * The services only read the request and copy what they keep. Fuzzing
+     * replaces the authenticationToken with a copy from the heap. */
+    UA_Arena *arena = NULL;
+#ifndef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+    arena = (UA_Arena*)UA_atomic_xchg((void * volatile *)&server->requestArena, NULL);
+#endif
     UA_STACKARRAY(UA_Byte, request, requestType->memSize);
     UA_RequestHeader *requestHeader = (UA_RequestHeader*)request;
-    retval = UA_decodeBinary(msg, &offset, request, requestType,
-                             server->config.customDataTypesSize,
-                             server->config.customDataTypes);
+    retval = UA_decodeBinaryArena(msg, &offset, request, requestType,
+                                  server->config.customDataTypesSize,
+                                  server->config.customDataTypes, arena);
     if(retval != UA_STATUSCODE_GOOD) {
+        deleteRequest(server, arena, request, requestType);
         UA_LOG_DEBUG_CHANNEL(server->config.logger, channel,
                              "Could not decode the request");
         return sendServiceFault(channel, msg, requestPos, responseType, requestId, retval);
@@ -26280,7 +27589,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
             UA_LOG_DEBUG_CHANNEL(server->config.logger, channel,
                                  "Trying to activate a session that is " \
                                  "not known in the server");
-            UA_deleteMembers(request, requestType);
+            deleteRequest(server, arena, request, requestType);
             return sendServiceFault(channel, msg, requestPos, responseType,
                                     requestId, UA_STATUSCODE_BADSESSIONIDINVALID);
         }
@@ -26297,7 +27606,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
             UA_LOG_WARNING_CHANNEL(server->config.logger, channel,
                                    "Service request %i without a valid session",
                                    requestType->binaryEncodingId);
-            UA_deleteMembers(request, requestType);
+            deleteRequest(server, arena, request, requestType);
             return sendServiceFault(channel, msg, requestPos, responseType,
                                     requestId, UA_STATUSCODE_BADSESSIONIDINVALID);
         }
@@ -26315,7 +27624,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
                                requestType->binaryEncodingId);
         UA_SessionManager_removeSession(&server->sessionManager,
                                         &session->header.authenticationToken);
-        UA_deleteMembers(request, requestType);
+        deleteRequest(server, arena, request, requestType);
         return sendServiceFault(channel, msg, requestPos, responseType,
                                 requestId, UA_STATUSCODE_BADSESSIONNOTACTIVATED);
     }
@@ -26325,7 +27634,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
         UA_LOG_WARNING_CHANNEL(server->config.logger, channel,
                                "Client tries to use a Session that is not "
                                "bound to this SecureChannel");
-        UA_deleteMembers(request, requestType);
+        deleteRequest(server, arena, request, requestType);
         return sendServiceFault(channel, msg, requestPos, responseType,
                                 requestId, UA_STATUSCODE_BADSECURECHANNELIDINVALID);
     }
@@ -26338,7 +27647,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
     if(requestType == &UA_TYPES[UA_TYPES_PUBLISHREQUEST]) {
         Service_Publish(server, session,
             (const UA_PublishRequest*)request, requestId);
-        UA_deleteMembers(request, requestType);
+        deleteRequest(server, arena, request, requestType);
         return UA_STATUSCODE_GOOD;
     }
 #endif
@@ -26400,7 +27709,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
                             "Could not send the message over the SecureChannel "
                             "with StatusCode %s", UA_StatusCode_name(retval));
     /* Clean up */
-    UA_deleteMembers(request, requestType);
+    deleteRequest(server, arena, request, requestType);
     UA_deleteMembers(response, responseType);
     return retval;
 }
@@ -26978,20 +28287,28 @@ getTypeHierarchy(UA_Nodestore *ns, const UA_NodeId *leafType,
 }
 
 /* For mulithreading: make a copy of the node, edit and replace.
- * For singlethreading: edit the original */
+ * For singlethreading: edit the original, unless it is shared by the servers
+ * of the process as part of the namespace zero image */
 UA_StatusCode
 UA_Server_editNode(UA_Server *server, UA_Session *session,
                    const UA_NodeId *nodeId, UA_EditNodeCallback callback,
                    void *data) {
 #ifndef UA_ENABLE_MULTITHREADING
-    const UA_Node *node = UA_Nodestore_get(server, nodeId);
-    if(!node)
-        return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    UA_StatusCode retval = callback(server, session,
-                                    (UA_Node*)(uintptr_t)node, data);
-    UA_Nodestore_release(server, node);
-    return retval;
-#else
+    /* Edit in place, unless the nodestore hands out intermediate nodes whose
+     * changes would be lost, or the node is shared by several nodestores */
+    if(server->config.nodestore.inPlaceEditAllowed) {
+        const UA_Node *node = UA_Nodestore_get(server, nodeId);
+        if(!node)
+            return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        if(!UA_Nodestore_default_inNS0Image(&server->config.nodestore, node)) {
+            UA_StatusCode retval = callback(server, session,
+                                            (UA_Node*)(uintptr_t)node, data);
+            UA_Nodestore_release(server, node);
+            return retval;
+        }
+        UA_Nodestore_release(server, node);
+    }
+#endif
     UA_StatusCode retval;
     do {
         UA_Node *node;
@@ -27005,9 +28322,10 @@ UA_Server_editNode(UA_Server *server, UA_Session *session,
             return retval;
         }
         retval = server->config.nodestore.replaceNode(server->config.nodestore.context, node);
-    } while(retval != UA_STATUSCODE_GOOD);
+        /* Retry only if the node was replaced since the copy was made. Other
+         * errors are final, e.g. a nodestore that refuses edits of a node. */
+    } while(retval == UA_STATUSCODE_BADINTERNALERROR);
     return retval;
-#endif
 }
 
 UA_StatusCode
@@ -28010,12 +29328,147 @@ UA_SecureChannelManager_close(UA_SecureChannelManager *cm, UA_UInt32 channelId)
  */
 
 
+#define UA_SESSIONINDEX_MINSIZE 16
+
+/* Sessions time out at the earliest this long after the timeout callback ran
+ * without removing all expired sessions (e.g. for lack of memory) */
+#define UA_SESSIONTIMEOUT_RETRY 1000 /* ms */
+
+/*****************/
+/* Session Index */
+/*****************/
+
+static const UA_NodeId *
+indexKey(const session_list_entry *sentry, UA_Boolean byId) {
+    return byId ? &sentry->session.sessionId :
+        &sentry->session.header.authenticationToken;
+}
+
+static session_list_entry **
+findIndexSlot(const UA_SessionManager *sm, UA_Boolean byId, const UA_NodeId *key) {
+    if(sm->indexSize == 0)
+        return NULL;
+    session_list_entry **index = byId ? sm->byId : sm->byToken;
+    UA_UInt32 h = UA_NodeId_hash(key);
+    size_t mask = sm->indexSize - 1;
+    for(size_t i = h & mask; index[i]; i = (i + 1) & mask) {
+        UA_UInt32 slotHash = byId ? index[i]->idHash : index[i]->tokenHash;
+        if(slotHash == h && UA_NodeId_equal(indexKey(index[i], byId), key))
+            return &index[i];
+    }
+    return NULL;
+}
+
+static void
+indexInsert(UA_SessionManager *sm, UA_Boolean byId, session_list_entry *sentry) {
+    session_list_entry **index = byId ? sm->byId : sm->byToken;
+    size_t mask = sm->indexSize - 1;
+    size_t i = (byId ? sentry->idHash : sentry->tokenHash) & mask;
+    while(index[i])
+        i = (i + 1) & mask;
+    index[i] = sentry;
+}
+
+static UA_StatusCode
+resizeIndex(UA_SessionManager *sm, size_t size) {
+    session_list_entry **byToken = (session_list_entry**)
+        UA_calloc(size, sizeof(session_list_entry*));
+    session_list_entry **byId = (session_list_entry**)
+        UA_calloc(size, sizeof(session_list_entry*));
+    if(!byToken || !byId) {
+        UA_free(byToken);
+        UA_free(byId);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_free(sm->byToken);
+    UA_free(sm->byId);
+    sm->byToken = byToken;
+    sm->byId = byId;
+    sm->indexSize = size;
+    session_list_entry *sentry;
+    LIST_FOREACH(sentry, &sm->sessions, pointers) {
+        indexInsert(sm, false, sentry);
+        indexInsert(sm, true, sentry);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Remove with backward shift: move following entries of the probe sequence
+ * into the gap unless that would put them before their home position */
+static void
+indexRemove(UA_SessionManager *sm, UA_Boolean byId, session_list_entry *sentry) {
+    session_list_entry **slot = findIndexSlot(sm, byId, indexKey(sentry, byId));
+    if(!slot)
+        return;
+    session_list_entry **index = byId ? sm->byId : sm->byToken;
+    size_t mask = sm->indexSize - 1;
+    size_t gap = (size_t)(slot - index);
+    for(size_t i = (gap + 1) & mask; index[i]; i = (i + 1) & mask) {
+        size_t home = (byId ? index[i]->idHash : index[i]->tokenHash) & mask;
+        if(((i - home) & mask) >= ((i - gap) & mask)) {
+            index[gap] = index[i];
+            gap = i;
+        }
+    }
+    index[gap] = NULL;
+}
+
+/********************/
+/* Session Timeouts */
+/********************/
+
+/* Make the timeout callback due at nextTimeout or earlier */
+static void
+scheduleTimeout(UA_SessionManager *sm, UA_DateTime nextTimeout,
+                UA_DateTime nowMonotonic) {
+    if(nextTimeout >= sm->nextTimeout)
+        return;
+    UA_DateTime interval =
+        (nextTimeout - nowMonotonic + UA_DATETIME_MSEC - 1) / UA_DATETIME_MSEC;
+    if(interval < 5) /* Minimum interval of the timer */
+        interval = 5;
+    if(interval > UA_UINT32_MAX)
+        interval = UA_UINT32_MAX;
+    if(UA_Timer_changeRepeatedCallbackInterval(&sm->server->timer, sm->timeoutCallbackId,
+                                               (UA_UInt32)interval) == UA_STATUSCODE_GOOD)
+        sm->nextTimeout = nextTimeout;
+}
+
+static void
+timeoutCallback(UA_Server *server, void *data) {
+    UA_SessionManager *sm = (UA_SessionManager*)data;
+    UA_DateTime nowMonotonic = UA_DateTime_nowMonotonic();
+    UA_SessionManager_cleanupTimedOut(sm, nowMonotonic);
+
+    /* Sessions were used in the meantime, wait for the earliest end of a
+     * lifetime. Sessions that could not be removed are retried later. */
+    UA_DateTime nextTimeout = nowMonotonic + (UA_DateTime)UA_UINT32_MAX * UA_DATETIME_MSEC;
+    session_list_entry *sentry;
+    LIST_FOREACH(sentry, &sm->sessions, pointers) {
+        if(sentry->session.validTill < nextTimeout)
+            nextTimeout = sentry->session.validTill;
+    }
+    if(nextTimeout < nowMonotonic)
+        nextTimeout = nowMonotonic + UA_SESSIONTIMEOUT_RETRY * UA_DATETIME_MSEC;
+    sm->nextTimeout = UA_INT64_MAX;
+    scheduleTimeout(sm, nextTimeout, nowMonotonic);
+}
+
+/*******************/
+/* Session Manager */
+/*******************/
+
 UA_StatusCode
 UA_SessionManager_init(UA_SessionManager *sm, UA_Server *server) {
     LIST_INIT(&sm->sessions);
     sm->currentSessionCount = 0;
     sm->server = server;
-    return UA_STATUSCODE_GOOD;
+    sm->byToken = NULL;
+    sm->byId = NULL;
+    sm->indexSize = 0;
+    sm->nextTimeout = UA_INT64_MAX;
+    return UA_Timer_addRepeatedCallback(&server->timer, (UA_TimerCallback)timeoutCallback,
+                                        sm, UA_UINT32_MAX, &sm->timeoutCallbackId);
 }
 
 /* Delayed callback to free the session memory */
@@ -28060,8 +29513,15 @@ removeSession(UA_SessionManager *sm, session_list_entry *sentry) {
 
     /* Detach the session from the session manager and make the capacity
      * available */
+    indexRemove(sm, false, sentry);
+    indexRemove(sm, true, sentry);
     LIST_REMOVE(sentry, pointers);
     UA_atomic_subUInt32(&sm->currentSessionCount, 1);
+
+    /* Give back memory. Failure to shrink is not an error. */
+    if(sm->indexSize > UA_SESSIONINDEX_MINSIZE &&
+       (size_t)sm->currentSessionCount * 8 < sm->indexSize)
+        resizeIndex(sm, sm->indexSize / 2);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -28070,6 +29530,12 @@ void UA_SessionManager_deleteMembers(UA_SessionManager *sm) {
     LIST_FOREACH_SAFE(current, &sm->sessions, pointers, temp) {
         removeSession(sm, current);
     }
+    UA_free(sm->byToken);
+    UA_free(sm->byId);
+    sm->byToken = NULL;
+    sm->byId = NULL;
+    sm->indexSize = 0;
+    UA_Timer_removeRepeatedCallback(&sm->server->timer, sm->timeoutCallbackId);
 }
 
 void
@@ -28092,22 +29558,9 @@ UA_SessionManager_cleanupTimedOut(UA_SessionManager *sm,
 
 UA_Session *
 UA_SessionManager_getSessionByToken(UA_SessionManager *sm, const UA_NodeId *token) {
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &sm->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.header.authenticationToken, token))
-            continue;
-
-        /* Session has timed out */
-        if(UA_DateTime_nowMonotonic() > current->session.validTill) {
-            UA_LOG_INFO_SESSION(sm->server->config.logger, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        /* Ok, return */
-        return &current->session;
-    }
+    session_list_entry **slot = findIndexSlot(sm, false, token);
+    if(slot)
+        return &(*slot)->session;
 
     /* Session not found */
     UA_LOG_INFO(sm->server->config.logger, UA_LOGCATEGORY_SESSION,
@@ -28118,22 +29571,9 @@ UA_SessionManager_getSessionByToken(UA_SessionManager *sm, const UA_NodeId *toke
 
 UA_Session *
 UA_SessionManager_getSessionById(UA_SessionManager *sm, const UA_NodeId *sessionId) {
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &sm->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.sessionId, sessionId))
-            continue;
-
-        /* Session has timed out */
-        if(UA_DateTime_nowMonotonic() > current->session.validTill) {
-            UA_LOG_INFO_SESSION(sm->server->config.logger, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        /* Ok, return */
-        return &current->session;
-    }
+    session_list_entry **slot = findIndexSlot(sm, true, sessionId);
+    if(slot)
+        return &(*slot)->session;
 
     /* Session not found */
     UA_LOG_INFO(sm->server->config.logger, UA_LOGCATEGORY_SESSION,
@@ -28149,6 +29589,14 @@ UA_SessionManager_createSession(UA_SessionManager *sm, UA_SecureChannel *channel
     if(sm->currentSessionCount >= sm->server->config.maxSessions)
         return UA_STATUSCODE_BADTOOMANYSESSIONS;
 
+    /* Keep the index at most half full */
+    if(((size_t)sm->currentSessionCount + 1) * 2 > sm->indexSize) {
+        UA_StatusCode retval =
+            resizeIndex(sm, sm->indexSize ? sm->indexSize * 2 : UA_SESSIONINDEX_MINSIZE);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
     session_list_entry *newentry = (session_list_entry *)UA_malloc(sizeof(session_list_entry));
     if(!newentry)
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -28157,6 +29605,8 @@ UA_SessionManager_createSession(UA_SessionManager *sm, UA_SecureChannel *channel
     UA_Session_init(&newentry->session);
     newentry->session.sessionId = UA_NODEID_GUID(1, UA_Guid_random());
     newentry->session.header.authenticationToken = UA_NODEID_GUID(1, UA_Guid_random());
+    newentry->tokenHash = UA_NodeId_hash(&newentry->session.header.authenticationToken);
+    newentry->idHash = UA_NodeId_hash(&newentry->session.sessionId);
 
     if(request->requestedSessionTimeout <= sm->server->config.maxSessionTimeout &&
        request->requestedSessionTimeout > 0)
@@ -28166,20 +29616,19 @@ UA_SessionManager_createSession(UA_SessionManager *sm, UA_SecureChannel *channel
 
     UA_Session_updateLifetime(&newentry->session);
     LIST_INSERT_HEAD(&sm->sessions, newentry, pointers);
+    indexInsert(sm, false, newentry);
+    indexInsert(sm, true, newentry);
+    scheduleTimeout(sm, newentry->session.validTill, UA_DateTime_nowMonotonic());
     *session = &newentry->session;
     return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
 UA_SessionManager_removeSession(UA_SessionManager *sm, const UA_NodeId *token) {
-    session_list_entry *current;
-    LIST_FOREACH(current, &sm->sessions, pointers) {
-        if(UA_NodeId_equal(&current->session.header.authenticationToken, token))
-            break;
-    }
-    if(!current)
+    session_list_entry **slot = findIndexSlot(sm, false, token);
+    if(!slot)
         return UA_STATUSCODE_BADSESSIONIDINVALID;
-    return removeSession(sm, current);
+    return removeSession(sm, *slot);
 }
 
 /*********************************** amalgamated original file "/home/travis/build/open62541/open62541/src/server/ua_subscription.c" ***********************************/
@@ -28204,6 +29653,114 @@ UA_SessionManager_removeSession(UA_SessionManager *sm, const UA_NodeId *token) {
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS /* conditional compilation */
 
+UA_Double UA_Subscription_batchWindow = 0.0;
+size_t UA_Server_maxPooledNotifications = 16384;
+
+/*************/
+/* BlockPool */
+/*************/
+
+#define BLOCKPOOL_UNPOOLED 0xffffffff
+
+typedef union {
+    struct {
+        UA_UInt32 slot;
+        volatile UA_UInt32 nextFree; /* Index plus one, while in the list */
+    } info;
+    UA_Double align[2]; /* Keep the block aligned like malloc does */
+} BlockHeader;
+
+static BlockHeader *
+BlockPool_header(UA_BlockPool *pool, size_t slot) {
+    return (BlockHeader*)(void*)(pool->slabs[slot / UA_BLOCKPOOL_SLABSIZE] +
+                                 (slot % UA_BLOCKPOOL_SLABSIZE) * pool->blockSize);
+}
+
+void
+UA_BlockPool_init(UA_BlockPool *pool, size_t size, size_t maxBlocks) {
+    memset(pool, 0, sizeof(UA_BlockPool));
+    pool->blockSize = sizeof(BlockHeader) +
+        (size + sizeof(BlockHeader) - 1) / sizeof(BlockHeader) * sizeof(BlockHeader);
+    size_t maxSlabs = (maxBlocks + UA_BLOCKPOOL_SLABSIZE - 1) / UA_BLOCKPOOL_SLABSIZE;
+    if(maxSlabs > UA_FREELIST_MAXSLOTS / UA_BLOCKPOOL_SLABSIZE)
+        maxSlabs = UA_FREELIST_MAXSLOTS / UA_BLOCKPOOL_SLABSIZE;
+    if(maxSlabs == 0)
+        return;
+    pool->slabs = (UA_Byte**)UA_calloc(maxSlabs, sizeof(UA_Byte*));
+    if(pool->slabs)
+        pool->maxSlabs = maxSlabs; /* Else run without the pool */
+}
+
+void
+UA_BlockPool_deleteMembers(UA_BlockPool *pool) {
+    size_t slabsUsed = pool->slabsUsed < pool->maxSlabs ? pool->slabsUsed : pool->maxSlabs;
+    for(size_t i = 0; i < slabsUsed; i++)
+        UA_free(pool->slabs[i]);
+    UA_free(pool->slabs);
+    memset(pool, 0, sizeof(UA_BlockPool));
+}
+
+static volatile UA_UInt32 *
+BlockPool_nextFree(void *pool, size_t slot) {
+    return &BlockPool_header((UA_BlockPool*)pool, slot)->info.nextFree;
+}
+
+/* Take the first block of a new slab and put the others into the free list */
+static BlockHeader *
+BlockPool_addSlab(UA_BlockPool *pool) {
+    size_t slab = UA_atomic_addSize(&pool->slabsUsed, 1) - 1;
+    if(slab >= pool->maxSlabs) {
+        /* Keeps slabsUsed at or above the maximum */
+        UA_atomic_subSize(&pool->slabsUsed, 1);
+        return NULL;
+    }
+    UA_Byte *data = (UA_Byte*)UA_malloc(UA_BLOCKPOOL_SLABSIZE * pool->blockSize);
+    if(!data)
+        return NULL; /* The slab stays empty */
+    pool->slabs[slab] = data;
+
+    size_t firstSlot = slab * UA_BLOCKPOOL_SLABSIZE;
+    for(size_t i = 0; i < UA_BLOCKPOOL_SLABSIZE; i++) {
+        BlockHeader *header = BlockPool_header(pool, firstSlot + i);
+        header->info.slot = (UA_UInt32)(firstSlot + i);
+        header->info.nextFree = (UA_UInt32)(firstSlot + i + 2);
+    }
+    UA_FreeList_push(&pool->freeHead, BlockPool_nextFree, pool,
+                     firstSlot + 1, firstSlot + UA_BLOCKPOOL_SLABSIZE - 1);
+    return BlockPool_header(pool, firstSlot);
+}
+
+void *
+UA_BlockPool_alloc(UA_BlockPool *pool) {
+    BlockHeader *header = NULL;
+    if(pool->maxSlabs > 0) {
+        size_t slot;
+        if(UA_FreeList_pop(&pool->freeHead, BlockPool_nextFree, pool, &slot))
+            header = BlockPool_header(pool, slot);
+        else
+            header = BlockPool_addSlab(pool);
+    }
+    if(!header) {
+        header = (BlockHeader*)UA_malloc(pool->blockSize);
+        if(!header)
+            return NULL;
+        header->info.slot = BLOCKPOOL_UNPOOLED;
+    }
+    return &header[1];
+}
+
+void
+UA_BlockPool_free(UA_BlockPool *pool, void *p) {
+    if(!p)
+        return;
+    BlockHeader *header = &((BlockHeader*)p)[-1];
+    if(header->info.slot == BLOCKPOOL_UNPOOLED)
+        UA_free(header);
+    else
+        UA_FreeList_push(&pool->freeHead, BlockPool_nextFree, pool,
+                         header->info.slot, header->info.slot);
+}
+
 UA_Subscription *
 UA_Subscription_new(UA_Session *session, UA_UInt32 subscriptionId) {
     /* Allocate the memory */
@@ -28243,8 +29800,9 @@ UA_Subscription_deleteMembers(UA_Server *server, UA_Subscription *sub) {
     UA_NotificationMessageEntry *nme, *nme_tmp;
     TAILQ_FOREACH_SAFE(nme, &sub->retransmissionQueue, listEntry, nme_tmp) {
         TAILQ_REMOVE(&sub->retransmissionQueue, nme, listEntry);
+        TAILQ_REMOVE(&sub->session->retransmissionQueue, nme, sessionEntry);
         UA_NotificationMessage_deleteMembers(&nme->message);
-        UA_free(nme);
+        UA_BlockPool_free(&server->retransmissionPool, nme);
         --sub->session->totalRetransmissionQueueSize;
         --sub->retransmissionQueueSize;
     }
@@ -28294,28 +29852,18 @@ UA_Subscription_addMonitoredItem(UA_Subscription *sub, UA_MonitoredItem *newMon)
     LIST_INSERT_HEAD(&sub->monitoredItems, newMon, listEntry);
 }
 
+/* The messages of all Subscriptions of the session are queued in the order of
+ * publication. So the oldest one is the first. */
 static void
-removeOldestRetransmissionMessage(UA_Session *session) {
-    UA_NotificationMessageEntry *oldestEntry = NULL;
-    UA_Subscription *oldestSub = NULL;
-
-    UA_Subscription *sub;
-    LIST_FOREACH(sub, &session->serverSubscriptions, listEntry) {
-        UA_NotificationMessageEntry *first =
-            TAILQ_LAST(&sub->retransmissionQueue, ListOfNotificationMessages);
-        if(!first)
-            continue;
-        if(!oldestEntry || oldestEntry->message.publishTime > first->message.publishTime) {
-            oldestEntry = first;
-            oldestSub = sub;
-        }
-    }
+removeOldestRetransmissionMessage(UA_Server *server, UA_Session *session) {
+    UA_NotificationMessageEntry *oldestEntry = TAILQ_FIRST(&session->retransmissionQueue);
     UA_assert(oldestEntry);
-    UA_assert(oldestSub);
+    UA_Subscription *oldestSub = oldestEntry->sub;
 
     TAILQ_REMOVE(&oldestSub->retransmissionQueue, oldestEntry, listEntry);
+    TAILQ_REMOVE(&session->retransmissionQueue, oldestEntry, sessionEntry);
     UA_NotificationMessage_deleteMembers(&oldestEntry->message);
-    UA_free(oldestEntry);
+    UA_BlockPool_free(&server->retransmissionPool, oldestEntry);
     --session->totalRetransmissionQueueSize;
     --oldestSub->retransmissionQueueSize;
 }
@@ -28328,17 +29876,20 @@ UA_Subscription_addRetransmissionMessage(UA_Server *server, UA_Subscription *sub
        sub->session->totalRetransmissionQueueSize >= server->config.maxRetransmissionQueueSize) {
         UA_LOG_WARNING_SESSION(server->config.logger, sub->session, "Subscription %u | "
                                "Retransmission queue overflow", sub->subscriptionId);
-        removeOldestRetransmissionMessage(sub->session);
+        removeOldestRetransmissionMessage(server, sub->session);
     }
 
     /* Add entry */
+    entry->sub = sub;
     TAILQ_INSERT_TAIL(&sub->retransmissionQueue, entry, listEntry);
+    TAILQ_INSERT_TAIL(&sub->session->retransmissionQueue, entry, sessionEntry);
     ++sub->session->totalRetransmissionQueueSize;
     ++sub->retransmissionQueueSize;
 }
 
 UA_StatusCode
-UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequenceNumber) {
+UA_Subscription_removeRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
+                                            UA_UInt32 sequenceNumber) {
     /* Find the retransmission message */
     UA_NotificationMessageEntry *entry;
     TAILQ_FOREACH(entry, &sub->retransmissionQueue, listEntry) {
@@ -28350,18 +29901,19 @@ UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequ
 
     /* Remove the retransmission message */
     TAILQ_REMOVE(&sub->retransmissionQueue, entry, listEntry);
+    TAILQ_REMOVE(&sub->session->retransmissionQueue, entry, sessionEntry);
     --sub->session->totalRetransmissionQueueSize;
     --sub->retransmissionQueueSize;
     UA_NotificationMessage_deleteMembers(&entry->message);
-    UA_free(entry);
+    UA_BlockPool_free(&server->retransmissionPool, entry);
     return UA_STATUSCODE_GOOD;
 }
 
 /* Iterate over the monitoreditems of the subscription, starting at mon, and
  * move notifications into the response. */
 static void
-moveNotificationsFromMonitoredItems(UA_Subscription *sub, UA_MonitoredItemNotification *mins,
-                                    size_t minsSize) {
+moveNotificationsFromMonitoredItems(UA_Server *server, UA_Subscription *sub,
+                                    UA_MonitoredItemNotification *mins, size_t minsSize) {
     size_t pos = 0;
     UA_Notification *notification, *notification_tmp;
     TAILQ_FOREACH_SAFE(notification, &sub->notificationQueue, globalEntry, notification_tmp) {
@@ -28384,14 +29936,14 @@ moveNotificationsFromMonitoredItems(UA_Subscription *sub, UA_MonitoredItemNotifi
         } else {
             /* TODO implementation for events */
         }
-        UA_free(notification);
+        UA_BlockPool_free(&server->notificationPool, notification);
         ++pos;
     }
 }
 
 static UA_StatusCode
-prepareNotificationMessage(UA_Subscription *sub, UA_NotificationMessage *message,
-                           size_t notifications) {
+prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
+                           UA_NotificationMessage *message, size_t notifications) {
     /* Array of ExtensionObject to hold different kinds of notifications
      * (currently only DataChangeNotifications) */
     message->notificationData = UA_ExtensionObject_new();
@@ -28422,7 +29974,7 @@ prepareNotificationMessage(UA_Subscription *sub, UA_NotificationMessage *message
 
     /* Move notifications into the response .. the point of no return */
 
-    moveNotificationsFromMonitoredItems(sub, dcn->monitoredItems, notifications);
+    moveNotificationsFromMonitoredItems(server, sub, dcn->monitoredItems, notifications);
 
     return UA_STATUSCODE_GOOD;
 }
@@ -28437,8 +29989,44 @@ UA_Subscription_nextSequenceNumber(UA_UInt32 sequenceNumber) {
     return nextSequenceNumber;
 }
 
+/* While notifications keep arriving, the publish callback is repeated when the
+ * batch window after the last notification has passed instead of publishing
+ * right away. Returns whether publishing is deferred. Publishing is deferred
+ * for at most half of the publishing interval, then the callback returns to
+ * the publishing interval. */
+static UA_Boolean
+deferPublish(UA_Server *server, UA_Subscription *sub) {
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    UA_DateTime since = sub->publishDeferredSince ? sub->publishDeferredSince : now;
+    UA_DateTime wait = sub->lastNotificationTime - now +
+        (UA_DateTime)(UA_Subscription_batchWindow * UA_DATETIME_MSEC);
+    UA_DateTime maxWait = since - now +
+        (UA_DateTime)(sub->publishingInterval * UA_DATETIME_MSEC) / 2;
+    if(wait > maxWait)
+        wait = maxWait;
+
+    if(sub->publishingEnabled && sub->notificationQueueSize > 0 &&
+       wait >= 5 * UA_DATETIME_MSEC) {
+        UA_UInt32 interval = (UA_UInt32)((wait + UA_DATETIME_MSEC - 1) / UA_DATETIME_MSEC);
+        if(UA_Server_changeRepeatedCallbackInterval(server, sub->publishCallbackId,
+                                                    interval) == UA_STATUSCODE_GOOD) {
+            sub->publishDeferredSince = since;
+            return true;
+        }
+    }
+
+    if(sub->publishDeferredSince) {
+        UA_Server_changeRepeatedCallbackInterval(server, sub->publishCallbackId,
+                                                 (UA_UInt32)sub->publishingInterval);
+        sub->publishDeferredSince = 0;
+    }
+    return false;
+}
+
 static void
 publishCallback(UA_Server *server, UA_Subscription *sub) {
+    if(UA_Subscription_batchWindow > 0.0 && deferPublish(server, sub))
+        return;
     sub->readyNotifications = sub->notificationQueueSize;
     UA_Subscription_publish(server, sub);
 }
@@ -28512,7 +30100,8 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     UA_NotificationMessageEntry *retransmission = NULL;
     if(notifications > 0) {
         /* Allocate the retransmission entry */
-        retransmission = (UA_NotificationMessageEntry*)UA_malloc(sizeof(UA_NotificationMessageEntry));
+        retransmission = (UA_NotificationMessageEntry*)
+            UA_BlockPool_alloc(&server->retransmissionPool);
         if(!retransmission) {
             UA_LOG_WARNING_SESSION(server->config.logger, sub->session,
                                    "Subscription %u | Could not allocate memory for retransmission. "
@@ -28523,12 +30112,12 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
         }
 
         /* Prepare the response */
-        UA_StatusCode retval = prepareNotificationMessage(sub, message, notifications);
+        UA_StatusCode retval = prepareNotificationMessage(server, sub, message, notifications);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_LOG_WARNING_SESSION(server->config.logger, sub->session,
                                    "Subscription %u | Could not prepare the notification message. "
                                    "The subscription is late.", sub->subscriptionId);
-            UA_free(retransmission);
+            UA_BlockPool_free(&server->retransmissionPool, retransmission);
             sub->state = UA_SUBSCRIPTIONSTATE_LATE;
             UA_Session_queuePublishReq(sub->session, pre, true); /* Re-enqueue */
             return;
@@ -28655,6 +30244,7 @@ Subscription_registerPublishCallback(UA_Server *server, UA_Subscription *sub) {
         return retval;
 
     sub->publishCallbackIsRegistered = true;
+    sub->publishDeferredSince = 0;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -28745,7 +30335,7 @@ MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem) {
             --sub->notificationQueueSize;
 
             UA_DataValue_deleteMembers(&notification->data.value);
-            UA_free(notification);
+            UA_BlockPool_free(&server->notificationPool, notification);
         }
         monitoredItem->queueSize = 0;
     } else {
@@ -28764,7 +30354,7 @@ MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem) {
     UA_Server_delayedFree(server, monitoredItem);
 }
 
-void MonitoredItem_ensureQueueSpace(UA_MonitoredItem *mon) {
+void MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
     if(mon->queueSize <= mon->maxQueueSize)
         return;
 
@@ -28814,7 +30404,7 @@ void MonitoredItem_ensureQueueSpace(UA_MonitoredItem *mon) {
 
         /* Work around a false positive in clang analyzer */
 #ifndef __clang_analyzer__
-        UA_free(del);
+        UA_BlockPool_free(&server->notificationPool, del);
 #endif
     }
 
@@ -28912,10 +30502,9 @@ updateNeededForFilteredValue(const UA_Variant *value, const UA_Variant *oldValue
     return false;
 }
 
-/* Errors are returned as no change detected */
+/* Is the change of a numeric value outside of the deadband? */
 static UA_Boolean
-detectValueChangeWithFilter(UA_MonitoredItem *mon, UA_DataValue *value,
-                            UA_ByteString *encoding) {
+passesDeadbandFilter(const UA_MonitoredItem *mon, const UA_DataValue *value) {
     if (isDataTypeNumeric(value->value.type)
             && (mon->filter.trigger == UA_DATACHANGETRIGGER_STATUSVALUE
                 || mon->filter.trigger == UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP)) {
@@ -28929,61 +30518,92 @@ detectValueChangeWithFilter(UA_MonitoredItem *mon, UA_DataValue *value,
                 return false;
         }*/
     }
+    return true;
+}
+
+/* Encode the part of the value that is relevant for the trigger. The encoding
+ * is compared with the last sample to detect a change. Allocates the encoding
+ * buffer on the heap if the one passed in is too small. */
+static UA_StatusCode
+encodeSampleForTrigger(const UA_DataValue *value, UA_DataChangeTrigger trigger,
+                       UA_ByteString *encoding) {
+    /* Apply Filter */
+    UA_DataValue filtered = *value; /* shallow copy */
+    if(trigger == UA_DATACHANGETRIGGER_STATUS)
+        filtered.hasValue = false;
+    filtered.hasServerTimestamp = false;
+    filtered.hasServerPicoseconds = false;
+    if(trigger < UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP) {
+        filtered.hasSourceTimestamp = false;
+        filtered.hasSourcePicoseconds = false;
+    }
 
     /* Encode the data for comparison */
-    size_t binsize = UA_calcSizeBinary(value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    size_t binsize = UA_calcSizeBinary(&filtered, &UA_TYPES[UA_TYPES_DATAVALUE]);
     if(binsize == 0)
-        return false;
+        return UA_STATUSCODE_BADENCODINGERROR;
 
     /* Allocate buffer on the heap if necessary */
-    if(binsize > UA_VALUENCODING_MAXSTACK &&
-       UA_ByteString_allocBuffer(encoding, binsize) != UA_STATUSCODE_GOOD)
-        return false;
+    if(binsize > UA_VALUENCODING_MAXSTACK) {
+        UA_StatusCode retval = UA_ByteString_allocBuffer(encoding, binsize);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
 
     /* Encode the value */
     UA_Byte *bufPos = encoding->data;
     const UA_Byte *bufEnd = &encoding->data[encoding->length];
-    UA_StatusCode retval = UA_encodeBinary(value, &UA_TYPES[UA_TYPES_DATAVALUE],
+    UA_StatusCode retval = UA_encodeBinary(&filtered, &UA_TYPES[UA_TYPES_DATAVALUE],
                                            &bufPos, &bufEnd, NULL, NULL);
     if(retval != UA_STATUSCODE_GOOD)
-        return false;
-
-    /* The value has changed */
+        return retval;
     encoding->length = (uintptr_t)bufPos - (uintptr_t)encoding->data;
-    return !mon->lastSampledValue.data || !UA_String_equal(encoding, &mon->lastSampledValue);
+    return UA_STATUSCODE_GOOD;
 }
 
 /* Has this sample changed from the last one? The method may allocate additional
- * space for the encoding buffer. Detect the change in encoding->data. */
+ * space for the encoding buffer. Detect the change in encoding->data. Errors
+ * are returned as no change detected. */
 static UA_Boolean
 detectValueChange(UA_MonitoredItem *mon, UA_DataValue *value, UA_ByteString *encoding) {
-    /* Apply Filter */
-    UA_Boolean hasValue = value->hasValue;
-    if(mon->filter.trigger == UA_DATACHANGETRIGGER_STATUS)
-        value->hasValue = false;
+    if(!passesDeadbandFilter(mon, value))
+        return false;
+    if(encodeSampleForTrigger(value, mon->filter.trigger, encoding) != UA_STATUSCODE_GOOD)
+        return false;
+
+    /* The value has changed */
+    return !mon->lastSampledValue.data || !UA_String_equal(encoding, &mon->lastSampledValue);
+}
 
-    UA_Boolean hasServerTimestamp = value->hasServerTimestamp;
-    UA_Boolean hasServerPicoseconds = value->hasServerPicoseconds;
-    value->hasServerTimestamp = false;
-    value->hasServerPicoseconds = false;
+/* Add the notification to the local and global queue. The encoding is kept for
+ * the next comparison. */
+static void
+enqueueSample(UA_Server *server, UA_Subscription *sub,
+              UA_MonitoredItem *monitoredItem,
+              UA_Notification *newNotification,
+              const UA_ByteString *valueEncoding) {
+    UA_LOG_DEBUG_SESSION(server->config.logger, sub->session,
+                         "Subscription %u | MonitoredItem %u | Sampled a new value",
+                         sub->subscriptionId, monitoredItem->monitoredItemId);
 
-    UA_Boolean hasSourceTimestamp = value->hasSourceTimestamp;
-    UA_Boolean hasSourcePicoseconds = value->hasSourcePicoseconds;
-    if(mon->filter.trigger < UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP) {
-        value->hasSourceTimestamp = false;
-        value->hasSourcePicoseconds = false;
-    }
+    newNotification->mon = monitoredItem;
+
+    /* Replace the encoding for comparison */
+    UA_Variant_deleteMembers(&monitoredItem->lastValue);
+    UA_Variant_copy(&newNotification->data.value.value, &monitoredItem->lastValue);
+    UA_ByteString_deleteMembers(&monitoredItem->lastSampledValue);
+    monitoredItem->lastSampledValue = *valueEncoding;
 
-    /* Detect the Value Change */
-    UA_Boolean res = detectValueChangeWithFilter(mon, value, encoding);
+    /* Add the notification to the end of local and global queue */
+    TAILQ_INSERT_TAIL(&monitoredItem->queue, newNotification, listEntry);
+    TAILQ_INSERT_TAIL(&sub->notificationQueue, newNotification, globalEntry);
+    ++monitoredItem->queueSize;
+    ++sub->notificationQueueSize;
+    if(UA_Subscription_batchWindow > 0.0)
+        sub->lastNotificationTime = UA_DateTime_nowMonotonic();
 
-    /* Reset the filter */
-    value->hasValue = hasValue;
-    value->hasServerTimestamp = hasServerTimestamp;
-    value->hasServerPicoseconds = hasServerPicoseconds;
-    value->hasSourceTimestamp = hasSourceTimestamp;
-    value->hasSourcePicoseconds = hasSourcePicoseconds;
-    return res;
+    /* Remove some notifications if the queue is beyond maximum capacity */
+    MonitoredItem_ensureQueueSpace(server, monitoredItem);
 }
 
 /* Returns whether a new sample was created */
@@ -29004,7 +30624,7 @@ sampleCallbackWithValue(UA_Server *server, UA_Subscription *sub,
 
     /* Allocate the entry for the publish queue */
     UA_Notification *newNotification =
-        (UA_Notification *)UA_malloc(sizeof(UA_Notification));
+        (UA_Notification *)UA_BlockPool_alloc(&server->notificationPool);
     if(!newNotification) {
         UA_LOG_WARNING_SESSION(server->config.logger, sub->session,
                                "Subscription %u | MonitoredItem %i | "
@@ -29021,7 +30641,7 @@ sampleCallbackWithValue(UA_Server *server, UA_Subscription *sub,
                                    "Subscription %u | MonitoredItem %i | "
                                    "ByteString to compare values could not be created",
                                    sub->subscriptionId, monitoredItem->monitoredItemId);
-            UA_free(newNotification);
+            UA_BlockPool_free(&server->notificationPool, newNotification);
             return false;
         }
         *valueEncoding = cbs;
@@ -29036,7 +30656,7 @@ sampleCallbackWithValue(UA_Server *server, UA_Subscription *sub,
                                    "Subscription %u | MonitoredItem %i | "
                                    "Item for the publishing queue could not be prepared",
                                    sub->subscriptionId, monitoredItem->monitoredItemId);
-            UA_free(newNotification);
+            UA_BlockPool_free(&server->notificationPool, newNotification);
             return false;
         }
     } else {
@@ -29045,27 +30665,7 @@ sampleCallbackWithValue(UA_Server *server, UA_Subscription *sub,
 
     /* <-- Point of no return --> */
 
-    UA_LOG_DEBUG_SESSION(server->config.logger, sub->session,
-                         "Subscription %u | MonitoredItem %u | Sampled a new value",
-                         sub->subscriptionId, monitoredItem->monitoredItemId);
-
-    newNotification->mon = monitoredItem;
-
-    /* Replace the encoding for comparison */
-    UA_Variant_deleteMembers(&monitoredItem->lastValue);
-    UA_Variant_copy(&value->value, &monitoredItem->lastValue);
-    UA_ByteString_deleteMembers(&monitoredItem->lastSampledValue);
-    monitoredItem->lastSampledValue = *valueEncoding;
-
-    /* Add the notification to the end of local and global queue */
-    TAILQ_INSERT_TAIL(&monitoredItem->queue, newNotification, listEntry);
-    TAILQ_INSERT_TAIL(&sub->notificationQueue, newNotification, globalEntry);
-    ++monitoredItem->queueSize;
-    ++sub->notificationQueueSize;
-
-    /* Remove some notifications if the queue is beyond maximum capacity */
-    MonitoredItem_ensureQueueSpace(monitoredItem);
-
+    enqueueSample(server, sub, monitoredItem, newNotification, valueEncoding);
     return true;
 }
 
@@ -29111,13 +30711,312 @@ UA_MonitoredItem_SampleCallback(UA_Server *server,
     }
 }
 
+/****************/
+/* Sample Group */
+/****************/
+
+/* Defined with the Read service */
+static UA_Byte
+getUserAccessLevel(UA_Server *server, const UA_Session *session,
+                   const UA_VariableNode *node);
+
+/* Only the value attribute of ChangeNotify items is sampled in groups. The
+ * other attributes depend on the access rights of the session. */
+static UA_Boolean
+isSampledInGroup(const UA_MonitoredItem *mon) {
+    return mon->monitoredItemType == UA_MONITOREDITEMTYPE_CHANGENOTIFY &&
+        mon->attributeId == UA_ATTRIBUTEID_VALUE;
+}
+
+/* Groups of the same node are in the same bucket of the hash map */
+static UA_UInt32
+sampleGroupHash(const UA_MonitoredItem *mon) {
+    return UA_NodeId_hash(&mon->monitoredNodeId);
+}
+
+static UA_Boolean
+sampleGroupMatches(const UA_SampleGroup *group, UA_UInt32 hash,
+                   const UA_MonitoredItem *mon) {
+    return group->hash == hash &&
+        group->samplingInterval == mon->samplingInterval &&
+        group->timestampsToReturn == mon->timestampsToReturn &&
+        UA_NodeId_equal(&group->nodeId, &mon->monitoredNodeId) &&
+        UA_String_equal(&group->indexRange, &mon->indexRange);
+}
+
+static UA_StatusCode
+resizeSampleGroups(UA_Server *server, size_t size) {
+    UA_SampleGroup **buckets =
+        (UA_SampleGroup**)UA_calloc(size, sizeof(UA_SampleGroup*));
+    if(!buckets)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < server->sampleGroupsSize; ++i) {
+        UA_SampleGroup *group = server->sampleGroups[i];
+        while(group) {
+            UA_SampleGroup *next = group->next;
+            UA_SampleGroup **bucket = &buckets[group->hash & (size - 1)];
+            group->next = *bucket;
+            *bucket = group;
+            group = next;
+        }
+    }
+    UA_free(server->sampleGroups);
+    server->sampleGroups = buckets;
+    server->sampleGroupsSize = size;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Can the session read the value with its own access rights? The shared sample
+ * is read with the session of the first member. */
+static UA_Boolean
+sessionMayReadValue(UA_Server *server, const UA_Session *session,
+                    const UA_Node *node) {
+    if(!node || node->nodeClass != UA_NODECLASS_VARIABLE)
+        return true; /* The read result does not depend on the session */
+    return (getUserAccessLevel(server, session, (const UA_VariableNode*)node) &
+            UA_ACCESSLEVELMASK_READ) != 0;
+}
+
+/* Hand a copy of the shared sample to the MonitoredItem */
+static void
+sampleGroupNotify(UA_Server *server, UA_MonitoredItem *mon,
+                  const UA_DataValue *value, const UA_ByteString *valueEncoding) {
+    UA_Subscription *sub = mon->subscription;
+    UA_Notification *newNotification =
+        (UA_Notification *)UA_BlockPool_alloc(&server->notificationPool);
+    if(!newNotification) {
+        UA_LOG_WARNING_SESSION(server->config.logger, sub->session,
+                               "Subscription %u | MonitoredItem %i | "
+                               "Item for the publishing queue could not be allocated",
+                               sub->subscriptionId, mon->monitoredItemId);
+        return;
+    }
+
+    UA_ByteString cbs;
+    if(UA_ByteString_copy(valueEncoding, &cbs) != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_SESSION(server->config.logger, sub->session,
+                               "Subscription %u | MonitoredItem %i | "
+                               "ByteString to compare values could not be created",
+                               sub->subscriptionId, mon->monitoredItemId);
+        UA_BlockPool_free(&server->notificationPool, newNotification);
+        return;
+    }
+
+    if(UA_DataValue_copy(value, &newNotification->data.value) != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_SESSION(server->config.logger, sub->session,
+                               "Subscription %u | MonitoredItem %i | "
+                               "Item for the publishing queue could not be prepared",
+                               sub->subscriptionId, mon->monitoredItemId);
+        UA_ByteString_deleteMembers(&cbs);
+        UA_BlockPool_free(&server->notificationPool, newNotification);
+        return;
+    }
+
+    enqueueSample(server, sub, mon, newNotification, &cbs);
+}
+
+static void
+UA_SampleGroup_sampleCallback(UA_Server *server, UA_SampleGroup *group) {
+    /* The last member was removed. The callback is removed with the next
+     * processing of the timer. */
+    UA_MonitoredItem *first = LIST_FIRST(&group->members);
+    if(!first)
+        return;
+
+    /* Read the value once */
+    UA_Session *session = first->subscription->session;
+    UA_ReadValueId rvid;
+    UA_ReadValueId_init(&rvid);
+    rvid.nodeId = group->nodeId;
+    rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+    rvid.indexRange = group->indexRange;
+    UA_DataValue value =
+        UA_Server_readWithSession(server, session, &rvid, group->timestampsToReturn);
+
+    /* The session of the first member was denied access. Every member reads
+     * with its own rights. */
+    UA_Boolean shared = (value.status != UA_STATUSCODE_BADUSERACCESSDENIED);
+
+    /* The encoding depends on the trigger of the members. Encode at most once
+     * per trigger and only when needed. */
+    UA_STACKARRAY(UA_Byte, stackValueEncoding, 3 * UA_VALUENCODING_MAXSTACK);
+    UA_ByteString valueEncoding[3];
+    UA_StatusCode encodingStatus[3];
+    UA_Boolean encoded[3] = {false, false, false};
+
+    /* Members of other sessions check their access rights on the node */
+    const UA_Node *node = NULL;
+    UA_Boolean nodeLoaded = false;
+
+    UA_MonitoredItem *mon;
+    LIST_FOREACH(mon, &group->members, sampleGroupEntry) {
+        if(!shared) {
+            UA_MonitoredItem_SampleCallback(server, mon);
+            continue;
+        }
+        if(mon->subscription->session != session) {
+            if(!nodeLoaded) {
+                node = UA_Nodestore_get(server, &group->nodeId);
+                nodeLoaded = true;
+            }
+            if(!sessionMayReadValue(server, mon->subscription->session, node)) {
+                UA_MonitoredItem_SampleCallback(server, mon);
+                continue;
+            }
+        }
+
+        if(!passesDeadbandFilter(mon, &value))
+            continue;
+
+        size_t t = UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP;
+        if(mon->filter.trigger < UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP)
+            t = (size_t)mon->filter.trigger;
+        if(!encoded[t]) {
+            valueEncoding[t].data = &stackValueEncoding[t * UA_VALUENCODING_MAXSTACK];
+            valueEncoding[t].length = UA_VALUENCODING_MAXSTACK;
+            encodingStatus[t] = encodeSampleForTrigger(&value, (UA_DataChangeTrigger)t,
+                                                       &valueEncoding[t]);
+            encoded[t] = true;
+        }
+        if(encodingStatus[t] != UA_STATUSCODE_GOOD)
+            continue;
+
+        /* Has the value changed? */
+        if(mon->lastSampledValue.data &&
+           UA_String_equal(&valueEncoding[t], &mon->lastSampledValue))
+            continue;
+
+        sampleGroupNotify(server, mon, &value, &valueEncoding[t]);
+    }
+
+    /* Clean up */
+    if(node)
+        UA_Nodestore_release(server, node);
+    for(size_t t = 0; t < 3; ++t) {
+        if(encoded[t] && valueEncoding[t].data != &stackValueEncoding[t * UA_VALUENCODING_MAXSTACK])
+            UA_ByteString_deleteMembers(&valueEncoding[t]);
+    }
+    UA_DataValue_deleteMembers(&value);
+}
+
+static UA_StatusCode
+UA_SampleGroup_addMember(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_Subscription *sub = mon->subscription;
+    UA_UInt32 hash = sampleGroupHash(mon);
+    UA_SampleGroup *group = NULL;
+    if(server->sampleGroupsSize > 0) {
+        group = server->sampleGroups[hash & (server->sampleGroupsSize - 1)];
+        while(group && !sampleGroupMatches(group, hash, mon))
+            group = group->next;
+    }
+
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(!group) {
+        /* Grow the hash map */
+        if(server->sampleGroupsCount >= server->sampleGroupsSize) {
+            retval = resizeSampleGroups(server, server->sampleGroupsSize > 0 ?
+                                        server->sampleGroupsSize * 2 : 64);
+            if(retval != UA_STATUSCODE_GOOD)
+                return retval;
+        }
+
+        /* Create the group */
+        group = (UA_SampleGroup*)UA_calloc(1, sizeof(UA_SampleGroup));
+        if(!group)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        group->hash = hash;
+        group->timestampsToReturn = mon->timestampsToReturn;
+        group->samplingInterval = mon->samplingInterval;
+        retval |= UA_NodeId_copy(&mon->monitoredNodeId, &group->nodeId);
+        retval |= UA_String_copy(&mon->indexRange, &group->indexRange);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = UA_Server_addRepeatedCallback(server,
+                                                   (UA_ServerCallback)UA_SampleGroup_sampleCallback,
+                                                   group, (UA_UInt32)group->samplingInterval,
+                                                   &group->sampleCallbackId);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_NodeId_deleteMembers(&group->nodeId);
+            UA_String_deleteMembers(&group->indexRange);
+            UA_free(group);
+            return retval;
+        }
+
+        UA_SampleGroup **bucket = &server->sampleGroups[hash & (server->sampleGroupsSize - 1)];
+        group->next = *bucket;
+        *bucket = group;
+        ++server->sampleGroupsCount;
+    } else if(sub->publishCallbackIsRegistered &&
+              group->sampleCallbackId < sub->publishCallbackId) {
+        /* Callbacks due at the same time run in the reverse order of their
+         * registration. Register the sample callback anew, so the sample is
+         * taken before the Subscription of the new member publishes. */
+        UA_UInt64 callbackId;
+        retval = UA_Server_addRepeatedCallback(server,
+                                               (UA_ServerCallback)UA_SampleGroup_sampleCallback,
+                                               group, (UA_UInt32)group->samplingInterval,
+                                               &callbackId);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        UA_Server_removeRepeatedCallback(server, group->sampleCallbackId);
+        group->sampleCallbackId = callbackId;
+    }
+
+    LIST_INSERT_HEAD(&group->members, mon, sampleGroupEntry);
+    mon->sampleGroup = group;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_SampleGroup_removeMember(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_SampleGroup *group = mon->sampleGroup;
+    LIST_REMOVE(mon, sampleGroupEntry);
+    mon->sampleGroup = NULL;
+    if(!LIST_EMPTY(&group->members))
+        return UA_STATUSCODE_GOOD;
+
+    /* Remove the empty group from the hash map */
+    UA_SampleGroup **pos = &server->sampleGroups[group->hash & (server->sampleGroupsSize - 1)];
+    while(*pos != group)
+        pos = &(*pos)->next;
+    *pos = group->next;
+    --server->sampleGroupsCount;
+    if(server->sampleGroupsCount == 0) {
+        UA_free(server->sampleGroups);
+        server->sampleGroups = NULL;
+        server->sampleGroupsSize = 0;
+    }
+
+    /* The callback might still be dispatched before the removal is processed.
+     * It finds no members then. */
+    UA_StatusCode retval = UA_Server_removeRepeatedCallback(server, group->sampleCallbackId);
+    UA_NodeId_deleteMembers(&group->nodeId);
+    UA_String_deleteMembers(&group->indexRange);
+    UA_Server_delayedFree(server, group);
+    return retval;
+}
+
+void
+UA_Server_notifyValueChange(UA_Server *server, const UA_NodeId nodeId) {
+    if(server->sampleGroupsSize == 0)
+        return;
+    UA_UInt32 hash = UA_NodeId_hash(&nodeId);
+    UA_SampleGroup *group = server->sampleGroups[hash & (server->sampleGroupsSize - 1)];
+    for(; group; group = group->next) {
+        if(group->hash == hash && UA_NodeId_equal(&group->nodeId, &nodeId))
+            UA_SampleGroup_sampleCallback(server, group);
+    }
+}
+
 UA_StatusCode
 MonitoredItem_registerSampleCallback(UA_Server *server, UA_MonitoredItem *mon) {
     if(mon->sampleCallbackIsRegistered)
         return UA_STATUSCODE_GOOD;
-    UA_StatusCode retval =
-        UA_Server_addRepeatedCallback(server, (UA_ServerCallback)UA_MonitoredItem_SampleCallback,
-                                      mon, (UA_UInt32)mon->samplingInterval, &mon->sampleCallbackId);
+    UA_StatusCode retval;
+    if(isSampledInGroup(mon))
+        retval = UA_SampleGroup_addMember(server, mon);
+    else
+        retval = UA_Server_addRepeatedCallback(server, (UA_ServerCallback)UA_MonitoredItem_SampleCallback,
+                                               mon, (UA_UInt32)mon->samplingInterval, &mon->sampleCallbackId);
     if(retval == UA_STATUSCODE_GOOD)
         mon->sampleCallbackIsRegistered = true;
     return retval;
@@ -29128,6 +31027,8 @@ MonitoredItem_unregisterSampleCallback(UA_Server *server, UA_MonitoredItem *mon)
     if(!mon->sampleCallbackIsRegistered)
         return UA_STATUSCODE_GOOD;
     mon->sampleCallbackIsRegistered = false;
+    if(mon->sampleGroup)
+        return UA_SampleGroup_removeMember(server, mon);
     return UA_Server_removeRepeatedCallback(server, mon->sampleCallbackId);
 }
 
@@ -29203,9 +31104,259 @@ relevantReference(UA_Server *server, UA_Boolean includeSubtypes,
     return isNodeInTree(&server->config.nodestore, testRef, rootRef, &hasSubType, 1);
 }
 
-/* Returns whether the node / continuationpoint is done */
+/****************/
+/* Browse Cache */
+/****************/
+
+size_t UA_Server_browseCacheSize = 65536;
+
+void
+UA_BrowseCache_init(UA_BrowseCache *cache, size_t maxReferences) {
+    memset(cache, 0, sizeof(UA_BrowseCache));
+    cache->maxReferences = maxReferences;
+    TAILQ_INIT(&cache->lru);
+}
+
+static void
+browseCacheKind_clear(UA_BrowseCache *cache, UA_BrowseCacheKind *kind) {
+    if(!kind->targets)
+        return;
+    UA_Array_delete(kind->targets, kind->targetsSize,
+                    &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+    cache->referencesCount -= kind->targetsSize;
+    kind->targets = NULL;
+    kind->targetsSize = 0;
+}
+
+static void
+browseCacheEntry_clear(UA_BrowseCache *cache, UA_BrowseCacheEntry *entry) {
+    for(size_t i = 0; i < entry->kindsSize; ++i) {
+        browseCacheKind_clear(cache, &entry->kinds[i]);
+        UA_NodeId_deleteMembers(&entry->kinds[i].referenceTypeId);
+    }
+    UA_free(entry->kinds);
+    entry->kinds = NULL;
+    entry->kindsSize = 0;
+}
+
+static void
+browseCacheEntry_delete(UA_BrowseCache *cache, UA_BrowseCacheEntry *entry) {
+    UA_BrowseCacheEntry **pos = &cache->buckets[entry->hash & (cache->bucketsSize - 1)];
+    while(*pos != entry)
+        pos = &(*pos)->next;
+    *pos = entry->next;
+    TAILQ_REMOVE(&cache->lru, entry, lruEntry);
+    --cache->entriesCount;
+    browseCacheEntry_clear(cache, entry);
+    UA_NodeId_deleteMembers(&entry->nodeId);
+    UA_free(entry);
+}
+
+void
+UA_BrowseCache_deleteMembers(UA_BrowseCache *cache) {
+    UA_BrowseCacheEntry *entry;
+    while((entry = TAILQ_FIRST(&cache->lru)))
+        browseCacheEntry_delete(cache, entry);
+    UA_free(cache->buckets);
+    memset(cache, 0, sizeof(UA_BrowseCache));
+}
+
+void
+UA_BrowseCache_invalidate(UA_Server *server) {
+    UA_atomic_addSize(&server->browseCacheEpoch, 1);
+}
+
+static UA_StatusCode
+resizeBrowseCache(UA_BrowseCache *cache, size_t size) {
+    UA_BrowseCacheEntry **buckets =
+        (UA_BrowseCacheEntry**)UA_calloc(size, sizeof(UA_BrowseCacheEntry*));
+    if(!buckets)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < cache->bucketsSize; ++i) {
+        UA_BrowseCacheEntry *entry = cache->buckets[i];
+        while(entry) {
+            UA_BrowseCacheEntry *next = entry->next;
+            UA_BrowseCacheEntry **bucket = &buckets[entry->hash & (size - 1)];
+            entry->next = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+    UA_free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucketsSize = size;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Set up the kinds of the entry for the references of the node */
+static UA_StatusCode
+browseCacheEntry_setKinds(UA_BrowseCache *cache, UA_BrowseCacheEntry *entry,
+                          const UA_Node *node) {
+    browseCacheEntry_clear(cache, entry);
+    if(node->referencesSize == 0)
+        return UA_STATUSCODE_GOOD;
+    entry->kinds = (UA_BrowseCacheKind*)
+        UA_calloc(node->referencesSize, sizeof(UA_BrowseCacheKind));
+    if(!entry->kinds)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < node->referencesSize; ++i) {
+        entry->kinds[i].isInverse = node->references[i].isInverse;
+        retval |= UA_NodeId_copy(&node->references[i].referenceTypeId,
+                                 &entry->kinds[i].referenceTypeId);
+    }
+    entry->kindsSize = node->referencesSize;
+    if(retval != UA_STATUSCODE_GOOD)
+        browseCacheEntry_clear(cache, entry);
+    return retval;
+}
+
+/* Returns the entry for the node, outdated kinds are cleared. Returns NULL if
+ * there is no memory for the entry. */
+static UA_BrowseCacheEntry *
+browseCacheGet(UA_Server *server, UA_BrowseCache *cache, const UA_Node *node) {
+    UA_UInt32 hash = UA_NodeId_hash(&node->nodeId);
+    UA_BrowseCacheEntry *entry = NULL;
+    if(cache->bucketsSize > 0) {
+        entry = cache->buckets[hash & (cache->bucketsSize - 1)];
+        for(; entry; entry = entry->next) {
+            if(entry->hash == hash && UA_NodeId_equal(&entry->nodeId, &node->nodeId))
+                break;
+        }
+    }
+
+    /* Add a new entry */
+    if(!entry) {
+        if(cache->entriesCount >= cache->bucketsSize &&
+           resizeBrowseCache(cache, cache->bucketsSize > 0 ?
+                             cache->bucketsSize * 2 : 64) != UA_STATUSCODE_GOOD)
+            return NULL;
+        entry = (UA_BrowseCacheEntry*)UA_calloc(1, sizeof(UA_BrowseCacheEntry));
+        if(!entry)
+            return NULL;
+        if(UA_NodeId_copy(&node->nodeId, &entry->nodeId) != UA_STATUSCODE_GOOD) {
+            UA_free(entry);
+            return NULL;
+        }
+        entry->hash = hash;
+        entry->epoch = UA_atomic_loadSize(&server->browseCacheEpoch);
+        UA_BrowseCacheEntry **bucket = &cache->buckets[hash & (cache->bucketsSize - 1)];
+        entry->next = *bucket;
+        *bucket = entry;
+        TAILQ_INSERT_HEAD(&cache->lru, entry, lruEntry);
+        ++cache->entriesCount;
+    } else {
+        TAILQ_REMOVE(&cache->lru, entry, lruEntry);
+        TAILQ_INSERT_HEAD(&cache->lru, entry, lruEntry);
+    }
+
+    /* Start over if the attributes of nodes have changed or reference kinds
+     * were added or removed */
+    size_t epoch = UA_atomic_loadSize(&server->browseCacheEpoch);
+    UA_Boolean valid = (entry->epoch == epoch && entry->kindsSize == node->referencesSize);
+    for(size_t i = 0; valid && i < entry->kindsSize; ++i) {
+        valid = entry->kinds[i].isInverse == node->references[i].isInverse &&
+            UA_NodeId_equal(&entry->kinds[i].referenceTypeId,
+                            &node->references[i].referenceTypeId);
+    }
+    if(!valid) {
+        entry->epoch = epoch;
+        if(browseCacheEntry_setKinds(cache, entry, node) != UA_STATUSCODE_GOOD) {
+            browseCacheEntry_delete(cache, entry);
+            return NULL;
+        }
+    }
+    return entry;
+}
+
+/* Evict the least recently used entries other than the current one until the
+ * number of descriptions fits */
+static void
+browseCacheEvict(UA_BrowseCache *cache, const UA_BrowseCacheEntry *current,
+                 size_t required) {
+    UA_BrowseCacheEntry *entry = TAILQ_LAST(&cache->lru, UA_BrowseCacheLru);
+    while(entry && cache->referencesCount + required > cache->maxReferences) {
+        UA_BrowseCacheEntry *prev = TAILQ_PREV(entry, UA_BrowseCacheLru, lruEntry);
+        if(entry != current)
+            browseCacheEntry_delete(cache, entry);
+        entry = prev;
+    }
+}
+
+/* Returns the descriptions of the targets of the kind, or NULL if they are not
+ * cached. Then the targets are taken from the nodestore. */
+static const UA_ReferenceDescription *
+browseCacheTargets(UA_Server *server, UA_BrowseCache *cache, UA_BrowseCacheEntry *entry,
+                   const UA_NodeReferenceKind *rk, size_t referenceKindIndex) {
+    UA_BrowseCacheKind *kind = &entry->kinds[referenceKindIndex];
+
+    /* Are the descriptions for the current targets? */
+    if(kind->targets) {
+        UA_Boolean valid = (kind->targetsSize == rk->targetIdsSize);
+        for(size_t i = 0; valid && i < rk->targetIdsSize; ++i)
+            valid = UA_NodeId_equal(&kind->targets[i].nodeId.nodeId,
+                                    &rk->targetIds[i].nodeId);
+        if(valid)
+            return kind->targets;
+        browseCacheKind_clear(cache, kind);
+    }
+
+    /* Make space and describe all targets of the kind */
+    browseCacheEvict(cache, entry, rk->targetIdsSize);
+    if(cache->referencesCount + rk->targetIdsSize > cache->maxReferences)
+        return NULL;
+    UA_ReferenceDescription *targets = (UA_ReferenceDescription*)
+        UA_Array_new(rk->targetIdsSize, &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+    if(!targets)
+        return NULL;
+    for(size_t i = 0; i < rk->targetIdsSize; ++i) {
+        /* Unknown targets are skipped by the browse. Do not cache them, they
+         * may be added later. */
+        const UA_Node *target = UA_Nodestore_get(server, &rk->targetIds[i].nodeId);
+        UA_StatusCode retval = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        if(target) {
+            retval = fillReferenceDescription(server, target, rk, UA_BROWSERESULTMASK_ALL,
+                                              &targets[i]);
+            UA_Nodestore_release(server, target);
+        }
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_Array_delete(targets, rk->targetIdsSize,
+                            &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+            return NULL;
+        }
+    }
+
+    kind->targets = targets;
+    kind->targetsSize = rk->targetIdsSize;
+    cache->referencesCount += rk->targetIdsSize;
+    return targets;
+}
+
+/* Copy the fields of the result mask from the cached description */
+static UA_StatusCode
+copyReferenceDescription(const UA_ReferenceDescription *src, UA_UInt32 mask,
+                         UA_ReferenceDescription *descr) {
+    UA_ReferenceDescription_init(descr);
+    UA_StatusCode retval = UA_NodeId_copy(&src->nodeId.nodeId, &descr->nodeId.nodeId);
+    if(mask & UA_BROWSERESULTMASK_REFERENCETYPEID)
+        retval |= UA_NodeId_copy(&src->referenceTypeId, &descr->referenceTypeId);
+    if(mask & UA_BROWSERESULTMASK_ISFORWARD)
+        descr->isForward = src->isForward;
+    if(mask & UA_BROWSERESULTMASK_NODECLASS)
+        descr->nodeClass = src->nodeClass;
+    if(mask & UA_BROWSERESULTMASK_BROWSENAME)
+        retval |= UA_QualifiedName_copy(&src->browseName, &descr->browseName);
+    if(mask & UA_BROWSERESULTMASK_DISPLAYNAME)
+        retval |= UA_LocalizedText_copy(&src->displayName, &descr->displayName);
+    if(mask & UA_BROWSERESULTMASK_TYPEDEFINITION)
+        retval |= UA_NodeId_copy(&src->typeDefinition.nodeId, &descr->typeDefinition.nodeId);
+    return retval;
+}
+
+/* Returns whether the node / continuationpoint is done. The cache is
+ * optional. */
 static UA_Boolean
-browseReferences(UA_Server *server, const UA_Node *node,
+browseReferences(UA_Server *server, const UA_Node *node, UA_BrowseCache *cache,
                  ContinuationPointEntry *cp, UA_BrowseResult *result) {
     UA_assert(cp != NULL);
     const UA_BrowseDescription *descr = &cp->browseDescription;
@@ -29245,6 +31396,10 @@ browseReferences(UA_Server *server, const UA_Node *node,
     size_t referenceKindIndex = cp->referenceKindIndex;
     size_t targetIndex = cp->targetIndex;
 
+    UA_BrowseCacheEntry *entry = NULL;
+    if(cache)
+        entry = browseCacheGet(server, cache, node);
+
     /* Loop over the node's references */
     for(; referenceKindIndex < node->referencesSize; ++referenceKindIndex) {
         UA_NodeReferenceKind *rk = &node->references[referenceKindIndex];
@@ -29260,16 +31415,29 @@ browseReferences(UA_Server *server, const UA_Node *node,
                                             &descr->referenceTypeId, &rk->referenceTypeId))
             continue;
 
+        /* Take the descriptions of the targets from the cache */
+        const UA_ReferenceDescription *cached = NULL;
+        if(entry)
+            cached = browseCacheTargets(server, cache, entry, rk, referenceKindIndex);
+
         /* Loop over the targets */
         for(; targetIndex < rk->targetIdsSize; ++targetIndex) {
             /* Get the node */
-            const UA_Node *target = UA_Nodestore_get(server, &rk->targetIds[targetIndex].nodeId);
-            if(!target)
-                continue;
+            const UA_Node *target = NULL;
+            UA_NodeClass nodeClass;
+            if(cached) {
+                nodeClass = cached[targetIndex].nodeClass;
+            } else {
+                target = UA_Nodestore_get(server, &rk->targetIds[targetIndex].nodeId);
+                if(!target)
+                    continue;
+                nodeClass = target->nodeClass;
+            }
 
             /* Test if the node class matches */
-            if(descr->nodeClassMask != 0 && (target->nodeClass & descr->nodeClassMask) == 0) {
-                UA_Nodestore_release(server, target);
+            if(descr->nodeClassMask != 0 && (nodeClass & descr->nodeClassMask) == 0) {
+                if(target)
+                    UA_Nodestore_release(server, target);
                 continue;
             }
 
@@ -29278,7 +31446,8 @@ browseReferences(UA_Server *server, const UA_Node *node,
                 /* There are references we could not return */
                 cp->referenceKindIndex = referenceKindIndex;
                 cp->targetIndex = targetIndex;
-                UA_Nodestore_release(server, target);
+                if(target)
+                    UA_Nodestore_release(server, target);
                 return false;
             }
 
@@ -29291,18 +31460,24 @@ browseReferences(UA_Server *server, const UA_Node *node,
                     UA_realloc(result->references, sizeof(UA_ReferenceDescription) * refs_size);
                 if(!rd) {
                     result->statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
-                    UA_Nodestore_release(server, target);
+                    if(target)
+                        UA_Nodestore_release(server, target);
                     goto error_recovery;
                 }
                 result->references = rd;
             }
 
             /* Copy the node description. Target is on top of the stack */
-            result->statusCode =
-                fillReferenceDescription(server, target, rk, descr->resultMask,
-                                         &result->references[result->referencesSize]);
-
-            UA_Nodestore_release(server, target);
+            if(cached) {
+                result->statusCode =
+                    copyReferenceDescription(&cached[targetIndex], descr->resultMask,
+                                             &result->references[result->referencesSize]);
+            } else {
+                result->statusCode =
+                    fillReferenceDescription(server, target, rk, descr->resultMask,
+                                             &result->references[result->referencesSize]);
+                UA_Nodestore_release(server, target);
+            }
 
             if(result->statusCode != UA_STATUSCODE_GOOD)
                 goto error_recovery;
@@ -29374,8 +31549,13 @@ browseWithContinuation(UA_Server *server, UA_Session *session,
         return true;
     }
 
-    /* Browse the references */
-    UA_Boolean done = browseReferences(server, node, cp, result);
+    /* Browse the references. Take the cache unless another browse is using
+     * it. */
+    UA_BrowseCache *cache = (UA_BrowseCache*)
+        UA_atomic_xchg((void * volatile *)&server->browseCache, NULL);
+    UA_Boolean done = browseReferences(server, node, cache, cp, result);
+    if(cache)
+        UA_atomic_storePtr((void * volatile *)&server->browseCache, cache);
     UA_Nodestore_release(server, node);
     return done;
 }
@@ -29390,6 +31570,10 @@ Operation_Browse(UA_Server *server, UA_Session *session, UA_UInt32 *maxrefs,
     cp->maxReferences = *maxrefs;
     cp->browseDescription = *descr; /* Shallow copy. Deep-copy later if we persist the cp. */
 
+    if(server->config.nodestore.notifyBrowse)
+        server->config.nodestore.notifyBrowse(server->config.nodestore.context,
+                                              &descr->nodeId);
+
     UA_Boolean done = browseWithContinuation(server, session, cp, result);
 
     /* Exit early if done or an error occurred */
@@ -31693,12 +33877,14 @@ copyAttributeIntoNode(UA_Server *server, UA_Session *session,
         CHECK_DATATYPE_SCALAR(QUALIFIEDNAME);
         UA_QualifiedName_deleteMembers(&node->browseName);
         UA_QualifiedName_copy((const UA_QualifiedName *)value, &node->browseName);
+        UA_BrowseCache_invalidate(server);
         break;
     case UA_ATTRIBUTEID_DISPLAYNAME:
         CHECK_USERWRITEMASK(UA_WRITEMASK_DISPLAYNAME);
         CHECK_DATATYPE_SCALAR(LOCALIZEDTEXT);
         UA_LocalizedText_deleteMembers(&node->displayName);
         UA_LocalizedText_copy((const UA_LocalizedText *)value, &node->displayName);
+        UA_BrowseCache_invalidate(server);
         break;
     case UA_ATTRIBUTEID_DESCRIPTION:
         CHECK_USERWRITEMASK(UA_WRITEMASK_DESCRIPTION);
@@ -33041,7 +35227,7 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
     result->revisedQueueSize = mon->maxQueueSize;
 
     /* Remove some notifications if the queue is now too small */
-    MonitoredItem_ensureQueueSpace(mon);
+    MonitoredItem_ensureQueueSpace(server, mon);
 }
 
 void
@@ -33122,7 +35308,7 @@ Operation_SetMonitoringMode(UA_Server *server, UA_Session *session,
             --smc->sub->notificationQueueSize;
 
             UA_DataValue_deleteMembers(&notification->data.value);
-            UA_free(notification);
+            UA_BlockPool_free(&server->notificationPool, notification);
         }
         mon->queueSize = 0;
 
@@ -33243,7 +35429,8 @@ Service_Publish(UA_Server *server, UA_Session *session,
             continue;
         }
         /* Remove the acked transmission from the retransmission queue */
-        response->results[i] = UA_Subscription_removeRetransmissionMessage(sub, ack->sequenceNumber);
+        response->results[i] = UA_Subscription_removeRetransmissionMessage(server, sub,
+                                                                            ack->sequenceNumber);
     }
 
     /* Queue the publish response. It will be dequeued in a repeated publish
@@ -33860,6 +36047,8 @@ static void deleteReferencesSubset(UA_Node *node, size_t referencesSkipSize, UA_
             UA_NodeReferenceKind *srefs = &node->references[i];
             UA_NodeReferenceKind *drefs = &newReferences[curr++];
             drefs->isInverse = srefs->isInverse;
+            drefs->targetIdsIndex = NULL;
+            drefs->targetIdsIndexSize = 0;
             retval = UA_NodeId_copy(&srefs->referenceTypeId, &drefs->referenceTypeId);
             if(retval != UA_STATUSCODE_GOOD)
                 break;
@@ -34713,6 +36902,7 @@ removeDeconstructedNode(UA_Server *server, UA_Session *session,
 
     /* Remove the node in the nodestore */
     UA_Nodestore_remove(server, &node->nodeId);
+    UA_BrowseCache_invalidate(server);
 }
 
 static void
@@ -34782,15 +36972,26 @@ UA_Server_deleteNode(UA_Server *server, const UA_NodeId nodeId,
 /* Add References */
 /******************/
 
+/* The type definition is part of the browse results for the node */
+static void
+invalidateTypeDefinition(UA_Server *server, const UA_NodeId *referenceTypeId) {
+    if(referenceTypeId->namespaceIndex == 0 &&
+       referenceTypeId->identifierType == UA_NODEIDTYPE_NUMERIC &&
+       referenceTypeId->identifier.numeric == UA_NS0ID_HASTYPEDEFINITION)
+        UA_BrowseCache_invalidate(server);
+}
+
 static UA_StatusCode
 addOneWayReference(UA_Server *server, UA_Session *session,
              UA_Node *node, const UA_AddReferencesItem *item) {
+    invalidateTypeDefinition(server, &item->referenceTypeId);
     return UA_Node_addReference(node, item);
 }
 
 static UA_StatusCode
 deleteOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
                       const UA_DeleteReferencesItem *item) {
+    invalidateTypeDefinition(server, &item->referenceTypeId);
     return UA_Node_deleteReference(node, item);
 }
 
@@ -39093,6 +41294,7 @@ static inline int gethostname_freertos(char* name, size_t len){
 #  include <netinet/in.h>
 #  include <netdb.h>
 #  include <sys/ioctl.h>
+#  include <sys/uio.h>
 #  if defined(_WRS_KERNEL)
 #   include <hostLib.h>
 #   include <selectLib.h>
@@ -39107,6 +41309,20 @@ static inline int gethostname_freertos(char* name, size_t len){
 #   include <sys/select.h>
 #   define UA_sleep_ms(X) usleep(X * 1000)
 #  endif /* defined(_WRS_KERNEL) */
+#  ifdef UA_ENABLE_EPOLL
+#   ifndef __linux__
+#    error "UA_ENABLE_EPOLL requires Linux"
+#   endif
+#   include <sys/epoll.h>
+#  endif
+#  ifdef UA_ENABLE_IO_URING
+#   ifndef __linux__
+#    error "UA_ENABLE_IO_URING requires Linux"
+#   endif
+#   include <linux/io_uring.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#  endif
 # endif /* Not freeRTOS */
 
 # define SOCKET int
@@ -39187,12 +41403,11 @@ connection_releaserecvbuffer(UA_Connection *connection,
     UA_ByteString_deleteMembers(buf);
 }
 
+/* Send the full buffer. The buffer is not freed. */
 static UA_StatusCode
-connection_write(UA_Connection *connection, UA_ByteString *buf) {
-    if(connection->state == UA_CONNECTION_CLOSED) {
-        UA_ByteString_deleteMembers(buf);
+connection_sendAll(UA_Connection *connection, const UA_ByteString *buf) {
+    if(connection->state == UA_CONNECTION_CLOSED)
         return UA_STATUSCODE_BADCONNECTIONCLOSED;
-    }
 
     /* Prevent OS signals when sending to a closed socket */
     int flags = 0;
@@ -39211,21 +41426,28 @@ connection_write(UA_Connection *connection, UA_ByteString *buf) {
                      WIN32_INT bytes_to_send, flags);
             if(n < 0 && errno__ != INTERRUPTED && errno__ != AGAIN) {
                 connection->close(connection);
-                UA_ByteString_deleteMembers(buf);
                 return UA_STATUSCODE_BADCONNECTIONCLOSED;
             }
         } while(n < 0);
         nWritten += (size_t)n;
     } while(nWritten < buf->length);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+connection_write(UA_Connection *connection, UA_ByteString *buf) {
+    UA_StatusCode retval = connection_sendAll(connection, buf);
 
     /* Free the buffer */
     UA_ByteString_deleteMembers(buf);
-    return UA_STATUSCODE_GOOD;
+    return retval;
 }
 
+/* Receive into the allocated buffer. The length of the buffer is set to the
+ * number of bytes received, zero if there was no data. */
 static UA_StatusCode
-connection_recv(UA_Connection *connection, UA_ByteString *response,
-                UA_UInt32 timeout) {
+connection_recvInto(UA_Connection *connection, UA_ByteString *response,
+                    UA_UInt32 timeout) {
     if(connection->state == UA_CONNECTION_CLOSED)
         return UA_STATUSCODE_BADCONNECTIONCLOSED;
 
@@ -39256,27 +41478,19 @@ connection_recv(UA_Connection *connection, UA_ByteString *response,
         }
     }
 
-    response->data = (UA_Byte*)
-        UA_malloc(connection->localConf.recvBufferSize);
-    if(!response->data) {
-        response->length = 0;
-        return UA_STATUSCODE_BADOUTOFMEMORY; /* not enough memory retry */
-    }
-
     /* Get the received packet(s) */
     ssize_t ret = recv(connection->sockfd, (char*)response->data,
-                       connection->localConf.recvBufferSize, 0);
+                       WIN32_INT response->length, 0);
 
     /* The remote side closed the connection */
     if(ret == 0) {
-        UA_ByteString_deleteMembers(response);
         connection->close(connection);
         return UA_STATUSCODE_BADCONNECTIONCLOSED;
     }
 
     /* Error case */
     if(ret < 0) {
-        UA_ByteString_deleteMembers(response);
+        response->length = 0;
         if(errno__ == INTERRUPTED || (timeout > 0) ?
            false : (errno__ == EAGAIN || errno__ == WOULDBLOCK))
             return UA_STATUSCODE_GOOD; /* statuscode_good but no data -> retry */
@@ -39289,6 +41503,23 @@ connection_recv(UA_Connection *connection, UA_ByteString *response,
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+connection_recv(UA_Connection *connection, UA_ByteString *response,
+                UA_UInt32 timeout) {
+    if(connection->state == UA_CONNECTION_CLOSED)
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+
+    UA_StatusCode retval =
+        UA_ByteString_allocBuffer(response, connection->localConf.recvBufferSize);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval; /* not enough memory retry */
+
+    retval = connection_recvInto(connection, response, timeout);
+    if(retval != UA_STATUSCODE_GOOD || response->length == 0)
+        UA_ByteString_deleteMembers(response);
+    return retval;
+}
+
 static UA_StatusCode
 socket_set_nonblocking(SOCKET sockfd) {
 #ifdef _WIN32
@@ -39325,14 +41556,167 @@ socket_set_blocking(SOCKET sockfd) {
     return UA_STATUSCODE_GOOD;
 }
 
+/***************/
+/* Buffer Pool */
+/***************/
+
+/* Send and receive buffers of the server connections are taken from a pool of
+ * the network layer instead of being allocated and freed for every chunk.
+ *
+ * Buffers are kept in power-of-two size classes. Every class has a table of at
+ * most UA_ServerNetworkLayerTCP_maxPooledBuffers slots that is filled on
+ * demand. The free slots form a lock-free free list. Buffers above the largest
+ * class or beyond the maximum number are allocated and freed as before.
+ *
+ * A header in front of the data tells the size class and slot of a buffer.
+ * Buffers from the pool must only be returned with BufferPool_release. */
+
+size_t UA_ServerNetworkLayerTCP_maxPooledBuffers = 64;
+
+#define BUFFERPOOL_MINSIZEBITS 12 /* Smallest class, 4 KiB */
+#define BUFFERPOOL_CLASSES 5      /* Largest class, 64 KiB */
+#define BUFFERPOOL_UNPOOLED 0xffffffff
+
+typedef union {
+    struct {
+        UA_UInt32 sizeClass;
+        UA_UInt32 slot;
+    } info;
+    UA_Double align[2]; /* Keep the data aligned like malloc does */
+} BufferHeader;
+
+typedef struct {
+    volatile size_t freeHead;
+    volatile size_t slotsUsed;
+    volatile UA_UInt32 *nextFree;
+    BufferHeader **buffers;
+} BufferPoolClass;
+
+typedef struct {
+    size_t maxBuffers;
+    BufferPoolClass classes[BUFFERPOOL_CLASSES];
+} BufferPool;
+
+static void
+BufferPool_init(BufferPool *pool, size_t maxBuffers) {
+    memset(pool, 0, sizeof(BufferPool));
+    if(maxBuffers > UA_FREELIST_MAXSLOTS)
+        maxBuffers = UA_FREELIST_MAXSLOTS;
+    for(size_t i = 0; i < BUFFERPOOL_CLASSES && maxBuffers > 0; i++) {
+        BufferPoolClass *c = &pool->classes[i];
+        c->nextFree = (volatile UA_UInt32*)UA_calloc(maxBuffers, sizeof(UA_UInt32));
+        c->buffers = (BufferHeader**)UA_calloc(maxBuffers, sizeof(BufferHeader*));
+        if(!c->nextFree || !c->buffers) {
+            /* Run without the pool */
+            for(size_t j = 0; j <= i; j++) {
+                UA_free((void*)(uintptr_t)pool->classes[j].nextFree);
+                UA_free(pool->classes[j].buffers);
+            }
+            memset(pool, 0, sizeof(BufferPool));
+            return;
+        }
+    }
+    pool->maxBuffers = maxBuffers;
+}
+
+/* Run only when no buffer is in use anymore */
+static void
+BufferPool_deinit(BufferPool *pool) {
+    for(size_t i = 0; i < BUFFERPOOL_CLASSES; i++) {
+        BufferPoolClass *c = &pool->classes[i];
+        size_t slotsUsed = c->slotsUsed < pool->maxBuffers ? c->slotsUsed : pool->maxBuffers;
+        for(size_t j = 0; j < slotsUsed; j++)
+            UA_free(c->buffers[j]);
+        UA_free((void*)(uintptr_t)c->nextFree);
+        UA_free(c->buffers);
+    }
+    memset(pool, 0, sizeof(BufferPool));
+}
+
+static volatile UA_UInt32 *
+BufferPoolClass_nextFree(void *c, size_t slot) {
+    return &((BufferPoolClass*)c)->nextFree[slot];
+}
+
+static UA_StatusCode
+BufferPool_alloc(BufferPool *pool, size_t length, UA_ByteString *buf) {
+    /* Find the size class */
+    UA_UInt32 sizeClass = 0;
+    while(sizeClass < BUFFERPOOL_CLASSES &&
+          length > ((size_t)1 << (BUFFERPOOL_MINSIZEBITS + sizeClass)))
+        sizeClass++;
+
+    BufferHeader *header = NULL;
+    if(sizeClass < BUFFERPOOL_CLASSES && pool->maxBuffers > 0) {
+        BufferPoolClass *c = &pool->classes[sizeClass];
+        size_t slot;
+        if(UA_FreeList_pop(&c->freeHead, BufferPoolClass_nextFree, c, &slot)) {
+            header = c->buffers[slot];
+        } else {
+            /* Add a buffer to the class */
+            slot = UA_atomic_addSize(&c->slotsUsed, 1) - 1;
+            if(slot < pool->maxBuffers) {
+                header = (BufferHeader*)UA_malloc(sizeof(BufferHeader) +
+                    ((size_t)1 << (BUFFERPOOL_MINSIZEBITS + sizeClass)));
+                if(!header)
+                    return UA_STATUSCODE_BADOUTOFMEMORY; /* The slot stays empty */
+                header->info.sizeClass = sizeClass;
+                header->info.slot = (UA_UInt32)slot;
+                c->buffers[slot] = header;
+            } else {
+                /* Keeps slotsUsed at or above the maximum */
+                UA_atomic_subSize(&c->slotsUsed, 1);
+            }
+        }
+    }
+
+    if(!header) {
+        header = (BufferHeader*)UA_malloc(sizeof(BufferHeader) + length);
+        if(!header)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        header->info.sizeClass = BUFFERPOOL_UNPOOLED;
+        header->info.slot = BUFFERPOOL_UNPOOLED;
+    }
+
+    buf->data = (UA_Byte*)&header[1];
+    buf->length = length;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+BufferPool_release(BufferPool *pool, UA_ByteString *buf) {
+    if(!buf->data)
+        return;
+    BufferHeader *header = &((BufferHeader*)buf->data)[-1];
+    if(header->info.sizeClass == BUFFERPOOL_UNPOOLED) {
+        UA_free(header);
+    } else {
+        BufferPoolClass *c = &pool->classes[header->info.sizeClass];
+        UA_FreeList_push(&c->freeHead, BufferPoolClass_nextFree, c,
+                         header->info.slot, header->info.slot);
+    }
+    UA_ByteString_init(buf);
+}
+
 /***************************/
 /* Server NetworkLayer TCP */
 /***************************/
 
 #define MAXBACKLOG     100
+#define TCP_SENDCHUNKS_MAXIOV 16 /* Buffers passed to a single sendmsg */
 #define NOHELLOTIMEOUT 120000 /* timeout in ms before close the connection
                                * if server does not receive Hello Message */
 
+#ifdef UA_ENABLE_EPOLL
+/* With epoll, the sockets are registered once with the kernel instead of
+ * passing all of them to select on every iteration. Readiness is reported
+ * edge-triggered together with the ConnectionEntry, so the cost of an
+ * iteration depends on the number of active sockets only and there is no
+ * FD_SETSIZE limit on the number of connections. */
+#define EPOLL_MAXEVENTS 256
+#define EPOLL_NOHELLOCHECKINTERVAL 1000 /* ms between checks for the Hello timeout */
+#endif
+
 typedef struct ConnectionEntry {
     UA_Connection connection;
     LIST_ENTRY(ConnectionEntry) pointers;
@@ -39345,6 +41729,14 @@ typedef struct {
     UA_Int32 serverSockets[FD_SETSIZE];
     UA_UInt16 serverSocketsSize;
     LIST_HEAD(, ConnectionEntry) connections;
+#ifdef UA_ENABLE_EPOLL
+    int epollfd;
+    /* Connections closed since the last listen. The sockets are closed and the
+     * connections removed from the server at the next listen. */
+    LIST_HEAD(, ConnectionEntry) closedConnections;
+    UA_DateTime nextNoHelloCheck;
+#endif
+    BufferPool pool;
 } ServerNetworkLayerTCP;
 
 static void
@@ -39353,6 +41745,114 @@ ServerNetworkLayerTCP_freeConnection(UA_Connection *connection) {
     UA_free(connection);
 }
 
+/* The handle of a connection points to the layer. The io_uring layer begins
+ * with the TCP layer and shares the buffer functions. */
+static BufferPool *
+connectionBufferPool(UA_Connection *connection) {
+    return &((ServerNetworkLayerTCP*)connection->handle)->pool;
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCP_getSendBuffer(UA_Connection *connection,
+                                    size_t length, UA_ByteString *buf) {
+    if(length > connection->remoteConf.recvBufferSize)
+        return UA_STATUSCODE_BADCOMMUNICATIONERROR;
+    return BufferPool_alloc(connectionBufferPool(connection), length, buf);
+}
+
+static void
+ServerNetworkLayerTCP_releaseBuffer(UA_Connection *connection,
+                                    UA_ByteString *buf) {
+    BufferPool_release(connectionBufferPool(connection), buf);
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCP_send(UA_Connection *connection, UA_ByteString *buf) {
+    UA_StatusCode retval = connection_sendAll(connection, buf);
+    ServerNetworkLayerTCP_releaseBuffer(connection, buf);
+    return retval;
+}
+
+/* Send the chunks of a message with a single system call (scatter-gather) */
+static UA_StatusCode
+ServerNetworkLayerTCP_sendChunks(UA_Connection *connection, UA_ByteString *bufs,
+                                 size_t bufsSize) {
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+#if defined(_WIN32) || defined(UA_FREERTOS)
+    for(size_t i = 0; i < bufsSize && retval == UA_STATUSCODE_GOOD; i++)
+        retval = connection_sendAll(connection, &bufs[i]);
+#else
+    /* Prevent OS signals when sending to a closed socket */
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    /* Buffers sent completely and bytes sent of the next buffer */
+    size_t sent = 0;
+    size_t offset = 0;
+    while(sent < bufsSize) {
+        if(connection->state == UA_CONNECTION_CLOSED) {
+            retval = UA_STATUSCODE_BADCONNECTIONCLOSED;
+            break;
+        }
+
+        struct iovec iov[TCP_SENDCHUNKS_MAXIOV];
+        size_t iovSize = 0;
+        for(size_t i = sent; i < bufsSize && iovSize < TCP_SENDCHUNKS_MAXIOV; i++) {
+            iov[iovSize].iov_base = bufs[i].data + (i == sent ? offset : 0);
+            iov[iovSize].iov_len = bufs[i].length - (i == sent ? offset : 0);
+            iovSize++;
+        }
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovSize;
+
+        ssize_t n = sendmsg(connection->sockfd, &msg, flags);
+        if(n < 0) {
+            if(errno__ == INTERRUPTED || errno__ == AGAIN)
+                continue;
+            connection->close(connection);
+            retval = UA_STATUSCODE_BADCONNECTIONCLOSED;
+            break;
+        }
+
+        /* Skip the sent bytes */
+        size_t rest = (size_t)n;
+        while(sent < bufsSize && rest >= bufs[sent].length - offset) {
+            rest -= bufs[sent].length - offset;
+            offset = 0;
+            sent++;
+        }
+        offset += rest;
+    }
+#endif
+
+    for(size_t i = 0; i < bufsSize; i++)
+        ServerNetworkLayerTCP_releaseBuffer(connection, &bufs[i]);
+    return retval;
+}
+
+/* Receive into a buffer from the pool. The buffer is returned only if data was
+ * received. */
+static UA_StatusCode
+ServerNetworkLayerTCP_recv(UA_Connection *connection, UA_ByteString *buf) {
+    if(connection->state == UA_CONNECTION_CLOSED)
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+
+    UA_StatusCode retval =
+        BufferPool_alloc(connectionBufferPool(connection),
+                         connection->localConf.recvBufferSize, buf);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    retval = connection_recvInto(connection, buf, 0);
+    if(retval != UA_STATUSCODE_GOOD || buf->length == 0)
+        ServerNetworkLayerTCP_releaseBuffer(connection, buf);
+    return retval;
+}
+
 /* This performs only 'shutdown'. 'close' is called when the shutdown
  * socket is returned from select. */
 static void
@@ -39361,6 +41861,15 @@ ServerNetworkLayerTCP_close(UA_Connection *connection) {
         return;
     shutdown((SOCKET)connection->sockfd, 2);
     connection->state = UA_CONNECTION_CLOSED;
+#ifdef UA_ENABLE_EPOLL
+    /* Edge-triggered epoll does not report the shutdown socket reliably, so
+     * hand the connection over to be cleaned up with the next listen. The
+     * connection is the first member of the entry. */
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP*)connection->handle;
+    ConnectionEntry *e = (ConnectionEntry*)connection;
+    LIST_REMOVE(e, pointers);
+    LIST_INSERT_HEAD(&layer->closedConnections, e, pointers);
+#endif
 }
 
 static UA_StatusCode
@@ -39411,17 +41920,36 @@ ServerNetworkLayerTCP_add(ServerNetworkLayerTCP *layer, UA_Int32 newsockfd,
     c->handle = layer;
     c->localConf = layer->conf;
     c->remoteConf = layer->conf;
-    c->send = connection_write;
+    c->send = ServerNetworkLayerTCP_send;
+    c->sendChunks = ServerNetworkLayerTCP_sendChunks;
     c->close = ServerNetworkLayerTCP_close;
     c->free = ServerNetworkLayerTCP_freeConnection;
-    c->getSendBuffer = connection_getsendbuffer;
-    c->releaseSendBuffer = connection_releasesendbuffer;
-    c->releaseRecvBuffer = connection_releaserecvbuffer;
+    c->getSendBuffer = ServerNetworkLayerTCP_getSendBuffer;
+    c->releaseSendBuffer = ServerNetworkLayerTCP_releaseBuffer;
+    c->releaseRecvBuffer = ServerNetworkLayerTCP_releaseBuffer;
     c->state = UA_CONNECTION_OPENING;
     c->openingDate = UA_DateTime_nowMonotonic();
 
     /* Add to the linked list */
     LIST_INSERT_HEAD(&layer->connections, e, pointers);
+
+#ifdef UA_ENABLE_EPOLL
+    /* Data that arrived before the registration is reported right away */
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = e;
+    if(epoll_ctl(layer->epollfd, EPOLL_CTL_ADD, newsockfd, &event) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+                UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                             "Connection %i | Cannot register the socket with epoll. Error: %s",
+                             (int)newsockfd, errno_str));
+        LIST_REMOVE(e, pointers);
+        CLOSESOCKET(newsockfd);
+        UA_free(e);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#endif
     return UA_STATUSCODE_GOOD;
 }
 
@@ -39462,6 +41990,16 @@ addServerSocket(ServerNetworkLayerTCP *layer, struct addrinfo *ai) {
         CLOSESOCKET(newsock);
         return;
     }
+#ifdef SO_REUSEPORT
+    if(custom_reuse_port &&
+       setsockopt(newsock, SOL_SOCKET, SO_REUSEPORT,
+                  (const char *)&optval, sizeof(optval)) == -1) {
+        UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                       "Could not share the port of the socket");
+        CLOSESOCKET(newsock);
+        return;
+    }
+#endif
 
 
     if(socket_set_nonblocking(newsock) != UA_STATUSCODE_GOOD) {
@@ -39493,16 +42031,11 @@ addServerSocket(ServerNetworkLayerTCP *layer, struct addrinfo *ai) {
     layer->serverSocketsSize++;
 }
 
+/* Set the discovery url and open the server sockets */
 static UA_StatusCode
-ServerNetworkLayerTCP_start(UA_ServerNetworkLayer *nl, const UA_String *customHostname) {
-#ifdef _WIN32
-    WORD wVersionRequested = MAKEWORD(2, 2);
-    WSADATA wsaData;
-    WSAStartup(wVersionRequested, &wsaData);
-#endif
-
-    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
-
+ServerNetworkLayerTCP_openServerSockets(UA_ServerNetworkLayer *nl,
+                                        ServerNetworkLayerTCP *layer,
+                                        const UA_String *customHostname) {
     /* Get the discovery url from the hostname */
     UA_String du = UA_STRING_NULL;
     if (customHostname->length) {
@@ -39566,6 +42099,48 @@ ServerNetworkLayerTCP_start(UA_ServerNetworkLayer *nl, const UA_String *customHo
         ai = ai->ai_next)
         addServerSocket(layer, ai);
     freeaddrinfo(res);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCP_start(UA_ServerNetworkLayer *nl, const UA_String *customHostname) {
+#ifdef _WIN32
+    WORD wVersionRequested = MAKEWORD(2, 2);
+    WSADATA wsaData;
+    WSAStartup(wVersionRequested, &wsaData);
+#endif
+
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    UA_StatusCode retval =
+        ServerNetworkLayerTCP_openServerSockets(nl, layer, customHostname);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+#ifdef UA_ENABLE_EPOLL
+    layer->epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if(layer->epollfd < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                         "Cannot create the epoll instance: %s", errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Server sockets are told apart from connections by pointing into the
+     * serverSockets array */
+    for(UA_UInt16 i = 0; i < layer->serverSocketsSize; i++) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLET;
+        event.data.ptr = &layer->serverSockets[i];
+        if(epoll_ctl(layer->epollfd, EPOLL_CTL_ADD, layer->serverSockets[i], &event) != 0)
+            UA_LOG_SOCKET_ERRNO_WRAP(
+                UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                               "Cannot register server socket %i with epoll: %s",
+                               layer->serverSockets[i], errno_str));
+    }
+    layer->nextNoHelloCheck = UA_DateTime_nowMonotonic() +
+        (EPOLL_NOHELLOCHECKINTERVAL * UA_DATETIME_MSEC);
+#endif
 
     UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
                 "TCP network layer listening on %.*s",
@@ -39594,12 +42169,128 @@ setFDSet(ServerNetworkLayerTCP *layer, fd_set *fdset) {
     return highestfd;
 }
 
+#ifdef UA_ENABLE_EPOLL
+
+/* Close the sockets of connections closed since the last call and remove the
+ * connections from the server */
+static void
+removeClosedConnections(ServerNetworkLayerTCP *layer, UA_Server *server) {
+    ConnectionEntry *e, *e_tmp;
+    LIST_FOREACH_SAFE(e, &layer->closedConnections, pointers, e_tmp) {
+        UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | Closed",
+                    e->connection.sockfd);
+        LIST_REMOVE(e, pointers);
+        epoll_ctl(layer->epollfd, EPOLL_CTL_DEL, e->connection.sockfd, NULL);
+        CLOSESOCKET(e->connection.sockfd);
+        UA_Server_removeConnection(server, &e->connection);
+    }
+}
+
+/* Edge-triggered: accept until the backlog is empty */
+static void
+acceptConnections(ServerNetworkLayerTCP *layer, UA_Int32 serverSocket) {
+    while(true) {
+        struct sockaddr_storage remote;
+        socklen_t remote_size = sizeof(remote);
+        SOCKET newsockfd = accept((SOCKET)serverSocket,
+                                  (struct sockaddr*)&remote, &remote_size);
+        if(newsockfd < 0) {
+            if(errno__ == INTERRUPTED)
+                continue;
+            if(errno__ != AGAIN && errno__ != WOULDBLOCK)
+                UA_LOG_SOCKET_ERRNO_WRAP(
+                    UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                                   "Accept on server socket %i failed with %s",
+                                   serverSocket, errno_str));
+            return;
+        }
+
+        UA_LOG_TRACE(layer->logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | New TCP connection on server socket %i",
+                    (int)newsockfd, serverSocket);
+
+        ServerNetworkLayerTCP_add(layer, (UA_Int32)newsockfd, &remote);
+    }
+}
+
+/* Edge-triggered: read until the socket has no more data */
+static void
+receiveMessages(UA_Server *server, ConnectionEntry *e) {
+    while(e->connection.state != UA_CONNECTION_CLOSED) {
+        UA_ByteString buf = UA_BYTESTRING_NULL;
+        UA_StatusCode retval = ServerNetworkLayerTCP_recv(&e->connection, &buf);
+        if(retval != UA_STATUSCODE_GOOD || buf.length == 0)
+            return; /* Closed connections are removed with the next listen */
+        UA_Server_processBinaryMessage(server, &e->connection, &buf);
+        ServerNetworkLayerTCP_releaseBuffer(&e->connection, &buf);
+    }
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCP_listenEpoll(ServerNetworkLayerTCP *layer, UA_Server *server,
+                                  UA_UInt16 timeout) {
+    removeClosedConnections(layer, server);
+
+    struct epoll_event events[EPOLL_MAXEVENTS];
+    int eventsSize = epoll_wait(layer->epollfd, events, EPOLL_MAXEVENTS, timeout);
+    if(eventsSize < 0) {
+        if(errno__ != INTERRUPTED)
+            UA_LOG_SOCKET_ERRNO_WRAP(
+                UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                               "Socket epoll_wait failed with %s", errno_str));
+        // we will retry, so do not return bad
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_Int32 *serverSocketsEnd = &layer->serverSockets[layer->serverSocketsSize];
+    for(int i = 0; i < eventsSize; i++) {
+        void *ptr = events[i].data.ptr;
+        if(ptr >= (void*)layer->serverSockets && ptr < (void*)serverSocketsEnd) {
+            acceptConnections(layer, *(UA_Int32*)ptr);
+            continue;
+        }
+
+        ConnectionEntry *e = (ConnectionEntry*)ptr;
+        UA_LOG_TRACE(layer->logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | Activity on the socket",
+                    e->connection.sockfd);
+        receiveMessages(server, e);
+    }
+
+    /* Close connections that did not send a Hello message in time. The
+     * connection list is only walked once per check interval. */
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    if(now >= layer->nextNoHelloCheck) {
+        layer->nextNoHelloCheck = now + (EPOLL_NOHELLOCHECKINTERVAL * UA_DATETIME_MSEC);
+        ConnectionEntry *e, *e_tmp;
+        LIST_FOREACH_SAFE(e, &layer->connections, pointers, e_tmp) {
+            if((e->connection.state == UA_CONNECTION_OPENING) &&
+               (now > (e->connection.openingDate + (NOHELLOTIMEOUT * UA_DATETIME_MSEC)))) {
+                UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
+                            "Connection %i | Closed by the server (no Hello Message)",
+                            e->connection.sockfd);
+                ServerNetworkLayerTCP_close(&e->connection);
+            }
+        }
+    }
+
+    removeClosedConnections(layer, server);
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* UA_ENABLE_EPOLL */
+
 static UA_StatusCode
 ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
                              UA_UInt16 timeout) {
     /* Every open socket can generate two jobs */
     ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
 
+#ifdef UA_ENABLE_EPOLL
+    return ServerNetworkLayerTCP_listenEpoll(layer, server, timeout);
+#endif
+
     if (layer->serverSocketsSize == 0)
         return UA_STATUSCODE_GOOD;
 
@@ -39663,12 +42354,12 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
                     e->connection.sockfd);
 
         UA_ByteString buf = UA_BYTESTRING_NULL;
-        UA_StatusCode retval = connection_recv(&e->connection, &buf, 0);
+        UA_StatusCode retval = ServerNetworkLayerTCP_recv(&e->connection, &buf);
 
         if(retval == UA_STATUSCODE_GOOD) {
             /* Process packets */
             UA_Server_processBinaryMessage(server, &e->connection, &buf);
-            connection_releaserecvbuffer(&e->connection, &buf);
+            ServerNetworkLayerTCP_releaseBuffer(&e->connection, &buf);
         } else if(retval == UA_STATUSCODE_BADCONNECTIONCLOSED) {
             /* The socket is shutdown but not closed */
             UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
@@ -39695,15 +42386,21 @@ ServerNetworkLayerTCP_stop(UA_ServerNetworkLayer *nl, UA_Server *server) {
     }
     layer->serverSocketsSize = 0;
 
-    /* Close open connections */
-    ConnectionEntry *e;
-    LIST_FOREACH(e, &layer->connections, pointers)
+    /* Close open connections. With epoll, closing moves the entry to the list
+     * of closed connections. */
+    ConnectionEntry *e, *e_tmp;
+    LIST_FOREACH_SAFE(e, &layer->connections, pointers, e_tmp)
         ServerNetworkLayerTCP_close(&e->connection);
 
     /* Run recv on client sockets. This picks up the closed sockets and frees
      * the connection. */
     ServerNetworkLayerTCP_listen(nl, server, 0);
 
+#ifdef UA_ENABLE_EPOLL
+    CLOSESOCKET(layer->epollfd);
+    layer->epollfd = -1;
+#endif
+
 #ifdef _WIN32
     WSACleanup();
 #endif
@@ -39723,8 +42420,16 @@ ServerNetworkLayerTCP_deleteMembers(UA_ServerNetworkLayer *nl) {
         CLOSESOCKET(e->connection.sockfd);
         UA_free(e);
     }
+#ifdef UA_ENABLE_EPOLL
+    LIST_FOREACH_SAFE(e, &layer->closedConnections, pointers, e_tmp) {
+        LIST_REMOVE(e, pointers);
+        CLOSESOCKET(e->connection.sockfd);
+        UA_free(e);
+    }
+#endif
 
     /* Free the layer */
+    BufferPool_deinit(&layer->pool);
     UA_free(layer);
 }
 
@@ -39746,10 +42451,694 @@ UA_ServerNetworkLayerTCP(UA_ConnectionConfig conf, UA_UInt16 port, UA_Logger log
     layer->logger = (logger != NULL ? logger : UA_Log_Stdout);
     layer->conf = conf;
     layer->port = port;
+#ifdef UA_ENABLE_EPOLL
+    layer->epollfd = -1;
+#endif
+    BufferPool_init(&layer->pool, UA_ServerNetworkLayerTCP_maxPooledBuffers);
+
+    return nl;
+}
+
+#ifdef UA_ENABLE_IO_URING
+
+/********************************/
+/* Server NetworkLayer io_uring */
+/********************************/
+
+/* Alternative to the select / epoll based TCP layer for Linux. The socket
+ * operations are submitted to an io_uring instead of being called directly:
+ *
+ * - Every server socket has a multishot accept and every connection a
+ *   multishot recv outstanding. Received data is placed by the kernel into
+ *   buffers taken from a buffer ring registered with the io_uring, so there
+ *   is no recv call per chunk.
+ * - Messages are not sent from within connection->send. The send operations
+ *   of all connections are queued and submitted together once per listen.
+ *   At most one send is in flight per connection, so the chunks of a
+ *   connection keep their order.
+ *
+ * Server sockets, configuration and logger are taken over from the TCP layer.
+ * The layer needs multishot recv and buffer rings (Linux 6.0). If the kernel
+ * does not support them, UA_ServerNetworkLayerIoUring returns the TCP layer
+ * instead. */
+
+#define IOURING_ENTRIES 1024   /* Size of the submission queue */
+#define IOURING_BUFFERS 128    /* Receive buffers, a power of two */
+#define IOURING_BUFGROUP 0
+#define IOURING_NOHELLOCHECKINTERVAL 1000 /* ms between checks for the Hello timeout */
+#define IOURING_STOPITERATIONS 100 /* listen calls to wait for connections to close */
+
+/* The lower bits of the user_data of a submission tell the kind of the
+ * operation. The remaining bits point to the connection or server socket. */
+#define IOURING_OP_RECV   0
+#define IOURING_OP_SEND   1
+#define IOURING_OP_ACCEPT 2
+#define IOURING_OP_IGNORE 3
+#define IOURING_OP_MASK   3
+
+typedef struct {
+    int fd;
+    void *rings;
+    size_t ringsSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqArray;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned sqPending; /* Queued submissions not yet passed to the kernel */
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+
+    /* Buffers for the received data */
+    struct io_uring_buf_ring *bufRing;
+    size_t bufRingSize;
+    unsigned buffersSize;
+    UA_Byte *buffers;
+    size_t bufferSize;
+} IoUring;
+
+typedef struct IoUringSendEntry {
+    UA_ByteString buf;
+    size_t offset;
+    SIMPLEQ_ENTRY(IoUringSendEntry) next;
+} IoUringSendEntry;
+
+typedef struct IoUringConnection {
+    UA_Connection connection;
+    LIST_ENTRY(IoUringConnection) pointers;
+    /* The first entry is in flight while sending is set */
+    SIMPLEQ_HEAD(, IoUringSendEntry) sendQueue;
+    UA_Boolean sending;
+    UA_Boolean receiving;
+} IoUringConnection;
+
+typedef struct {
+    ServerNetworkLayerTCP tcp;
+    IoUring ring;
+    LIST_HEAD(, IoUringConnection) connections;
+    /* Closed connections are removed from the server once no operation is in
+     * flight */
+    LIST_HEAD(, IoUringConnection) closedConnections;
+    UA_DateTime nextNoHelloCheck;
+} ServerNetworkLayerIoUring;
+
+static void
+IoUring_deinit(IoUring *ring) {
+    if(ring->bufRing) {
+        struct io_uring_buf_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.bgid = IOURING_BUFGROUP;
+        syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        munmap(ring->bufRing, ring->bufRingSize);
+    }
+    UA_free(ring->buffers);
+    if(ring->sqes)
+        munmap(ring->sqes, ring->sqesSize);
+    if(ring->rings)
+        munmap(ring->rings, ring->ringsSize);
+    if(ring->fd >= 0)
+        close(ring->fd);
+    memset(ring, 0, sizeof(IoUring));
+    ring->fd = -1;
+}
+
+/* Hand a receive buffer (back) to the kernel */
+static void
+IoUring_provideBuffer(IoUring *ring, unsigned short bid) {
+    unsigned short tail = ring->bufRing->tail;
+    struct io_uring_buf *buf = &ring->bufRing->bufs[tail & (ring->buffersSize - 1)];
+    buf->addr = (uintptr_t)&ring->buffers[bid * ring->bufferSize];
+    buf->len = (__u32)ring->bufferSize;
+    buf->bid = bid;
+    __atomic_store_n(&ring->bufRing->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+static UA_StatusCode
+IoUring_init(IoUring *ring, unsigned entries, unsigned buffersSize, size_t bufferSize) {
+    memset(ring, 0, sizeof(IoUring));
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    p.cq_entries = entries * 4; /* Multishot operations complete many times */
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if(ring->fd < 0)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    if(!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_EXT_ARG)) {
+        IoUring_deinit(ring);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
+    /* Map the submission and completion queues */
+    size_t sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->ringsSize = sqSize > cqSize ? sqSize : cqSize;
+    void *rings = mmap(NULL, ring->ringsSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if(rings == MAP_FAILED) {
+        IoUring_deinit(ring);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    ring->rings = rings;
+    ring->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED) {
+        IoUring_deinit(ring);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    ring->sqes = (struct io_uring_sqe*)sqes;
+    UA_Byte *base = (UA_Byte*)rings;
+    ring->sqHead = (unsigned*)(base + p.sq_off.head);
+    ring->sqTail = (unsigned*)(base + p.sq_off.tail);
+    ring->sqArray = (unsigned*)(base + p.sq_off.array);
+    ring->sqMask = *(unsigned*)(base + p.sq_off.ring_mask);
+    ring->sqEntries = p.sq_entries;
+    ring->cqHead = (unsigned*)(base + p.cq_off.head);
+    ring->cqTail = (unsigned*)(base + p.cq_off.tail);
+    ring->cqMask = *(unsigned*)(base + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(base + p.cq_off.cqes);
+
+    /* Register the ring of receive buffers */
+    ring->buffersSize = buffersSize;
+    ring->bufferSize = bufferSize;
+    ring->buffers = (UA_Byte*)UA_malloc(buffersSize * bufferSize);
+    ring->bufRingSize = buffersSize * sizeof(struct io_uring_buf);
+    void *bufRing = mmap(NULL, ring->bufRingSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(!ring->buffers || bufRing == MAP_FAILED) {
+        IoUring_deinit(ring);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uintptr_t)bufRing;
+    reg.ring_entries = buffersSize;
+    reg.bgid = IOURING_BUFGROUP;
+    if(syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        munmap(bufRing, ring->bufRingSize);
+        IoUring_deinit(ring);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    ring->bufRing = (struct io_uring_buf_ring*)bufRing;
+    for(unsigned i = 0; i < buffersSize; i++)
+        IoUring_provideBuffer(ring, (unsigned short)i);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Pass the queued submissions to the kernel. If timeout is > 0, wait up to
+ * timeout ms for a completion. */
+static void
+IoUring_submit(IoUring *ring, UA_UInt16 timeout) {
+    unsigned flags = 0;
+    unsigned waitNr = 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if(timeout > 0 && *ring->cqHead == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000LL;
+        arg.ts = (uintptr_t)&ts;
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        waitNr = 1;
+    }
+    if(ring->sqPending == 0 && waitNr == 0)
+        return;
+    long res = syscall(__NR_io_uring_enter, ring->fd, ring->sqPending, waitNr,
+                       flags, &arg, sizeof(arg));
+    /* ETIME and EINTR only end the wait */
+    if(res > 0)
+        ring->sqPending -= (unsigned)res;
+}
+
+/* Get an empty submission queue entry. Submits the queue if it is full. */
+static struct io_uring_sqe *
+IoUring_getSqe(IoUring *ring, int fd, UA_Byte opcode, uintptr_t userData) {
+    unsigned tail = *ring->sqTail;
+    if(tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) >= ring->sqEntries) {
+        IoUring_submit(ring, 0);
+        if(tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) >= ring->sqEntries)
+            return NULL;
+    }
+    struct io_uring_sqe *sqe = &ring->sqes[tail & ring->sqMask];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = userData;
+    ring->sqArray[tail & ring->sqMask] = tail & ring->sqMask;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ring->sqPending++;
+    return sqe;
+}
+
+static UA_StatusCode
+IoUring_submitAccept(IoUring *ring, UA_Int32 *serverSocket) {
+    struct io_uring_sqe *sqe =
+        IoUring_getSqe(ring, *serverSocket, IORING_OP_ACCEPT,
+                       (uintptr_t)serverSocket | IOURING_OP_ACCEPT);
+    if(!sqe)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+IoUring_submitRecv(IoUring *ring, IoUringConnection *c) {
+    struct io_uring_sqe *sqe =
+        IoUring_getSqe(ring, c->connection.sockfd, IORING_OP_RECV,
+                       (uintptr_t)c | IOURING_OP_RECV);
+    if(!sqe)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IOURING_BUFGROUP;
+    c->receiving = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+IoUring_submitSend(IoUring *ring, IoUringConnection *c) {
+    IoUringSendEntry *entry = SIMPLEQ_FIRST(&c->sendQueue);
+    struct io_uring_sqe *sqe =
+        IoUring_getSqe(ring, c->connection.sockfd, IORING_OP_SEND,
+                       (uintptr_t)c | IOURING_OP_SEND);
+    if(!sqe)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    sqe->addr = (uintptr_t)&entry->buf.data[entry->offset];
+    sqe->len = (__u32)(entry->buf.length - entry->offset);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    c->sending = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Cancel an operation by its user_data. The completion of the cancel request
+ * itself is ignored. */
+static void
+IoUring_submitCancel(IoUring *ring, uintptr_t userData) {
+    struct io_uring_sqe *sqe =
+        IoUring_getSqe(ring, -1, IORING_OP_ASYNC_CANCEL, IOURING_OP_IGNORE);
+    if(sqe)
+        sqe->addr = userData;
+}
+
+static void
+IoUringConnection_clearSendQueue(IoUringConnection *c) {
+    IoUringSendEntry *entry;
+    while((entry = SIMPLEQ_FIRST(&c->sendQueue))) {
+        SIMPLEQ_REMOVE_HEAD(&c->sendQueue, next);
+        ServerNetworkLayerTCP_releaseBuffer(&c->connection, &entry->buf);
+        UA_free(entry);
+    }
+}
+
+/* Closing shuts down the socket once the queued messages are sent. The
+ * connection is removed during the next listen when no operation is in
+ * flight anymore. */
+static void
+ServerNetworkLayerIoUring_close(UA_Connection *connection) {
+    if(connection->state == UA_CONNECTION_CLOSED)
+        return;
+    connection->state = UA_CONNECTION_CLOSED;
+    ServerNetworkLayerIoUring *layer = (ServerNetworkLayerIoUring*)connection->handle;
+    IoUringConnection *c = (IoUringConnection*)connection;
+    if(c->receiving)
+        IoUring_submitCancel(&layer->ring, (uintptr_t)c | IOURING_OP_RECV);
+    if(!c->sending)
+        shutdown(connection->sockfd, 2);
+    LIST_REMOVE(c, pointers);
+    LIST_INSERT_HEAD(&layer->closedConnections, c, pointers);
+}
+
+/* Takes over the buffer and queues it for sending */
+static UA_StatusCode
+ServerNetworkLayerIoUring_send(UA_Connection *connection, UA_ByteString *buf) {
+    if(connection->state == UA_CONNECTION_CLOSED) {
+        ServerNetworkLayerTCP_releaseBuffer(connection, buf);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    IoUringSendEntry *entry = (IoUringSendEntry*)UA_malloc(sizeof(IoUringSendEntry));
+    if(!entry) {
+        ServerNetworkLayerTCP_releaseBuffer(connection, buf);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    entry->buf = *buf;
+    entry->offset = 0;
+    UA_ByteString_init(buf);
+
+    ServerNetworkLayerIoUring *layer = (ServerNetworkLayerIoUring*)connection->handle;
+    IoUringConnection *c = (IoUringConnection*)connection;
+    SIMPLEQ_INSERT_TAIL(&c->sendQueue, entry, next);
+    if(c->sending)
+        return UA_STATUSCODE_GOOD;
+    if(IoUring_submitSend(&layer->ring, c) != UA_STATUSCODE_GOOD) {
+        IoUringConnection_clearSendQueue(c);
+        connection->close(connection);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ServerNetworkLayerIoUring_add(ServerNetworkLayerIoUring *layer, int newsockfd) {
+    int dummy = 1;
+    setsockopt(newsockfd, IPPROTO_TCP, TCP_NODELAY, &dummy, sizeof(dummy));
+
+    /* Get the peer name for logging */
+    struct sockaddr_storage remote;
+    socklen_t remote_size = sizeof(remote);
+    char remote_name[100];
+    if(getpeername(newsockfd, (struct sockaddr*)&remote, &remote_size) == 0 &&
+       getnameinfo((struct sockaddr*)&remote, remote_size, remote_name,
+                   sizeof(remote_name), NULL, 0, NI_NUMERICHOST) == 0)
+        UA_LOG_INFO(layer->tcp.logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | New connection over TCP from %s",
+                    newsockfd, remote_name);
+
+    IoUringConnection *c = (IoUringConnection*)UA_calloc(1, sizeof(IoUringConnection));
+    if(!c) {
+        CLOSESOCKET(newsockfd);
+        return;
+    }
+    UA_Connection *connection = &c->connection;
+    connection->sockfd = newsockfd;
+    connection->handle = layer;
+    connection->localConf = layer->tcp.conf;
+    connection->remoteConf = layer->tcp.conf;
+    connection->send = ServerNetworkLayerIoUring_send;
+    connection->close = ServerNetworkLayerIoUring_close;
+    connection->free = ServerNetworkLayerTCP_freeConnection;
+    connection->getSendBuffer = ServerNetworkLayerTCP_getSendBuffer;
+    connection->releaseSendBuffer = ServerNetworkLayerTCP_releaseBuffer;
+    connection->releaseRecvBuffer = connection_releaserecvbuffer;
+    connection->state = UA_CONNECTION_OPENING;
+    connection->openingDate = UA_DateTime_nowMonotonic();
+    SIMPLEQ_INIT(&c->sendQueue);
+    LIST_INSERT_HEAD(&layer->connections, c, pointers);
+
+    if(IoUring_submitRecv(&layer->ring, c) != UA_STATUSCODE_GOOD)
+        connection->close(connection);
+}
+
+static void
+ServerNetworkLayerIoUring_accepted(ServerNetworkLayerIoUring *layer,
+                                   UA_Int32 *serverSocket, struct io_uring_cqe *cqe) {
+    if(cqe->res >= 0)
+        ServerNetworkLayerIoUring_add(layer, cqe->res);
+    else if(cqe->res != -ECANCELED)
+        UA_LOG_WARNING(layer->tcp.logger, UA_LOGCATEGORY_NETWORK,
+                       "Accept on server socket %i failed with %s",
+                       *serverSocket, strerror(-cqe->res));
+
+    /* The multishot accept was terminated. Restart unless stopping. */
+    if(!(cqe->flags & IORING_CQE_F_MORE) && layer->tcp.serverSocketsSize > 0)
+        IoUring_submitAccept(&layer->ring, serverSocket);
+}
+
+static void
+ServerNetworkLayerIoUring_received(ServerNetworkLayerIoUring *layer, UA_Server *server,
+                                   IoUringConnection *c, struct io_uring_cqe *cqe) {
+    if(cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+        unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        if(c->connection.state != UA_CONNECTION_CLOSED) {
+            UA_ByteString buf;
+            buf.length = (size_t)cqe->res;
+            buf.data = &layer->ring.buffers[bid * layer->ring.bufferSize];
+            UA_Server_processBinaryMessage(server, &c->connection, &buf);
+        }
+        IoUring_provideBuffer(&layer->ring, bid);
+    }
+
+    if(cqe->flags & IORING_CQE_F_MORE)
+        return;
+
+    /* The multishot recv was terminated. Restart it if the kernel ran out of
+     * buffers. An error or the end of the stream closes the connection. */
+    c->receiving = false;
+    if(c->connection.state == UA_CONNECTION_CLOSED)
+        return;
+    if(cqe->res > 0 || cqe->res == -ENOBUFS) {
+        if(IoUring_submitRecv(&layer->ring, c) == UA_STATUSCODE_GOOD)
+            return;
+    }
+    c->connection.close(&c->connection);
+}
+
+static void
+ServerNetworkLayerIoUring_sent(ServerNetworkLayerIoUring *layer,
+                               IoUringConnection *c, struct io_uring_cqe *cqe) {
+    c->sending = false;
+    if(cqe->res < 0) {
+        IoUringConnection_clearSendQueue(c);
+        if(c->connection.state == UA_CONNECTION_CLOSED)
+            shutdown(c->connection.sockfd, 2);
+        else
+            c->connection.close(&c->connection);
+        return;
+    }
+
+    IoUringSendEntry *entry = SIMPLEQ_FIRST(&c->sendQueue);
+    entry->offset += (size_t)cqe->res;
+    if(entry->offset >= entry->buf.length) {
+        SIMPLEQ_REMOVE_HEAD(&c->sendQueue, next);
+        ServerNetworkLayerTCP_releaseBuffer(&c->connection, &entry->buf);
+        UA_free(entry);
+    }
+
+    /* Send the rest of the buffer or the next buffer */
+    if(!SIMPLEQ_EMPTY(&c->sendQueue)) {
+        if(IoUring_submitSend(&layer->ring, c) == UA_STATUSCODE_GOOD)
+            return;
+        IoUringConnection_clearSendQueue(c);
+    }
+
+    /* The connection was closed while sending */
+    if(c->connection.state == UA_CONNECTION_CLOSED)
+        shutdown(c->connection.sockfd, 2);
+}
+
+static void
+ServerNetworkLayerIoUring_removeClosedConnections(ServerNetworkLayerIoUring *layer,
+                                                  UA_Server *server) {
+    IoUringConnection *c, *c_tmp;
+    LIST_FOREACH_SAFE(c, &layer->closedConnections, pointers, c_tmp) {
+        if(c->receiving || c->sending)
+            continue;
+        UA_LOG_INFO(layer->tcp.logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | Closed", c->connection.sockfd);
+        LIST_REMOVE(c, pointers);
+        CLOSESOCKET(c->connection.sockfd);
+        UA_Server_removeConnection(server, &c->connection);
+    }
+}
+
+static UA_StatusCode
+ServerNetworkLayerIoUring_start(UA_ServerNetworkLayer *nl, const UA_String *customHostname) {
+    ServerNetworkLayerIoUring *layer = (ServerNetworkLayerIoUring *)nl->handle;
+    UA_StatusCode retval =
+        IoUring_init(&layer->ring, IOURING_ENTRIES, IOURING_BUFFERS,
+                     layer->tcp.conf.recvBufferSize);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(layer->tcp.logger, UA_LOGCATEGORY_NETWORK,
+                     "Cannot set up the io_uring: %s", UA_StatusCode_name(retval));
+        return retval;
+    }
+
+    retval = ServerNetworkLayerTCP_openServerSockets(nl, &layer->tcp, customHostname);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    for(UA_UInt16 i = 0; i < layer->tcp.serverSocketsSize; i++)
+        IoUring_submitAccept(&layer->ring, &layer->tcp.serverSockets[i]);
+    IoUring_submit(&layer->ring, 0);
+    layer->nextNoHelloCheck = UA_DateTime_nowMonotonic() +
+        (IOURING_NOHELLOCHECKINTERVAL * UA_DATETIME_MSEC);
+
+    UA_LOG_INFO(layer->tcp.logger, UA_LOGCATEGORY_NETWORK,
+                "TCP network layer (io_uring) listening on %.*s",
+                (int)nl->discoveryUrl.length, nl->discoveryUrl.data);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+ServerNetworkLayerIoUring_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
+                                 UA_UInt16 timeout) {
+    ServerNetworkLayerIoUring *layer = (ServerNetworkLayerIoUring *)nl->handle;
+    IoUring *ring = &layer->ring;
+    ServerNetworkLayerIoUring_removeClosedConnections(layer, server);
+
+    /* Submit what was queued since the last listen and wait for completions */
+    IoUring_submit(ring, timeout);
+
+    /* Process the completions that are available now */
+    unsigned head = *ring->cqHead;
+    unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+    while(head != tail) {
+        struct io_uring_cqe cqe = ring->cqes[head & ring->cqMask];
+        head++;
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+        void *ptr = (void*)(uintptr_t)(cqe.user_data & ~(__u64)IOURING_OP_MASK);
+        switch(cqe.user_data & IOURING_OP_MASK) {
+        case IOURING_OP_ACCEPT:
+            ServerNetworkLayerIoUring_accepted(layer, (UA_Int32*)ptr, &cqe);
+            break;
+        case IOURING_OP_RECV:
+            ServerNetworkLayerIoUring_received(layer, server, (IoUringConnection*)ptr, &cqe);
+            break;
+        case IOURING_OP_SEND:
+            ServerNetworkLayerIoUring_sent(layer, (IoUringConnection*)ptr, &cqe);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* Close connections that did not send a Hello message in time */
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    if(now >= layer->nextNoHelloCheck) {
+        layer->nextNoHelloCheck = now + (IOURING_NOHELLOCHECKINTERVAL * UA_DATETIME_MSEC);
+        IoUringConnection *c, *c_tmp;
+        LIST_FOREACH_SAFE(c, &layer->connections, pointers, c_tmp) {
+            if((c->connection.state == UA_CONNECTION_OPENING) &&
+               (now > (c->connection.openingDate + (NOHELLOTIMEOUT * UA_DATETIME_MSEC)))) {
+                UA_LOG_INFO(layer->tcp.logger, UA_LOGCATEGORY_NETWORK,
+                            "Connection %i | Closed by the server (no Hello Message)",
+                            c->connection.sockfd);
+                c->connection.close(&c->connection);
+            }
+        }
+    }
 
+    /* Submit the responses to all connections at once */
+    IoUring_submit(ring, 0);
+    ServerNetworkLayerIoUring_removeClosedConnections(layer, server);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ServerNetworkLayerIoUring_stop(UA_ServerNetworkLayer *nl, UA_Server *server) {
+    ServerNetworkLayerIoUring *layer = (ServerNetworkLayerIoUring *)nl->handle;
+    UA_LOG_INFO(layer->tcp.logger, UA_LOGCATEGORY_NETWORK,
+                "Shutting down the TCP network layer (io_uring)");
+
+    /* Stop accepting. Setting the size to zero prevents restarting the
+     * multishot accepts. */
+    UA_UInt16 serverSocketsSize = layer->tcp.serverSocketsSize;
+    layer->tcp.serverSocketsSize = 0;
+    for(UA_UInt16 i = 0; i < serverSocketsSize; i++)
+        IoUring_submitCancel(&layer->ring,
+                             (uintptr_t)&layer->tcp.serverSockets[i] | IOURING_OP_ACCEPT);
+
+    /* Close open connections and wait for the operations to finish */
+    IoUringConnection *c;
+    while((c = LIST_FIRST(&layer->connections)))
+        c->connection.close(&c->connection);
+    for(size_t i = 0; i < IOURING_STOPITERATIONS &&
+            !LIST_EMPTY(&layer->closedConnections); i++)
+        ServerNetworkLayerIoUring_listen(nl, server, 10);
+
+    for(UA_UInt16 i = 0; i < serverSocketsSize; i++) {
+        shutdown((SOCKET)layer->tcp.serverSockets[i], 2);
+        CLOSESOCKET(layer->tcp.serverSockets[i]);
+    }
+
+    /* Closing the ring cancels what is still in flight */
+    IoUring_deinit(&layer->ring);
+}
+
+/* run only when the server is stopped */
+static void
+ServerNetworkLayerIoUring_deleteMembers(UA_ServerNetworkLayer *nl) {
+    ServerNetworkLayerIoUring *layer = (ServerNetworkLayerIoUring *)nl->handle;
+    UA_String_deleteMembers(&nl->discoveryUrl);
+    IoUring_deinit(&layer->ring);
+
+    /* Hard-close and remove remaining connections */
+    IoUringConnection *c, *c_tmp;
+    LIST_FOREACH_SAFE(c, &layer->connections, pointers, c_tmp) {
+        LIST_REMOVE(c, pointers);
+        IoUringConnection_clearSendQueue(c);
+        CLOSESOCKET(c->connection.sockfd);
+        ServerNetworkLayerTCP_freeConnection(&c->connection);
+    }
+    LIST_FOREACH_SAFE(c, &layer->closedConnections, pointers, c_tmp) {
+        LIST_REMOVE(c, pointers);
+        IoUringConnection_clearSendQueue(c);
+        CLOSESOCKET(c->connection.sockfd);
+        ServerNetworkLayerTCP_freeConnection(&c->connection);
+    }
+    BufferPool_deinit(&layer->tcp.pool);
+    UA_free(layer);
+}
+
+/* Check that multishot recv into a buffer ring works on a socket pair */
+static UA_Boolean
+IoUring_isSupported(void) {
+    IoUring ring;
+    if(IoUring_init(&ring, 4, 1, 16) != UA_STATUSCODE_GOOD)
+        return false;
+    UA_Boolean supported = false;
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0) {
+        IoUringConnection c;
+        memset(&c, 0, sizeof(c));
+        c.connection.sockfd = sv[0];
+        if(IoUring_submitRecv(&ring, &c) == UA_STATUSCODE_GOOD &&
+           send(sv[1], "x", 1, MSG_NOSIGNAL) == 1) {
+            IoUring_submit(&ring, 1000);
+            if(*ring.cqHead != __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE)) {
+                struct io_uring_cqe *cqe = &ring.cqes[*ring.cqHead & ring.cqMask];
+                supported = (cqe->res == 1 && (cqe->flags & IORING_CQE_F_BUFFER) &&
+                             (cqe->flags & IORING_CQE_F_MORE));
+            }
+        }
+        close(sv[0]);
+        close(sv[1]);
+    }
+    IoUring_deinit(&ring);
+    return supported;
+}
+
+UA_ServerNetworkLayer
+UA_ServerNetworkLayerIoUring(UA_ConnectionConfig conf, UA_UInt16 port, UA_Logger logger) {
+    if(!logger)
+        logger = UA_Log_Stdout;
+    if(!IoUring_isSupported()) {
+        UA_LOG_WARNING(logger, UA_LOGCATEGORY_NETWORK,
+                       "The kernel does not support multishot recv with io_uring. "
+                       "Using the default TCP network layer.");
+        return UA_ServerNetworkLayerTCP(conf, port, logger);
+    }
+
+    UA_ServerNetworkLayer nl;
+    memset(&nl, 0, sizeof(UA_ServerNetworkLayer));
+    nl.start = ServerNetworkLayerIoUring_start;
+    nl.listen = ServerNetworkLayerIoUring_listen;
+    nl.stop = ServerNetworkLayerIoUring_stop;
+    nl.deleteMembers = ServerNetworkLayerIoUring_deleteMembers;
+
+    ServerNetworkLayerIoUring *layer = (ServerNetworkLayerIoUring*)
+        UA_calloc(1, sizeof(ServerNetworkLayerIoUring));
+    if(!layer)
+        return nl;
+    nl.handle = layer;
+
+    layer->tcp.logger = logger;
+    layer->tcp.conf = conf;
+    layer->tcp.port = port;
+#ifdef UA_ENABLE_EPOLL
+    layer->tcp.epollfd = -1;
+#endif
+    BufferPool_init(&layer->tcp.pool, UA_ServerNetworkLayerTCP_maxPooledBuffers);
+    layer->ring.fd = -1;
     return nl;
 }
 
+#endif /* UA_ENABLE_IO_URING */
+
 /***************************/
 /* Client NetworkLayer TCP */
 /***************************/
@@ -40142,7 +43531,11 @@ UA_DateTime UA_DateTime_nowMonotonic(void) {
 # define ANSI_COLOR_RESET   "\x1b[0m"
 #endif
 
-#ifdef UA_ENABLE_MULTITHREADING
+/* The application may run several servers in their own threads, also without
+ * UA_ENABLE_MULTITHREADING. Serialize the output and the (not thread-safe)
+ * timezone lookup of mktime. */
+#if defined(UA_ENABLE_MULTITHREADING) || !defined(_WIN32)
+# define UA_LOG_STDOUT_LOCK
 #include <pthread.h>
 static pthread_mutex_t printf_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
@@ -40161,13 +43554,13 @@ __attribute__((__format__(__printf__, 3 , 0)))
 void
 UA_Log_Stdout(UA_LogLevel level, UA_LogCategory category,
               const char *msg, va_list args) {
-    UA_Int64 tOffset = UA_DateTime_localTimeUtcOffset();
-    UA_DateTimeStruct dts = UA_DateTime_toStruct(UA_DateTime_now() + tOffset);
-
-#ifdef UA_ENABLE_MULTITHREADING
+#ifdef UA_LOG_STDOUT_LOCK
     pthread_mutex_lock(&printf_mutex);
 #endif
 
+    UA_Int64 tOffset = UA_DateTime_localTimeUtcOffset();
+    UA_DateTimeStruct dts = UA_DateTime_toStruct(UA_DateTime_now() + tOffset);
+
     printf("[%04u-%02u-%02u %02u:%02u:%02u.%03u (UTC%+05d)] %s/%s" ANSI_COLOR_RESET "\t",
            dts.year, dts.month, dts.day, dts.hour, dts.min, dts.sec, dts.milliSec,
            (int)(tOffset / UA_DATETIME_SEC / 36), logLevelNames[level], logCategoryNames[category]);
@@ -40175,7 +43568,7 @@ UA_Log_Stdout(UA_LogLevel level, UA_LogCategory category,
     printf("\n");
     fflush(stdout);
 
-#ifdef UA_ENABLE_MULTITHREADING
+#ifdef UA_LOG_STDOUT_LOCK
     pthread_mutex_unlock(&printf_mutex);
 #endif
 }
@@ -40688,130 +44081,217 @@ UA_CertificateVerification_Trustlist(UA_CertificateVerification *cv,
 #define END_CRITSECT(NODEMAP)
 #endif
 
-/* The default Nodestore is simply a hash-map from NodeIds to Nodes. To find an
- * entry, iterate over candidate positions according to the NodeId hash.
+/* The default Nodestore is simply a hash-map from NodeIds to Nodes. It uses
+ * open addressing with linear probing and robin-hood displacement: on
+ * insertion, an entry that is farther away from its home position takes the
+ * slot of an entry that is closer to its own. This keeps probe sequences
+ * short and sorted by distance, so a search can stop as soon as it meets an
+ * entry that is closer to home than the searched one would be.
+ *
+ * The 32-bit hash of the NodeId is stored beside the entry pointer. Probing
+ * compares the hashes first and only dereferences the entry (to compare the
+ * full NodeId) when they match. Removal shifts the following entries of the
+ * probe sequence back by one slot, so no tombstones are needed.
  *
- * - Tombstone or non-matching NodeId: continue searching
- * - Matching NodeId: Return the entry
- * - NULL: Abort the search */
+ * - Empty slot or entry closer to home than the probe distance: Abort
+ * - Matching hash and NodeId: Return the entry
+ * - Otherwise: continue searching */
 
 typedef struct UA_NodeMapEntry {
     struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL) */
     UA_UInt16 refCount; /* How many consumers have a reference to the node? */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_Boolean removed; /* Hides the node of the namespace zero image */
     UA_Node node;
 } UA_NodeMapEntry;
 
+typedef struct {
+    UA_NodeMapEntry *entry; /* NULL for an empty slot */
+    UA_UInt32 nodeIdHash;
+} UA_NodeMapSlot;
+
 #define UA_NODEMAP_MINSIZE 64
-#define UA_NODEMAP_TOMBSTONE ((UA_NodeMapEntry*)0x01)
+
+/* Random numeric NodeIds are generated from this value on. Start at least with
+ * 50,000 to make sure we do not conflict with nodes from the spec. */
+#define UA_NODEMAP_FIRST_RANDOM_ID 50000
 
 typedef struct {
-    UA_NodeMapEntry **entries;
-    UA_UInt32 size;
+    UA_NodeMapSlot *slots;
+    UA_UInt32 size; /* Always a power of two */
+    UA_UInt32 sizeBits;
     UA_UInt32 count;
-    UA_UInt32 sizePrimeIndex;
+    UA_UInt32 nextRandomId;
+    UA_Boolean useNS0Image; /* Look up namespace zero in the shared image */
 #ifdef UA_ENABLE_MULTITHREADING
     pthread_mutex_t mutex; /* Protect access */
 #endif
 } UA_NodeMap;
 
+/* Namespace zero is the same for every server of the process. It is built
+ * only once and then shared read-only by the default nodestores, which keep
+ * only the nodes they changed or removed. Entries of the image are moved into
+ * one block: lookups touch less memory, and nodes of the image are recognized
+ * by their address. They are not reference counted, as the image outlives all
+ * nodestores using it. */
+typedef struct {
+    UA_NodeMap map;
+    UA_Byte *entries;
+    size_t entriesSize;
+} UA_NS0Image;
+
+#define UA_NS0IMAGE_ALIGNMENT 16
+
+UA_Boolean UA_Nodestore_default_shareNS0 = true;
+
+/* The application may create and delete servers in several threads, also
+ * without UA_ENABLE_MULTITHREADING. ns0Image and ns0ImageUsers are changed only
+ * with the lock held. The nodestores using the image read the pointer without
+ * the lock, it is published with release / acquire ordering. The image is
+ * deleted only after the last of them. */
+#ifdef _WIN32
+static SRWLOCK ns0ImageLock = SRWLOCK_INIT;
+# define LOCK_NS0IMAGE() AcquireSRWLockExclusive(&ns0ImageLock)
+# define UNLOCK_NS0IMAGE() ReleaseSRWLockExclusive(&ns0ImageLock)
+#else
+# include <pthread.h>
+static pthread_mutex_t ns0ImageLock = PTHREAD_MUTEX_INITIALIZER;
+# define LOCK_NS0IMAGE() pthread_mutex_lock(&ns0ImageLock)
+# define UNLOCK_NS0IMAGE() pthread_mutex_unlock(&ns0ImageLock)
+#endif
+
+static UA_NS0Image * volatile ns0Image;
+static size_t ns0ImageUsers; /* Nodestores created with useNS0Image */
+
+static UA_NS0Image *
+loadNS0Image(void) {
+#ifdef _MSC_VER /* Visual Studio */
+    UA_NS0Image *image = ns0Image;
+    MemoryBarrier();
+    return image;
+#else /* GCC/Clang */
+    return __atomic_load_n(&ns0Image, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/* Only with the lock held */
+static void
+storeNS0Image(UA_NS0Image *image) {
+#ifdef _MSC_VER /* Visual Studio */
+    MemoryBarrier();
+    ns0Image = image;
+#else /* GCC/Clang */
+    __atomic_store_n(&ns0Image, image, __ATOMIC_RELEASE);
+#endif
+}
+
 /*********************/
 /* HashMap Utilities */
 /*********************/
 
-/* The size of the hash-map is always a prime number. They are chosen to be
- * close to the next power of 2. So the size ca. doubles with each prime. */
-static UA_UInt32 const primes[] = {
-    7,         13,         31,         61,         127,         251,
-    509,       1021,       2039,       4093,       8191,        16381,
-    32749,     65521,      131071,     262139,     524287,      1048573,
-    2097143,   4194301,    8388593,    16777213,   33554393,    67108859,
-    134217689, 268435399,  536870909,  1073741789, 2147483647,  4294967291
-};
-
-static UA_UInt32 mod(UA_UInt32 h, UA_UInt32 size) { return h % size; }
-static UA_UInt32 mod2(UA_UInt32 h, UA_UInt32 size) { return 1 + (h % (size - 2)); }
+/* Fibonacci hashing spreads the NodeId hash over the power-of-two table. The
+ * numeric NodeId hash is small for the small identifiers of namespace zero, so
+ * its lower bits alone would fill only part of the table. */
+static UA_UInt32
+homeIndex(const UA_NodeMap *ns, UA_UInt32 h) {
+    return (UA_UInt32)((h * UINT32_C(2654435769)) >> (32 - ns->sizeBits));
+}
 
-static UA_UInt16
-higher_prime_index(UA_UInt32 n) {
-    UA_UInt16 low  = 0;
-    UA_UInt16 high = (UA_UInt16)(sizeof(primes) / sizeof(UA_UInt32));
-    while(low != high) {
-        UA_UInt16 mid = (UA_UInt16)(low + ((high - low) / 2));
-        if(n > primes[mid])
-            low = (UA_UInt16)(mid + 1);
-        else
-            high = mid;
+/* Distance of the slot at idx from the home position of its entry */
+static UA_UInt32
+probeDistance(const UA_NodeMap *ns, UA_UInt32 idx) {
+    return (idx - homeIndex(ns, ns->slots[idx].nodeIdHash)) & (ns->size - 1);
+}
+
+/* Find the slot with the NodeId, h is the hash of the NodeId */
+static UA_NodeMapSlot *
+findSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid, UA_UInt32 h) {
+    UA_UInt32 mask = ns->size - 1;
+    UA_UInt32 idx = homeIndex(ns, h);
+    for(UA_UInt32 dist = 0; dist <= mask; ++dist) {
+        UA_NodeMapSlot *slot = &ns->slots[idx];
+        if(!slot->entry || probeDistance(ns, idx) < dist)
+            return NULL;
+        if(slot->nodeIdHash == h &&
+           UA_NodeId_equal(&slot->entry->node.nodeId, nodeid))
+            return slot;
+        idx = (idx + 1) & mask;
     }
-    return low;
+    return NULL;
 }
 
-/* returns an empty slot or null if the nodeid exists or if no empty slot is found. */
-static UA_NodeMapEntry **
-findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_NodeMapEntry **retval = NULL;
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
-    UA_UInt64 idx = mod(h, size); // use 64 bit container to avoid overflow
-    UA_UInt32 startIdx = (UA_UInt32)idx;
-    UA_UInt32 hash2 = mod2(h, size);
-    UA_NodeMapEntry *entry = NULL;
-
-    do {
-        entry = ns->entries[(UA_UInt32)idx];
-        if(entry > UA_NODEMAP_TOMBSTONE &&
-           UA_NodeId_equal(&entry->node.nodeId, nodeid))
-            return NULL;
-        if(!retval && entry <= UA_NODEMAP_TOMBSTONE)
-            retval = &ns->entries[(UA_UInt32)idx];
-        idx += hash2;
-        if(idx >= size)
-            idx -= size;
-    } while((UA_UInt32)idx != startIdx && entry);
-
-    /* NULL is returned if there is no free slot (idx == startIdx).
-     * Otherwise the first free slot is returned after we are sure,
-     * that the node id cannot be found in the used hashmap (!entry). */
-    return retval;
+static UA_NodeMapSlot *
+findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
+    return findSlot(ns, nodeid, UA_NodeId_hash(nodeid));
+}
+
+/* Insert an entry that is known not to be in the map. The table must have a
+ * free slot. Returns the slot where the entry was placed. */
+static UA_NodeMapSlot *
+insertEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry, UA_UInt32 h) {
+    UA_NodeMapSlot *placed = NULL;
+    UA_NodeMapSlot carry;
+    carry.entry = entry;
+    carry.nodeIdHash = h;
+    UA_UInt32 mask = ns->size - 1;
+    UA_UInt32 idx = homeIndex(ns, h);
+    UA_UInt32 dist = 0;
+    while(true) {
+        UA_NodeMapSlot *slot = &ns->slots[idx];
+        if(!slot->entry) {
+            *slot = carry;
+            return placed ? placed : slot;
+        }
+        /* Take the slot from an entry that is closer to its home position and
+         * continue with placing that entry */
+        UA_UInt32 slotDist = probeDistance(ns, idx);
+        if(slotDist < dist) {
+            UA_NodeMapSlot displaced = *slot;
+            *slot = carry;
+            carry = displaced;
+            dist = slotDist;
+            if(!placed)
+                placed = slot;
+        }
+        idx = (idx + 1) & mask;
+        ++dist;
+    }
 }
 
-/* The occupancy of the table after the call will be about 50% */
+/* Rebuild the table with about 50% occupancy */
 static UA_StatusCode
 expand(UA_NodeMap *ns) {
     UA_UInt32 osize = ns->size;
     UA_UInt32 count = ns->count;
-    /* Resize only when table after removal of unused elements is either too
-       full or too empty */
+    /* Resize only when table is either too full or too empty */
     if(count * 2 < osize && (count * 8 > osize || osize <= UA_NODEMAP_MINSIZE))
         return UA_STATUSCODE_GOOD;
 
-    UA_NodeMapEntry **oentries = ns->entries;
-    UA_UInt32 nindex = higher_prime_index(count * 2);
-    UA_UInt32 nsize = primes[nindex];
-    UA_NodeMapEntry **nentries = (UA_NodeMapEntry **)UA_calloc(nsize, sizeof(UA_NodeMapEntry*));
-    if(!nentries)
+    UA_UInt32 nbits = 6; /* UA_NODEMAP_MINSIZE */
+    while(nbits < 31 && ((UA_UInt32)1 << nbits) < count * 2)
+        ++nbits;
+    UA_UInt32 nsize = (UA_UInt32)1 << nbits;
+    UA_NodeMapSlot *nslots = (UA_NodeMapSlot*)UA_calloc(nsize, sizeof(UA_NodeMapSlot));
+    if(!nslots)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    ns->entries = nentries;
+    UA_NodeMapSlot *oslots = ns->slots;
+    ns->slots = nslots;
     ns->size = nsize;
-    ns->sizePrimeIndex = nindex;
+    ns->sizeBits = nbits;
 
-    /* recompute the position of every entry and insert the pointer */
-    for(size_t i = 0, j = 0; i < osize && j < count; ++i) {
-        if(oentries[i] <= UA_NODEMAP_TOMBSTONE)
-            continue;
-        UA_NodeMapEntry **e = findFreeSlot(ns, &oentries[i]->node.nodeId);
-        UA_assert(e);
-        *e = oentries[i];
-        ++j;
+    /* Reinsert every entry with the cached hash */
+    for(UA_UInt32 i = 0; i < osize; ++i) {
+        if(oslots[i].entry)
+            insertEntry(ns, oslots[i].entry, oslots[i].nodeIdHash);
     }
 
-    UA_free(oentries);
+    UA_free(oslots);
     return UA_STATUSCODE_GOOD;
 }
 
-static UA_NodeMapEntry *
-newEntry(UA_NodeClass nodeClass) {
+static size_t
+entrySize(UA_NodeClass nodeClass) {
     size_t size = sizeof(UA_NodeMapEntry) - sizeof(UA_Node);
     switch(nodeClass) {
     case UA_NODECLASS_OBJECT:
@@ -40839,8 +44319,16 @@ newEntry(UA_NodeClass nodeClass) {
         size += sizeof(UA_ViewNode);
         break;
     default:
-        return NULL;
+        return 0;
     }
+    return size;
+}
+
+static UA_NodeMapEntry *
+newEntry(UA_NodeClass nodeClass) {
+    size_t size = entrySize(nodeClass);
+    if(size == 0)
+        return NULL;
     UA_NodeMapEntry *entry = (UA_NodeMapEntry*)UA_calloc(1, size);
     if(!entry)
         return NULL;
@@ -40861,40 +44349,88 @@ cleanupEntry(UA_NodeMapEntry *entry) {
 }
 
 static UA_StatusCode
-clearSlot(UA_NodeMap *ns, UA_NodeMapEntry **slot) {
-    (*slot)->deleted = true;
-    cleanupEntry(*slot);
-    *slot = UA_NODEMAP_TOMBSTONE;
+clearSlot(UA_NodeMap *ns, UA_NodeMapSlot *slot) {
+    slot->entry->deleted = true;
+    cleanupEntry(slot->entry);
+
+    /* Backward shift deletion: move the following entries of the probe
+     * sequence one slot closer to their home position */
+    UA_UInt32 mask = ns->size - 1;
+    UA_UInt32 idx = (UA_UInt32)(slot - ns->slots);
+    UA_UInt32 next = (idx + 1) & mask;
+    while(ns->slots[next].entry && probeDistance(ns, next) > 0) {
+        ns->slots[idx] = ns->slots[next];
+        idx = next;
+        next = (next + 1) & mask;
+    }
+    ns->slots[idx].entry = NULL;
+    ns->slots[idx].nodeIdHash = 0;
+
     --ns->count;
     /* Downsize the hashmap if it is very empty */
-    if(ns->count * 8 < ns->size && ns->size > 32)
+    if(ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
         expand(ns); /* Can fail. Just continue with the bigger hashmap. */
     return UA_STATUSCODE_GOOD;
 }
 
-static UA_NodeMapEntry **
-findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
-    UA_UInt64 idx = mod(h, size); // use 64 bit container to avoid overflow
-    UA_UInt32 hash2 = mod2(h, size);
-    UA_UInt32 startIdx = (UA_UInt32)idx;
-    UA_NodeMapEntry *entry = NULL;
+/* Insert an entry that is known not to be in the map, growing the table if
+ * needed */
+static UA_StatusCode
+addEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    if(ns->size * 3 <= (ns->count + 1) * 4) {
+        if(expand(ns) != UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    insertEntry(ns, entry, UA_NodeId_hash(&entry->node.nodeId));
+    ++ns->count;
+    return UA_STATUSCODE_GOOD;
+}
 
-    do {
-        entry = ns->entries[(UA_UInt32)idx];
-        if(entry > UA_NODEMAP_TOMBSTONE &&
-           UA_NodeId_equal(&entry->node.nodeId, nodeid))
-            return &ns->entries[(UA_UInt32)idx];
-        idx += hash2;
-        if(idx >= size)
-            idx -= size;
-    } while((UA_UInt32)idx != startIdx && entry);
-
-    /* NULL is returned if there is no free slot (idx == startIdx)
-     * and the node id is not found or if the end of the used slots (!entry)
-     * is reached. */
-    return NULL;
+/************************/
+/* Namespace Zero Image */
+/************************/
+
+/* Without the lock, only for nodestores using the image */
+static UA_Boolean
+isSharedEntry(const UA_NodeMapEntry *entry) {
+    const UA_NS0Image *image = loadNS0Image();
+    if(!image)
+        return false;
+    uintptr_t begin = (uintptr_t)image->entries;
+    return (uintptr_t)entry >= begin &&
+        (uintptr_t)entry < begin + image->entriesSize;
+}
+
+/* The entry of the image for a NodeId not found in the nodestore itself */
+static UA_NodeMapEntry *
+findSharedEntry(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
+    if(!ns->useNS0Image || nodeid->namespaceIndex != 0)
+        return NULL;
+    const UA_NS0Image *image = loadNS0Image();
+    if(!image)
+        return NULL;
+    UA_NodeMapSlot *slot = findOccupiedSlot(&image->map, nodeid);
+    return slot ? slot->entry : NULL;
+}
+
+/* Only with the lock held */
+static void
+deleteNS0Image(void) {
+    UA_NS0Image *image = ns0Image;
+    storeNS0Image(NULL);
+    UA_NodeMap *map = &image->map;
+    for(UA_UInt32 i = 0; i < map->size; ++i) {
+        if(map->slots[i].entry)
+            UA_Node_deleteMembers(&map->slots[i].entry->node);
+    }
+    UA_free(map->slots);
+    UA_free(image->entries);
+    UA_free(image);
+}
+
+UA_Boolean
+UA_Nodestore_default_hasNS0Image(void) {
+    return loadNS0Image() != NULL;
 }
 
 /***********************/
@@ -40925,25 +44461,30 @@ static const UA_Node *
 UA_NodeMap_getNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     BEGIN_CRITSECT(ns);
-    UA_NodeMapEntry **entry = findOccupiedSlot(ns, nodeid);
-    if(!entry) {
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
+    if(!slot) {
+        UA_NodeMapEntry *shared = findSharedEntry(ns, nodeid);
+        END_CRITSECT(ns);
+        return shared ? (const UA_Node*)&shared->node : NULL;
+    }
+    if(slot->entry->removed) {
         END_CRITSECT(ns);
         return NULL;
     }
-    ++(*entry)->refCount;
+    ++slot->entry->refCount;
     END_CRITSECT(ns);
-    return (const UA_Node*)&(*entry)->node;
+    return (const UA_Node*)&slot->entry->node;
 }
 
 static void
 UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
     if (!node)
         return;
-#ifdef UA_ENABLE_MULTITHREADING
     UA_NodeMap *ns = (UA_NodeMap*)context;
-#endif
-    BEGIN_CRITSECT(ns);
     UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
+    if(ns->useNS0Image && isSharedEntry(entry))
+        return;
+    BEGIN_CRITSECT(ns);
     UA_assert(&entry->node == node);
     UA_assert(entry->refCount > 0);
     --entry->refCount;
@@ -40956,12 +44497,12 @@ UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
                        UA_Node **outNode) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     BEGIN_CRITSECT(ns);
-    UA_NodeMapEntry **slot = findOccupiedSlot(ns, nodeid);
-    if(!slot) {
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
+    UA_NodeMapEntry *entry = slot ? slot->entry : findSharedEntry(ns, nodeid);
+    if(!entry || entry->removed) {
         END_CRITSECT(ns);
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
-    UA_NodeMapEntry *entry = *slot;
     UA_NodeMapEntry *newItem = newEntry(entry->node.nodeClass);
     if(!newItem) {
         END_CRITSECT(ns);
@@ -40982,12 +44523,34 @@ static UA_StatusCode
 UA_NodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     BEGIN_CRITSECT(ns);
-    UA_NodeMapEntry **slot = findOccupiedSlot(ns, nodeid);
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
+    UA_NodeMapEntry *shared = findSharedEntry(ns, nodeid);
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    if(slot)
-        retval = clearSlot(ns, slot);
-    else
+    if((!slot && !shared) || (slot && slot->entry->removed)) {
         retval = UA_STATUSCODE_BADNODEIDUNKNOWN;
+    } else if(!shared) {
+        retval = clearSlot(ns, slot);
+    } else {
+        /* The node of the image stays, an entry marked as removed takes the
+         * place of the node in this nodestore */
+        UA_NodeMapEntry *marker = newEntry(shared->node.nodeClass);
+        if(marker)
+            retval = UA_NodeId_copy(nodeid, &marker->node.nodeId);
+        else
+            retval = UA_STATUSCODE_BADOUTOFMEMORY;
+        if(retval == UA_STATUSCODE_GOOD) {
+            marker->removed = true;
+            if(slot) {
+                slot->entry->deleted = true;
+                cleanupEntry(slot->entry);
+                slot->entry = marker;
+            } else {
+                retval = addEntry(ns, marker);
+            }
+        }
+        if(retval != UA_STATUSCODE_GOOD && marker)
+            deleteEntry(marker);
+    }
     END_CRITSECT(ns);
     return retval;
 }
@@ -40997,84 +44560,99 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
                       UA_NodeId *addedNodeId) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     BEGIN_CRITSECT(ns);
-    if(ns->size * 3 <= ns->count * 4) {
+    if(ns->size * 3 <= (ns->count + 1) * 4) {
         if(expand(ns) != UA_STATUSCODE_GOOD) {
             END_CRITSECT(ns);
             return UA_STATUSCODE_BADINTERNALERROR;
         }
     }
 
-    UA_NodeMapEntry **slot;
+    /* Hash the NodeId only once for the lookup and the insertion */
+    UA_UInt32 h = UA_NodeId_hash(&node->nodeId);
+    UA_NodeMapSlot *removedSlot = NULL;
     if(node->nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
             node->nodeId.identifier.numeric == 0) {
         /* create a random nodeid */
-        /* start at least with 50,000 to make sure we don not conflict with nodes from the spec */
-        /* if we find a conflict, we just try another identifier until we have tried all possible identifiers */
-        /* since the size is prime and we don't change the increase val, we will reach the starting id again */
         /* E.g. adding a nodeset will create children while there are still other nodes which need to be created */
-        /* Thus the node ids may collide */
-        UA_UInt32 size = ns->size;
-        UA_UInt64 identifier = mod(50000 + size+1, size); // start value, use 64 bit container to avoid overflow
-        UA_UInt32 increase = mod2(ns->count+1, size);
-        UA_UInt32 startId = (UA_UInt32)identifier; // mod ensures us that the id is a valid 32 bit
-
+        /* Thus the node ids may collide, we just try the next identifier until we find a free one */
+        /* At most count + 1 identifiers have to be tried */
+        UA_UInt32 identifier = ns->nextRandomId;
         do {
-            node->nodeId.identifier.numeric = (UA_UInt32)identifier;
-            slot = findFreeSlot(ns, &node->nodeId);
-            if(slot)
-                break;
-            identifier += increase;
-            if(identifier >= size)
-                identifier -= size;
-        } while((UA_UInt32)identifier != startId);
-        
-        if (!slot) {
-            END_CRITSECT(ns);
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        }
+            if(identifier < UA_NODEMAP_FIRST_RANDOM_ID)
+                identifier = UA_NODEMAP_FIRST_RANDOM_ID;
+            node->nodeId.identifier.numeric = identifier++;
+            h = UA_NodeId_hash(&node->nodeId);
+        } while(findSlot(ns, &node->nodeId, h) ||
+                findSharedEntry(ns, &node->nodeId));
+        ns->nextRandomId = identifier;
     } else {
-        slot = findFreeSlot(ns, &node->nodeId);
-        if(!slot) {
+        UA_NodeMapSlot *slot = findSlot(ns, &node->nodeId, h);
+        if(slot && slot->entry->removed) {
+            /* Add the node again that was removed from the image */
+            removedSlot = slot;
+        } else if(slot || findSharedEntry(ns, &node->nodeId)) {
             deleteEntry(container_of(node, UA_NodeMapEntry, node));
             END_CRITSECT(ns);
             return UA_STATUSCODE_BADNODEIDEXISTS;
         }
     }
 
-    *slot = container_of(node, UA_NodeMapEntry, node);
-    ++ns->count;
-    UA_assert(&(*slot)->node == node);
-
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
     if(addedNodeId) {
-        retval = UA_NodeId_copy(&node->nodeId, addedNodeId);
-        if(retval != UA_STATUSCODE_GOOD)
-            clearSlot(ns, slot);
+        UA_StatusCode retval = UA_NodeId_copy(&node->nodeId, addedNodeId);
+        if(retval != UA_STATUSCODE_GOOD) {
+            deleteEntry(container_of(node, UA_NodeMapEntry, node));
+            END_CRITSECT(ns);
+            return retval;
+        }
+    }
+
+    if(removedSlot) {
+        deleteEntry(removedSlot->entry);
+        removedSlot->entry = container_of(node, UA_NodeMapEntry, node);
+    } else {
+        insertEntry(ns, container_of(node, UA_NodeMapEntry, node), h);
+        ++ns->count;
     }
 
     END_CRITSECT(ns);
-    return retval;
+    return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode
 UA_NodeMap_replaceNode(void *context, UA_Node *node) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     BEGIN_CRITSECT(ns);
-    UA_NodeMapEntry **slot = findOccupiedSlot(ns, &node->nodeId);
+    UA_NodeMapEntry *newEntryContainer = container_of(node, UA_NodeMapEntry, node);
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns, &node->nodeId);
     if(!slot) {
+        /* The first change of a node of the image, the copy is kept in this
+         * nodestore */
+        UA_NodeMapEntry *shared = findSharedEntry(ns, &node->nodeId);
+        if(!shared) {
+            END_CRITSECT(ns);
+            return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        }
+        UA_StatusCode retval = UA_STATUSCODE_BADINTERNALERROR;
+        if(shared == newEntryContainer->orig)
+            retval = addEntry(ns, newEntryContainer);
+        if(retval != UA_STATUSCODE_GOOD)
+            deleteEntry(newEntryContainer);
+        END_CRITSECT(ns);
+        return retval;
+    }
+    if(slot->entry->removed) {
         END_CRITSECT(ns);
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
-    UA_NodeMapEntry *newEntryContainer = container_of(node, UA_NodeMapEntry, node);
-    if(*slot != newEntryContainer->orig) {
+    if(slot->entry != newEntryContainer->orig) {
         /* The node was updated since the copy was made */
         deleteEntry(newEntryContainer);
         END_CRITSECT(ns);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
-    (*slot)->deleted = true;
-    cleanupEntry(*slot);
-    *slot = newEntryContainer;
+    slot->entry->deleted = true;
+    cleanupEntry(slot->entry);
+    slot->entry = newEntryContainer;
     END_CRITSECT(ns);
     return UA_STATUSCODE_GOOD;
 }
@@ -41085,9 +44663,9 @@ UA_NodeMap_iterate(void *context, void *visitorContext,
     UA_NodeMap *ns = (UA_NodeMap*)context;
     BEGIN_CRITSECT(ns);
     for(UA_UInt32 i = 0; i < ns->size; ++i) {
-        if(ns->entries[i] > UA_NODEMAP_TOMBSTONE) {
+        if(ns->slots[i].entry && !ns->slots[i].entry->removed) {
             END_CRITSECT(ns);
-            UA_NodeMapEntry *entry = ns->entries[i];
+            UA_NodeMapEntry *entry = ns->slots[i].entry;
             entry->refCount++;
             visitor(visitorContext, &entry->node);
             entry->refCount--;
@@ -41095,6 +44673,19 @@ UA_NodeMap_iterate(void *context, void *visitorContext,
             BEGIN_CRITSECT(ns);
         }
     }
+    /* Nodes of the image that were neither changed nor removed */
+    const UA_NS0Image *ns0 = ns->useNS0Image ? loadNS0Image() : NULL;
+    if(ns0) {
+        const UA_NodeMap *image = &ns0->map;
+        for(UA_UInt32 i = 0; i < image->size; ++i) {
+            UA_NodeMapEntry *entry = image->slots[i].entry;
+            if(!entry || findSlot(ns, &entry->node.nodeId, image->slots[i].nodeIdHash))
+                continue;
+            END_CRITSECT(ns);
+            visitor(visitorContext, &entry->node);
+            BEGIN_CRITSECT(ns);
+        }
+    }
     END_CRITSECT(ns);
 }
 
@@ -41105,16 +44696,23 @@ UA_NodeMap_delete(void *context) {
     pthread_mutex_destroy(&ns->mutex);
 #endif
     UA_UInt32 size = ns->size;
-    UA_NodeMapEntry **entries = ns->entries;
+    UA_NodeMapSlot *slots = ns->slots;
     for(UA_UInt32 i = 0; i < size; ++i) {
-        if(entries[i] > UA_NODEMAP_TOMBSTONE) {
+        if(slots[i].entry) {
             /* On debugging builds, check that all nodes were release */
-            UA_assert(entries[i]->refCount == 0);
+            UA_assert(slots[i].entry->refCount == 0);
             /* Delete the node */
-            deleteEntry(entries[i]);
+            deleteEntry(slots[i].entry);
         }
     }
-    UA_free(ns->entries);
+    /* The image is deleted with the last nodestore using it */
+    if(ns->useNS0Image) {
+        LOCK_NS0IMAGE();
+        if(--ns0ImageUsers == 0 && ns0Image)
+            deleteNS0Image();
+        UNLOCK_NS0IMAGE();
+    }
+    UA_free(ns->slots);
     UA_free(ns);
 }
 
@@ -41124,15 +44722,22 @@ UA_Nodestore_default_new(UA_Nodestore *ns) {
     UA_NodeMap *nodemap = (UA_NodeMap*)UA_malloc(sizeof(UA_NodeMap));
     if(!nodemap)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    nodemap->sizePrimeIndex = higher_prime_index(UA_NODEMAP_MINSIZE);
-    nodemap->size = primes[nodemap->sizePrimeIndex];
+    nodemap->sizeBits = 6;
+    nodemap->size = UA_NODEMAP_MINSIZE;
     nodemap->count = 0;
-    nodemap->entries = (UA_NodeMapEntry**)
-        UA_calloc(nodemap->size, sizeof(UA_NodeMapEntry*));
-    if(!nodemap->entries) {
+    nodemap->nextRandomId = UA_NODEMAP_FIRST_RANDOM_ID;
+    nodemap->useNS0Image = UA_Nodestore_default_shareNS0;
+    nodemap->slots = (UA_NodeMapSlot*)
+        UA_calloc(nodemap->size, sizeof(UA_NodeMapSlot));
+    if(!nodemap->slots) {
         UA_free(nodemap);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
+    if(nodemap->useNS0Image) {
+        LOCK_NS0IMAGE();
+        ++ns0ImageUsers;
+        UNLOCK_NS0IMAGE();
+    }
 #ifdef UA_ENABLE_MULTITHREADING
     pthread_mutex_init(&nodemap->mutex, NULL);
 #endif
@@ -41150,7 +44755,91 @@ UA_Nodestore_default_new(UA_Nodestore *ns) {
     ns->replaceNode = UA_NodeMap_replaceNode;
     ns->removeNode = UA_NodeMap_removeNode;
     ns->iterate = UA_NodeMap_iterate;
+    ns->notifyBrowse = NULL;
+
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_Boolean
+UA_Nodestore_default_inNS0Image(const UA_Nodestore *ns, const UA_Node *node) {
+    const UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
+    if(ns->getNode == UA_NodeMap_getNode) {
+        /* A default nodestore using the image keeps it from being deleted */
+        return ((const UA_NodeMap*)ns->context)->useNS0Image && isSharedEntry(entry);
+    }
+
+    /* Another nodestore may hand out nodes of default nodestores that do not
+     * use the image */
+    LOCK_NS0IMAGE();
+    UA_Boolean shared = isSharedEntry(entry);
+    UNLOCK_NS0IMAGE();
+    return shared;
+}
+
+UA_StatusCode
+UA_Nodestore_default_setNS0Image(UA_Nodestore *ns) {
+    if(ns->getNode != UA_NodeMap_getNode)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    UA_NodeMap *nodemap = (UA_NodeMap*)ns->context;
+
+    /* Another server may have set the image in the meantime */
+    LOCK_NS0IMAGE();
+    if(ns0Image) {
+        UNLOCK_NS0IMAGE();
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Move the entries into one block */
+    size_t total = 0;
+    for(UA_UInt32 i = 0; i < nodemap->size; ++i) {
+        UA_NodeMapEntry *entry = nodemap->slots[i].entry;
+        if(!entry)
+            continue;
+        if(entry->refCount > 0 || entry->removed) {
+            UNLOCK_NS0IMAGE();
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        size_t size = entrySize(entry->node.nodeClass);
+        total += (size + UA_NS0IMAGE_ALIGNMENT - 1) & ~(size_t)(UA_NS0IMAGE_ALIGNMENT - 1);
+    }
+    UA_NS0Image *image = (UA_NS0Image*)UA_malloc(sizeof(UA_NS0Image));
+    UA_Byte *entries = (UA_Byte*)UA_malloc(total > 0 ? total : 1);
+    if(!image || !entries) {
+        UNLOCK_NS0IMAGE();
+        UA_free(image);
+        UA_free(entries);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    size_t pos = 0;
+    for(UA_UInt32 i = 0; i < nodemap->size; ++i) {
+        UA_NodeMapEntry *entry = nodemap->slots[i].entry;
+        if(!entry)
+            continue;
+        size_t size = entrySize(entry->node.nodeClass);
+        memcpy(&entries[pos], entry, size);
+        UA_free(entry);
+        nodemap->slots[i].entry = (UA_NodeMapEntry*)&entries[pos];
+        pos += (size + UA_NS0IMAGE_ALIGNMENT - 1) & ~(size_t)(UA_NS0IMAGE_ALIGNMENT - 1);
+    }
 
+    /* The nodemap becomes the map of the image */
+#ifdef UA_ENABLE_MULTITHREADING
+    pthread_mutex_destroy(&nodemap->mutex);
+#endif
+    image->map = *nodemap;
+    image->map.useNS0Image = false;
+    image->entries = entries;
+    image->entriesSize = total;
+    if(nodemap->useNS0Image)
+        --ns0ImageUsers;
+    UA_free(nodemap);
+    ns->context = NULL;
+    storeNS0Image(image);
+
+    /* No nodestore would use the image */
+    if(ns0ImageUsers == 0)
+        deleteNS0Image();
+    UNLOCK_NS0IMAGE();
     return UA_STATUSCODE_GOOD;
 }
 
@@ -41437,8 +45126,13 @@ addDefaultNetworkLayers(UA_ServerConfig *conf, UA_UInt16 portNumber) {
     if(!conf->networkLayers)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
+#ifdef UA_ENABLE_IO_URING
+    conf->networkLayers[0] =
+        UA_ServerNetworkLayerIoUring(UA_ConnectionConfig_default, portNumber, conf->logger);
+#else
     conf->networkLayers[0] =
         UA_ServerNetworkLayerTCP(UA_ConnectionConfig_default, portNumber, conf->logger);
+#endif
     if (!conf->networkLayers[0].handle)
         return UA_STATUSCODE_BADOUTOFMEMORY;
     conf->networkLayersSize = 1;
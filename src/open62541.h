@@ -52,6 +52,10 @@ extern "C" {
 /* Advanced Options */
 #define UA_ENABLE_STATUSCODE_DESCRIPTIONS
 #define UA_ENABLE_TYPENAMES
+/* #undef UA_ENABLE_FAST_NODEID_HASH */
+/* #undef UA_ENABLE_SPECIALISED_CODECS */
+/* #undef UA_ENABLE_EPOLL */
+/* #undef UA_ENABLE_IO_URING */
 /* #undef UA_ENABLE_DETERMINISTIC_RNG */
 /* #undef UA_ENABLE_NONSTANDARD_UDP */
 #define UA_ENABLE_DISCOVERY
@@ -73,6 +77,10 @@ extern "C" {
 
 extern int custom_port_number;
 extern const char* custom_endpoint_url;
+/* Set SO_REUSEPORT on the server sockets, so that several servers in the
+ * process can listen on the same port and the kernel spreads the incoming
+ * connections between them */
+extern int custom_reuse_port;
 
 /* Include stdint.h and stdbool.h or workaround for older Visual Studios */
 #if !defined(_MSC_VER) || _MSC_VER >= 1600
@@ -11202,6 +11210,18 @@ struct UA_ClientConfig;
  * Server Lifecycle
  * ---------------- */
 
+/* Requests are decoded into an arena of the server that is released in one
+ * step once the response was sent, instead of allocating and freeing every
+ * string and array of the request on its own. Up to this number of bytes is
+ * kept between requests, 0 decodes on the heap. Read in UA_Server_new. */
+extern size_t UA_Server_requestArenaSize;
+
+/* Browse results are made from descriptions of the reference targets kept by
+ * the server, instead of taking every target node from the nodestore. Up to
+ * this number of descriptions is kept, 0 disables the cache. Read in
+ * UA_Server_new. */
+extern size_t UA_Server_browseCacheSize;
+
 UA_Server UA_EXPORT * UA_Server_new(const UA_ServerConfig *config);
 void UA_EXPORT UA_Server_delete(UA_Server *server);
 
@@ -11863,6 +11883,31 @@ UA_StatusCode UA_EXPORT
 UA_Server_setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
                                      const UA_DataSource dataSource);
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+/* Sample the MonitoredItems on the value of the node right away.
+ *
+ * For a data source whose value only changes at known points in time, e.g.
+ * when new data has been received, the sampling interval of the
+ * MonitoredItems can be kept long by setting the MinimumSamplingInterval
+ * attribute of the node. The application then calls this function after the
+ * value has changed, so that the change is published without waiting for the
+ * next sample. Has to be called from the thread running the server. */
+void UA_EXPORT
+UA_Server_notifyValueChange(UA_Server *server, const UA_NodeId nodeId);
+
+/* Notifications queued within this number of milliseconds of each other are
+ * published together. A Subscription waits with its publish response until no
+ * notification was added during the window, for at most half of its
+ * publishing interval. 0 publishes at every publishing interval. */
+extern UA_Double UA_Subscription_batchWindow;
+
+/* Notifications and the messages kept for retransmission are allocated from
+ * pools of the server. Up to this number of each is kept for reuse, the pools
+ * grow to it on demand. 0 allocates every one on its own. Read in
+ * UA_Server_new. */
+extern size_t UA_Server_maxPooledNotifications;
+#endif
+
 /**
  * .. _value-callback:
  *
@@ -12476,6 +12521,18 @@ struct UA_Connection {
      * @return Returns an error code or UA_STATUSCODE_GOOD. */
     UA_StatusCode (*send)(UA_Connection *connection, UA_ByteString *buf);
 
+    /* Sends several chunks of a message at once. Optional, if NULL the chunks
+     * are sent one by one. Requires that getSendBuffer hands out a new buffer
+     * while earlier ones are not sent yet. The buffers are always freed, even
+     * if sending fails.
+     *
+     * @param connection The connection
+     * @param bufs The message buffers in the order of sending
+     * @param bufsSize The number of buffers
+     * @return Returns an error code or UA_STATUSCODE_GOOD. */
+    UA_StatusCode (*sendChunks)(UA_Connection *connection, UA_ByteString *bufs,
+                                size_t bufsSize);
+
     /* Receive a message from the remote connection
      *
      * @param connection The connection
@@ -13213,14 +13270,26 @@ extern "C" {
  * not known or not important. The ``nodeClass`` attribute is used to ensure the
  * correctness of casting from ``UA_Node`` to a specific node type. */
 
-/* List of reference targets with the same reference type and direction */
+/* List of reference targets with the same reference type and direction.
+ *
+ * Above UA_Node_referenceIndexThreshold targets, a hash index over the
+ * targets is built on demand, so that adding and deleting references does not
+ * scan all targets. The index holds the position in targetIds + 1 (zero for
+ * an empty bucket). Code that builds the targets array itself leaves the index
+ * at NULL. */
 typedef struct {
     UA_NodeId referenceTypeId;
     UA_Boolean isInverse;
     size_t targetIdsSize;
     UA_ExpandedNodeId *targetIds;
+    size_t targetIdsIndexSize;
+    size_t *targetIdsIndex;
 } UA_NodeReferenceKind;
 
+/* Number of targets of a reference kind above which the target index is used.
+ * Default is 64. */
+extern size_t UA_Node_referenceIndexThreshold;
+
 #define UA_NODE_BASEATTRIBUTES                  \
     UA_NodeId nodeId;                           \
     UA_NodeClass nodeClass;                     \
@@ -13624,6 +13693,11 @@ typedef struct {
     /* Execute a callback for every node in the nodestore. */
     void (*iterate)(void *nodestoreContext, void* visitorContext,
                     UA_NodestoreVisitor visitor);
+
+    /* Optional, can be NULL. Called once when a Browse starts at the node.
+     * Neither for the BrowseNext calls of the same browse nor for the nodes
+     * that are only described in the result. */
+    void (*notifyBrowse)(void *nodestoreContext, const UA_NodeId *nodeId);
 } UA_Nodestore;
 
 /**
@@ -15311,9 +15385,21 @@ extern "C" {
 #endif
 
 
+/* Send and receive buffers of the connections are reused by the server network
+ * layer. At most this number of buffers is kept for each size class (4 KiB to
+ * 64 KiB), 0 disables the pool. Read when the network layer is created. */
+extern size_t UA_ServerNetworkLayerTCP_maxPooledBuffers;
+
 UA_ServerNetworkLayer UA_EXPORT
 UA_ServerNetworkLayerTCP(UA_ConnectionConfig conf, UA_UInt16 port, UA_Logger logger);
 
+#ifdef UA_ENABLE_IO_URING
+/* TCP network layer using io_uring (Linux). Returns the default TCP network
+ * layer if the kernel does not support the required io_uring features. */
+UA_ServerNetworkLayer UA_EXPORT
+UA_ServerNetworkLayerIoUring(UA_ConnectionConfig conf, UA_UInt16 port, UA_Logger logger);
+#endif
+
 UA_Connection UA_EXPORT
 UA_ClientConnectionTCP(UA_ConnectionConfig conf, const char *endpointUrl, const UA_UInt32 timeout, UA_Logger logger);
 
@@ -15503,6 +15589,29 @@ extern "C" {
 UA_StatusCode UA_EXPORT
 UA_Nodestore_default_new(UA_Nodestore *ns);
 
+/* Namespace zero is built only once per process and shared read-only by the
+ * default nodestores created while this is set. A nodestore keeps its own copy
+ * of the nodes of namespace zero it changes. The image and its count of users
+ * are protected by a process-wide lock: default nodestores and servers can be
+ * created and deleted in several threads at the same time, also without
+ * UA_ENABLE_MULTITHREADING. The setting itself is read in
+ * UA_Nodestore_default_new and UA_Server_new without synchronization, change
+ * it only while no other thread creates a nodestore or server. */
+extern UA_Boolean UA_Nodestore_default_shareNS0;
+
+UA_Boolean UA_EXPORT
+UA_Nodestore_default_hasNS0Image(void);
+
+/* Turns the nodes of a default nodestore into the shared namespace zero image.
+ * On success, the nodestore is consumed and must not be deleted. */
+UA_StatusCode UA_EXPORT
+UA_Nodestore_default_setNS0Image(UA_Nodestore *ns);
+
+/* Nodes of the image must not be edited in place. The node is taken from the
+ * nodestore ns. */
+UA_Boolean UA_EXPORT
+UA_Nodestore_default_inNS0Image(const UA_Nodestore *ns, const UA_Node *node);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif